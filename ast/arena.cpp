@@ -0,0 +1,116 @@
+#include <new>
+#include <cstdlib>
+
+#include "statistics.h"
+#include "arena.h"
+
+namespace nel
+{
+    thread_local Arena* Arena::current = 0;
+
+    // Every allocation is rounded up to this, which suits any object.
+    static const size_t ALIGNMENT = 16;
+    // The size of the first chunk. Each chunk after that is twice the size of the last, up to the maximum.
+    static const size_t INITIAL_CHUNK_SIZE = 64 * 1024;
+    static const size_t MAX_CHUNK_SIZE = 1024 * 1024;
+
+    static size_t align(size_t size)
+    {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    Arena::Arena()
+        : next(0), limit(0), bytesAllocated(0)
+    {
+    }
+
+    Arena::~Arena()
+    {
+        for(size_t i = objects.size(); i > 0; i--)
+        {
+            ObjectHeader* header = objects[i - 1];
+            if(header->finalizer)
+            {
+                header->finalizer(header + 1);
+            }
+        }
+        for(size_t i = 0; i < chunks.size(); i++)
+        {
+            free(chunks[i].data);
+        }
+    }
+
+    void* Arena::allocateObject(size_t size, Finalizer finalizer)
+    {
+        static_assert(sizeof(ObjectHeader) % ALIGNMENT == 0, "object headers must keep objects aligned");
+
+        ObjectHeader* header;
+        if(current)
+        {
+            header = (ObjectHeader*) current->allocate(sizeof(ObjectHeader) + size);
+            header->finalizer = finalizer;
+            header->arena = current;
+            current->objects.push_back(header);
+        }
+        else
+        {
+            header = (ObjectHeader*) ::operator new(sizeof(ObjectHeader) + size);
+            header->finalizer = 0;
+            header->arena = 0;
+        }
+        return header + 1;
+    }
+
+    void Arena::releaseObject(void* object)
+    {
+        if(!object)
+        {
+            return;
+        }
+
+        ObjectHeader* header = (ObjectHeader*) object - 1;
+        if(header->arena)
+        {
+            // Already destroyed, so the arena mustn't do it again.
+            header->finalizer = 0;
+        }
+        else
+        {
+            ::operator delete(header);
+        }
+    }
+
+    void* Arena::allocate(size_t size)
+    {
+        size = align(size);
+        if(size > (size_t) (limit - next))
+        {
+            size_t chunkSize = chunks.empty() ? INITIAL_CHUNK_SIZE : chunks.back().size * 2;
+            if(chunkSize > MAX_CHUNK_SIZE)
+            {
+                chunkSize = MAX_CHUNK_SIZE;
+            }
+            if(chunkSize < size)
+            {
+                chunkSize = size;
+            }
+
+            Chunk chunk;
+            chunk.data = (char*) malloc(chunkSize);
+            if(!chunk.data)
+            {
+                throw std::bad_alloc();
+            }
+            chunk.size = chunkSize;
+            chunks.push_back(chunk);
+            next = chunk.data;
+            limit = chunk.data + chunkSize;
+        }
+
+        void* p = next;
+        next += size;
+        bytesAllocated += size;
+        Statistics::count(Statistics::ARENA_BYTES, size);
+        return p;
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace nel
+{
+    /**
+     * A bump allocator that owns everything allocated from it, and releases
+     * it all at once when it's destroyed. Each compilation has one, holding
+     * its AST nodes, their lists and its definitions, so none of them need
+     * freeing one at a time, and nodes thrown away by a failed parse
+     * are cleaned up along with the rest.
+     *
+     * Objects are allocated with a finalizer, which the arena calls in reverse
+     * order of allocation when it's destroyed. An object deleted before then
+     * is only destroyed, and its memory is reclaimed along with the arena.
+     * Objects own none of the other objects in the arena, so they may be
+     * finalized in any order.
+     *
+     * Allocations go to the calling thread's current arena. When there isn't one,
+     * objects come from the heap instead, and have to be deleted as usual.
+     */
+    class Arena
+    {
+        public:
+            /**
+             * Destroys an object allocated from an arena, without freeing its memory.
+             */
+            typedef void (*Finalizer)(void* object);
+
+        private:
+            /**
+             * Stored right before every object.
+             */
+            struct alignas(16) ObjectHeader
+            {
+                // Destroys the object, or 0 if it was deleted already.
+                Finalizer finalizer;
+                // The arena the object lives in, or 0 if it lives on the heap.
+                Arena* arena;
+            };
+
+            struct Chunk
+            {
+                char* data;
+                size_t size;
+            };
+
+            // The arena of the calling thread, or 0 if it has none.
+            static thread_local Arena* current;
+
+            std::vector<Chunk> chunks;
+            // The unused part of the last chunk.
+            char* next;
+            char* limit;
+            // Every object allocated with a finalizer, in order of allocation.
+            std::vector<ObjectHeader*> objects;
+            size_t bytesAllocated;
+
+            // Not copyable.
+            Arena(const Arena&);
+            Arena& operator=(const Arena&);
+
+        public:
+            Arena();
+            ~Arena();
+
+            /**
+             * Returns the arena that the calling thread allocates from, or 0 if none.
+             */
+            static Arena* getCurrent()
+            {
+                return current;
+            }
+
+            /**
+             * Sets the arena that the calling thread allocates from.
+             */
+            static void setCurrent(Arena* arena)
+            {
+                current = arena;
+            }
+
+            /**
+             * Allocates memory for an object from the current arena,
+             * to be destroyed by the given finalizer along with the arena.
+             */
+            static void* allocateObject(size_t size, Finalizer finalizer);
+
+            /**
+             * Releases an object allocated by allocateObject(), once its destructor has run.
+             */
+            static void releaseObject(void* object);
+
+            /**
+             * Allocates raw memory, suitably aligned for any object.
+             * It stays valid until the arena is destroyed.
+             */
+            void* allocate(size_t size);
+
+            /**
+             * Returns the total number of bytes handed out by this arena.
+             */
+            size_t getBytesAllocated()
+            {
+                return bytesAllocated;
+            }
+    };
+
+    /**
+     * A standard allocator which takes its memory from an arena,
+     * or the heap when given no arena. Memory from an arena is never
+     * given back, so containers using this should stay small,
+     * or be filled in one go.
+     */
+    template <typename T>
+    class ArenaAllocator
+    {
+        public:
+            typedef T value_type;
+
+            Arena* arena;
+
+            ArenaAllocator(Arena* arena)
+                : arena(arena)
+            {
+            }
+
+            template <typename U>
+            ArenaAllocator(const ArenaAllocator<U>& other)
+                : arena(other.arena)
+            {
+            }
+
+            T* allocate(size_t count)
+            {
+                size_t size = count * sizeof(T);
+                return (T*) (arena ? arena->allocate(size) : ::operator new(size));
+            }
+
+            void deallocate(T* p, size_t count)
+            {
+                if(!arena)
+                {
+                    ::operator delete(p);
+                }
+            }
+
+            template <typename U>
+            bool operator==(const ArenaAllocator<U>& other) const
+            {
+                return arena == other.arena;
+            }
+
+            template <typename U>
+            bool operator!=(const ArenaAllocator<U>& other) const
+            {
+                return arena != other.arena;
+            }
+    };
+}
@@ -7,9 +7,9 @@
 
 namespace nel
 {
-    Argument::ArgumentType Argument::resolveUnprefixedBuiltinType(const std::string& name)
+    Argument::ArgumentType Argument::resolveUnprefixedBuiltinType(CompilationContext& context, SymbolId name)
     {
-        Definition* definition = SymbolTable::getBuiltins()->tryGet(name);
+        Definition* definition = context.getBuiltins()->tryGet(name);
         
         if(definition)
         {
@@ -42,9 +42,9 @@ namespace nel
         return INVALID;
     }
     
-    Argument::ArgumentType Argument::resolveConditionType(const std::string& name)
+    Argument::ArgumentType Argument::resolveConditionType(CompilationContext& context, SymbolId name)
     {
-        Definition* definition = SymbolTable::getBuiltins()->tryGet(name);
+        Definition* definition = context.getBuiltins()->tryGet(name);
         
         if(definition)
         {
@@ -67,9 +67,9 @@ namespace nel
         return INVALID;
     }
     
-    Argument::ArgumentType Argument::resolveIndexedType(const std::string& index)
+    Argument::ArgumentType Argument::resolveIndexedType(CompilationContext& context, SymbolId index)
     {
-        Definition* definition = SymbolTable::getBuiltins()->tryGet(index);
+        Definition* definition = context.getBuiltins()->tryGet(index);
         
         if(definition)
         {
@@ -95,27 +95,30 @@ namespace nel
     {
     }
     
-    Argument::~Argument()
+    void Argument::resolve(CompilationContext& context)
     {
-        delete expression;
+        if(expression)
+        {
+            expression->resolve(context);
+        }
     }
     
-    void Argument::checkForZeroPage()
+    void Argument::checkForZeroPage(CompilationContext& context)
     {
         // Check if the expression uses defined symbols, and if possible can be used in zero-page addressing.
         // If the value is defined but unknown at this pass, assume it won't fit in zero page and don't error.
-        if(expression && expression->fold(false, true))
+        if(expression && expression->fold(context, false, true))
         {
             zeroPage = expression->getFoldedValue() < 256;
         }
     }
     
-    void Argument::write(RomBank* bank)
+    void Argument::write(CompilationContext& context, RomBank* bank)
     {
         // Only write data if there is an expression.
         if(expression)
         {
-            if(expression->fold(true, true))
+            if(expression->fold(context, true, true))
             {
                 if(zeroPage)
                 {
@@ -129,17 +132,17 @@ namespace nel
             }
             else
             {
-                error("argument has indeterminate value", getSourcePosition());
+                error(context, "argument has indeterminate value", getSourcePosition());
             }
         }
     }
     
-    void Argument::writeRelativeByte(RomBank* bank)
+    void Argument::writeRelativeByte(CompilationContext& context, RomBank* bank)
     {
         // Only write data if there is an expression.
         if(expression)
         {
-            if(expression->fold(true, true))
+            if(expression->fold(context, true, true))
             {
                 // offset is amount to add to the PC to get the label position.
                 int offset = (int) expression->getFoldedValue() - ((int) bank->getProgramCounter() + 1);
@@ -155,12 +158,12 @@ namespace nel
                     os << "relative jump is outside of range -127..128 bytes. rewrite the branch or shorten the gaps in your code.";
                     os << "(pc = " << bank->getProgramCounter() << ", label = " << expression->getFoldedValue() <<
                         ", pc - label = " << offset << ")";
-                    error(os.str(), getSourcePosition());
+                    error(context, os.str(), getSourcePosition());
                 }
             }
             else
             {
-                error("argument has indeterminate value", getSourcePosition());
+                error(context, "argument has indeterminate value", getSourcePosition());
             }
         }
     }
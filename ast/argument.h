@@ -3,6 +3,8 @@
 #include "node.h"
 #include "rom_bank.h"
 #include "expression.h"
+#include "symbol_pool.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -48,18 +50,18 @@ namespace nel
              * Gets the argument type of an unprefixed term, which must be a register or p-flag.
              * Returns the argument type associated with the name if it is a built-in, and INVALID otherwise.
              */
-            static ArgumentType resolveUnprefixedBuiltinType(const std::string& name);
+            static ArgumentType resolveUnprefixedBuiltinType(CompilationContext& context, SymbolId name);
             
             /**
              * Gets the argument type of a p-flag. Returns a p-flag argument type if valid, or INVALID if not a p-flag.
              */
-            static ArgumentType resolveConditionType(const std::string& name);
+            static ArgumentType resolveConditionType(CompilationContext& context, SymbolId name);
             
             /**
              * Gets the ArgumentType of a register involved in a direct memory indexing operation.
              * Returns X, Y, or INVALID.
              */
-            static ArgumentType resolveIndexedType(const std::string& index);
+            static ArgumentType resolveIndexedType(CompilationContext& context, SymbolId index);
         private:
             ArgumentType argumentType;
             Expression* expression;
@@ -68,7 +70,6 @@ namespace nel
         public:
             Argument(ArgumentType argumentType, SourcePosition* sourcePosition);
             Argument(ArgumentType argumentType, Expression* expression, SourcePosition* sourcePosition);
-            ~Argument();
             
             /**
              * Returns the kind of argument that this node represents.
@@ -121,24 +122,29 @@ namespace nel
                 }
             }
             
+            /**
+             * Binds the names in the argument's expression, if it has one, to the active scope.
+             */
+            void resolve(CompilationContext& context);
+            
             /**
              * Examines this term to figure out if it could fit in zero page.
              * After it's done, isZeroPage() will reflect the result.
              */
-            void checkForZeroPage();
+            void checkForZeroPage(CompilationContext& context);
             
             /**
              * Writes the expression, using a single byte if zero page,
              * and two bytes otherwise. Writes nothing (no error) if no expression.
              */
-            void write(RomBank* bank);
+            void write(CompilationContext& context, RomBank* bank);
             
             /**
              * Writes the expression as relative offset from program counter.
              * This offset is a 2's complement number in the range -127..128.
              * It is an error if the expression is undefined or outside of this range.
              */
-            void writeRelativeByte(RomBank* bank);
+            void writeRelativeByte(CompilationContext& context, RomBank* bank);
     };
     
 }
\ No newline at end of file
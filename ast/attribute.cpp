@@ -6,27 +6,58 @@
 namespace nel
 {
     Attribute::Attribute(ListNode<StringNode*>* pieces, SourcePosition* sourcePosition)
-        : Node(sourcePosition), pieces(pieces)
+        : Node(sourcePosition), pieces(pieces), scope(0), bindingState(UNBOUND), definition(0)
     {
     }
 
-    Attribute::~Attribute()
+    void Attribute::resolve(CompilationContext& context)
     {
-        delete pieces;   
+        scope = context.getActiveScope();
+        if(bindingState == UNBOUND)
+        {
+            if(Definition* def = search(context, false, false))
+            {
+                bindingState = BOUND;
+                definition = def;
+            }
+        }
     }
 
-    Definition* Attribute::findDefinition(bool forbidUndefined)
+    Definition* Attribute::findDefinition(CompilationContext& context, bool forbidUndefined)
+    {
+        switch(bindingState)
+        {
+            case BOUND:
+                return definition;
+            case UNRESOLVED:
+                return 0;
+            case UNBOUND:
+                break;
+        }
+
+        Definition* def = search(context, forbidUndefined, true);
+        // Before undefined symbols are forbidden, a symbol could still be defined later on,
+        // so only bind once they are.
+        if(forbidUndefined)
+        {
+            bindingState = def ? BOUND : UNRESOLVED;
+            definition = def;
+        }
+        return def;
+    }
+
+    Definition* Attribute::search(CompilationContext& context, bool forbidUndefined, bool report)
     {
         ListNode<StringNode*>::ListType& list = pieces->getList();
 
         StringNode* key = 0;
         Definition* def = 0;
-        SymbolTable* scope = SymbolTable::getActiveScope();
+        SymbolTable* scope = this->scope ? this->scope : context.getActiveScope();
         size_t i = 0;
         
         // Check list[0]
         key = list[i];
-        def = scope->tryGet(key->getValue());
+        def = scope->tryGet(key->getSymbol());
 
         // Check list[1] .. list[n-1] (if n > 1).
         for(i = 1; i < list.size(); i++)
@@ -43,16 +74,21 @@ namespace nel
 
                     // Try the next key.
                     key = list[i];
-                    def = scope->tryGet(key->getValue());
+                    def = scope->tryGet(key->getSymbol());
                 }
                 // Not a package. We can't do anything good.
                 else
                 {
+                    if(!report)
+                    {
+                        return 0;
+                    }
+
                     std::ostringstream os;
                     os << "`";
                     scope->printFullyQualifiedName(os, def);
                     os << "` is not a package but was treated as one, when trying to get attribute `" << getName() << "`";
-                    error(os.str(), list[i]->getSourcePosition());
+                    error(context, os.str(), list[i]->getSourcePosition());
 
                     // Failed.
                     return 0;
@@ -61,6 +97,11 @@ namespace nel
             // Doesn't exist. We can't index that.
             else
             {
+                if(!report)
+                {
+                    return 0;
+                }
+
                 std::ostringstream os;
                 os << "no package named `";
                 if(scope->getPackage())
@@ -69,7 +110,7 @@ namespace nel
                     os << ".";
                 }
                 os << key->getValue() << "` exists, needed to get attribute `" << getName() << "`";
-                error(os.str(), list[i]->getSourcePosition());
+                error(context, os.str(), list[i]->getSourcePosition());
 
                 // Failed.
                 return 0;
@@ -94,11 +135,11 @@ namespace nel
             os << ", needed to get attribute `" << getName() << "`";
             if(i < list.size())
             {
-                error(os.str(), list[i]->getSourcePosition());
+                error(context, os.str(), list[i]->getSourcePosition());
             }
             else
             {
-                error(os.str(), getSourcePosition());
+                error(context, os.str(), getSourcePosition());
             }
         }
 
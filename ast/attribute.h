@@ -6,17 +6,33 @@
 #include "string_node.h"
 #include "list_node.h"
 #include "definition.h"
+#include "compilation_context.h"
 
 namespace nel
 {
+    class SymbolTable;
+
     class Attribute : public Node
     {
         private:
+            /**
+             * Whether the attribute has been bound to its definition yet.
+             */
+            enum BindingState
+            {
+                UNBOUND,        /**< Not resolved yet, or only resolved while definitions were still being added. */
+                BOUND,          /**< Resolved to definition. */
+                UNRESOLVED,     /**< Failed to resolve, which has already been reported. */
+            };
+
             ListNode<StringNode*>* pieces;
+            // The scope the attribute appears in, or 0 until it's resolved.
+            SymbolTable* scope;
+            BindingState bindingState;
+            Definition* definition;
             
         public:
             Attribute(ListNode<StringNode*>* pieces, SourcePosition* sourcePosition);
-            ~Attribute();
             
             
             /**
@@ -57,10 +73,29 @@ namespace nel
                 return pieces;
             }
             
+            /**
+             * Records the active scope as the one this attribute is looked up in,
+             * and binds the attribute to its definition if it can be found.
+             * Any error is left to be reported when the attribute is used.
+             */
+            void resolve(CompilationContext& context);
+
             /**
              * Resolve the definition that this attribute refers to.
              * If forbidUndefined is set, then it will error upon missing symbols.
+             * Looks in the scope recorded by resolve(), or the active scope before then.
+             *
+             * Undefined symbols are only forbidden once every definition is in place,
+             * so the result is bound to the attribute at that point, and any later
+             * call returns it (or 0 for a failure) without searching again.
+             */
+            Definition* findDefinition(CompilationContext& context, bool forbidUndefined);
+
+        private:
+            /**
+             * Searches the scopes for the definition, as described by findDefinition.
+             * Errors are only reported if report is set.
              */
-            Definition* findDefinition(bool forbidUndefined);
+            Definition* search(CompilationContext& context, bool forbidUndefined, bool report);
     };
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "header_statement.h"
 #include "symbol_table.h"
 #include "package_definition.h"
+#include "trace_recorder.h"
+#include "lowered_program.h"
 
 namespace nel
 {
@@ -21,13 +23,25 @@ namespace nel
     
     BlockStatement::~BlockStatement()
     {
-        delete name;
-        delete statements;
         delete scope;
     }
     
+    void BlockStatement::describeSpan(CompilationContext& context, TraceRecorder::Span& span)
+    {
+        if(span.isEnabled())
+        {
+            std::ostringstream os;
+            getSourcePosition()->print(context, os);
+            span.addArgument("source", os.str());
+            if(name)
+            {
+                span.addArgument("package", name->getValue());
+            }
+        }
+    }
+
     // Find and handle the header for the main block.
-    bool BlockStatement::handleHeader(ListNode<Statement*>::ListType& list)
+    bool BlockStatement::handleHeader(CompilationContext& context, ListNode<Statement*>::ListType& list)
     {
         Statement* header = 0;
         for(size_t i = 0; i < list.size(); i++)
@@ -45,9 +59,9 @@ namespace nel
                     {
                         std::ostringstream os;
                         os << "multiple ines headers found. (previous header at ";
-                        header->getSourcePosition()->print(os);
+                        header->getSourcePosition()->print(context, os);
                         os << ").";
-                        error(os.str(), statement->getSourcePosition(), true);
+                        error(context, os.str(), statement->getSourcePosition(), true);
                         return false;
                     }
                 }
@@ -55,7 +69,7 @@ namespace nel
                 {
                     std::ostringstream os;
                     os << "ines header cannot appear inside a begin/end block.";
-                    error(os.str(), statement->getSourcePosition(), true);
+                    error(context, os.str(), statement->getSourcePosition(), true);
                     return false;       
                 }
             }
@@ -63,7 +77,7 @@ namespace nel
             {
                 if(statement->getStatementType() != Statement::CONSTANT_DECLARATION)
                 {
-                    error("statement that is not a constant declaration found before the ines header.", statement->getSourcePosition(), true);
+                    error(context, "statement that is not a constant declaration found before the ines header.", statement->getSourcePosition(), true);
                     return false;
                 }
             }
@@ -73,38 +87,41 @@ namespace nel
         {
             if(!header)
             {
-                error("no ines header found.", getSourcePosition(), true);
+                error(context, "no ines header found.", getSourcePosition(), true);
                 return false;
             }
             
-            header->aggregate();
+            header->aggregate(context);
         }
         return true;
     }
 
-    void BlockStatement::aggregate()
+    void BlockStatement::aggregate(CompilationContext& context)
     {
+        TraceRecorder::Span span(context.getTraceRecorder(), "aggregate", name ? "package" : "block");
+        describeSpan(context, span);
+
         // Create scope.
-        scope = new SymbolTable(SymbolTable::getActiveScope());
+        scope = new SymbolTable(context.getActiveScope());
 
         // If this scope has a name, register that as
         // a member of the containing scope.
         if(name)
         {
             // Assumes this code will never get executed by the outermost block (before there is an active scope).
-            SymbolTable* outer = SymbolTable::getActiveScope();
+            SymbolTable* outer = context.getActiveScope();
 
             PackageDefinition* package = new PackageDefinition(name->getValue(), scope);
 
             // Shove the this package into the containing outer scope.
-            outer->put(package, getSourcePosition());
+            outer->put(context, package, getSourcePosition());
             // Create a back-reference, so the scope knows it defines a new package,
             // rather than just sharing a private subset of the outer scope's package.
             scope->setPackage(package);
         }
 
         // Enter the created scope.
-        SymbolTable::enterScope(scope);
+        context.enterScope(scope);
         
         ListNode<Statement*>::ListType& list = statements->getList();
         // First gather all constant definitions in this scope.
@@ -113,12 +130,12 @@ namespace nel
             Statement* statement = list[i];
             if(statement->getStatementType() == Statement::CONSTANT_DECLARATION)
             {
-                statement->aggregate();
+                statement->aggregate(context);
             }
         }
         
         // Next, if this is the main block, calculate the header.
-        if(handleHeader(list))
+        if(handleHeader(context, list))
         {
             // Now, check out all the other statements.
             for(size_t i = 0; i < list.size(); i++)
@@ -132,40 +149,47 @@ namespace nel
                         break;
                     // Aggregate the rest.
                     default:
-                        statement->aggregate();
+                        statement->aggregate(context);
                         break;
                 }
             }
         }
         
-        SymbolTable::exitScope();
+        context.exitScope();
     }
     
-    void BlockStatement::validate()
+    void BlockStatement::resolve(CompilationContext& context)
     {
-        SymbolTable::enterScope(scope);
-        
-        ListNode<Statement*>::ListType& list = statements->getList();
-        // Check out all the statements that this contains.
-        for(size_t i = 0; i < list.size(); i++)
+        TraceRecorder::Span span(context.getTraceRecorder(), "resolve", name ? "package" : "block");
+        describeSpan(context, span);
+
+        context.enterScope(scope);
+
+        // Statements are lowered for the later passes as they're resolved, while they're still in cache.
+        LoweredProgram* program = context.getLoweredProgram();
+        if(program)
         {
-            list[i]->validate();
+            program->beginBlock(this);
         }
         
-        SymbolTable::exitScope();
-    }
-    
-    void BlockStatement::generate()
-    {
-        SymbolTable::enterScope(scope);
-        
         ListNode<Statement*>::ListType& list = statements->getList();
-        // Check out all the statements that this contains.
+        // Bind the names used by every statement that this contains.
         for(size_t i = 0; i < list.size(); i++)
         {
-            list[i]->generate();
+            Statement* statement = list[i];
+            statement->resolve(context);
+            // Nested blocks lower themselves.
+            if(program && statement->getStatementType() != Statement::BLOCK)
+            {
+                program->addStatement(statement);
+            }
+        }
+
+        if(program)
+        {
+            program->endBlock(this);
         }
         
-        SymbolTable::exitScope();
+        context.exitScope();
     }
 }
\ No newline at end of file
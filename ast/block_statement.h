@@ -3,6 +3,7 @@
 #include "statement.h"
 #include "string_node.h"
 #include "list_node.h"
+#include "trace_recorder.h"
 
 namespace nel
 {
@@ -37,9 +38,14 @@ namespace nel
             ~BlockStatement();
             
         private:
-            bool handleHeader(ListNode<Statement*>::ListType& list);
+            bool handleHeader(CompilationContext& context, ListNode<Statement*>::ListType& list);
 
         public:
+            /**
+             * Attaches where this block is, and the package it declares if any, to a span for one of its passes.
+             */
+            void describeSpan(CompilationContext& context, TraceRecorder::Span& span);
+
             /**
              * Returns the type of block this is.
              */
@@ -73,8 +79,7 @@ namespace nel
                 return name;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
     };
 }
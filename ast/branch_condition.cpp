@@ -6,9 +6,4 @@ namespace nel
         : Node(sourcePosition), conditionType(conditionType), flag(flag)
     {
     }
-    
-    BranchCondition::~BranchCondition()
-    {
-        delete flag;
-    }
 }
\ No newline at end of file
@@ -26,7 +26,6 @@ namespace nel
             
         public:
             BranchCondition(ConditionType conditionType, Argument* flag, SourcePosition* sourcePosition);
-            ~BranchCondition();
             
             /**
              * Returns the type of condition associated with this node.
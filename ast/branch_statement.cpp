@@ -19,18 +19,24 @@ namespace nel
         : Statement(Statement::BRANCH, sourcePosition), branchType(branchType), destination(destination), condition(condition)
     {
     }
-
-    BranchStatement::~BranchStatement()
+    
+    void BranchStatement::aggregate(CompilationContext& context)
     {
-        delete destination;
-        delete condition;
     }
-    
-    void BranchStatement::aggregate()
+
+    void BranchStatement::resolve(CompilationContext& context)
     {
+        if(destination)
+        {
+            destination->resolve(context);
+        }
+        if(condition)
+        {
+            condition->getFlag()->resolve(context);
+        }
     }
 
-    void BranchStatement::validate()
+    void BranchStatement::validate(CompilationContext& context)
     {
         unsigned int size = 0;
         switch(branchType)
@@ -52,22 +58,22 @@ namespace nel
         }
         
         // Reserve the bytes needed for this data.
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("branch statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "branch statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
             return;
         }
         bank->expand(size, getSourcePosition());
     }
     
-    void BranchStatement::generate()
+    void BranchStatement::generate(CompilationContext& context)
     {
         // Get the bank to use for writing.
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("branch statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "branch statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
             return;
         }
         
@@ -88,7 +94,7 @@ namespace nel
                     unsigned int opcode = 0;
                     if(destination->getArgumentType() == Argument::INDIRECT_LABEL)
                     {
-                        error("goto [indirect] cannot have a `when` clause.", getSourcePosition());
+                        error(context, "goto [indirect] cannot have a `when` clause.", getSourcePosition());
                     }
                     switch(condition->getFlag()->getArgumentType())
                     {
@@ -109,10 +115,10 @@ namespace nel
                             opcode = condition->getConditionType() == BranchCondition::CONDITION_SET ? 0x70 : 0x50;
                             break;
                         default:
-                            error("goto condition provided must be `carry`, `zero`, `negative`, or `overflow`", getSourcePosition());
+                            error(context, "goto condition provided must be `carry`, `zero`, `negative`, or `overflow`", getSourcePosition());
                     }
                     bank->writeByte(opcode, getSourcePosition());
-                    destination->writeRelativeByte(bank);
+                    destination->writeRelativeByte(context, bank);
                 }
                 else
                 {
@@ -128,16 +134,16 @@ namespace nel
                     }
                     
                     bank->writeByte(opcode, getSourcePosition());
-                    destination->write(bank);
+                    destination->write(context, bank);
                 }
                 break;
             case CALL:
                 if(destination->getArgumentType() == Argument::INDIRECT_LABEL)
                 {
-                    error("`call` cannot take an [indirect] memory location.", getSourcePosition());
+                    error(context, "`call` cannot take an [indirect] memory location.", getSourcePosition());
                 }
                 bank->writeByte(0x20, getSourcePosition()); // jsr label
-                destination->write(bank);
+                destination->write(context, bank);
                 break;
         }
     }
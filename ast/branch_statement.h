@@ -34,7 +34,6 @@ namespace nel
             BranchStatement(BranchType branchType, SourcePosition* sourcePosition);
             BranchStatement(BranchType branchType, Argument* destination, SourcePosition* sourcePosition);
             BranchStatement(BranchType branchType, Argument* destination, BranchCondition* condition, SourcePosition* sourcePosition);
-            ~BranchStatement();
 
             /**
              * Returns the kind of branch this statement represents.
@@ -60,8 +59,9 @@ namespace nel
                 return condition;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
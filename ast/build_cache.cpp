@@ -0,0 +1,369 @@
+#include <cstdio>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include "source_buffer.h"
+#include "source_file.h"
+#include "file_cache.h"
+#include "compilation_context.h"
+#include "precompiled_package.h"
+#include "build_cache.h"
+
+namespace nel
+{
+    namespace
+    {
+        const char* const MANIFEST_MAGIC = "NELCACHE";
+
+        // Reads a whole file, the same way as sources are, or returns 0 if it can't be read.
+        // A long-running compiler doesn't map it, since a file truncated while mapped faults on access.
+        SourceBuffer* readFile(const std::string& filename, bool mapFile)
+        {
+            SourceBuffer* buffer = mapFile ? SourceBuffer::map(filename) : 0;
+            if(!buffer)
+            {
+                if(FILE* f = fopen(filename.c_str(), "rb"))
+                {
+                    buffer = SourceBuffer::read(f);
+                    fclose(f);
+                }
+            }
+            return buffer;
+        }
+
+        std::string toHex(const FileIdentity::Hash& hash)
+        {
+            char buffer[33];
+            snprintf(buffer, sizeof(buffer), "%016llx%016llx", hash.high, hash.low);
+            return buffer;
+        }
+
+        std::string hashText(const std::string& text)
+        {
+            return toHex(FileIdentity::hashText(text.data(), text.size()));
+        }
+
+        // Returns a name to write a file under before it's renamed into place.
+        std::string getTemporaryFilename(const std::string& filename)
+        {
+            static std::atomic<unsigned int> counter(0);
+            std::ostringstream temporary;
+            #if defined(_WIN32)
+                temporary << filename << ".tmp." << _getpid() << "." << counter++;
+            #else
+                temporary << filename << ".tmp." << getpid() << "." << counter++;
+            #endif
+            return temporary.str();
+        }
+
+        bool moveIntoPlace(const std::string& temporary, const std::string& filename)
+        {
+            #if defined(_WIN32)
+                // Renaming doesn't replace an existing file here.
+                remove(filename.c_str());
+            #endif
+            if(rename(temporary.c_str(), filename.c_str()))
+            {
+                remove(temporary.c_str());
+                return false;
+            }
+            return true;
+        }
+    }
+
+    BuildCache::BuildCache(const std::string& directory, FileCache* fileCache)
+        : directory(directory), fileCache(fileCache), entries(MEMORY_LIMIT)
+    {
+        if(!directory.empty())
+        {
+            if(this->directory[this->directory.size() - 1] != '/' && this->directory[this->directory.size() - 1] != '\\')
+            {
+                this->directory += '/';
+            }
+            #if defined(_WIN32)
+                _mkdir(directory.c_str());
+            #else
+                mkdir(directory.c_str(), 0777);
+            #endif
+        }
+
+        // The compiler is identified by the size and modification time of its own executable
+        // where that can be found, like ccache does, so that rebuilding it starts the cache over.
+        // Otherwise, by when it was built.
+        std::ostringstream compiler;
+        compiler << MANIFEST_MAGIC << " " << VERSION << " " << PrecompiledPackage::VERSION << " ";
+        bool found = false;
+        #if !defined(_WIN32)
+            struct stat info;
+            if(stat("/proc/self/exe", &info) == 0)
+            {
+                compiler << info.st_size << " " << info.st_mtime;
+                found = true;
+            }
+        #endif
+        if(!found)
+        {
+            compiler << __DATE__ << " " << __TIME__;
+        }
+        compilerHash = hashText(compiler.str());
+    }
+
+    std::string BuildCache::getEntryName(const std::string& key, const std::string& extension)
+    {
+        return directory + hashText(compilerHash + "\n" + key) + extension;
+    }
+
+    bool BuildCache::readEntry(const std::string& name, std::string& data)
+    {
+        if(directory.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string* entry = entries.find(name);
+            if(!entry)
+            {
+                return false;
+            }
+            data = *entry;
+            return true;
+        }
+
+        SourceBuffer* buffer = readFile(name, !fileCache);
+        if(!buffer)
+        {
+            return false;
+        }
+        data.assign(buffer->getData(), buffer->getSize());
+        delete buffer;
+        return true;
+    }
+
+    bool BuildCache::writeEntry(const std::string& name, const char* data, size_t size)
+    {
+        if(directory.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.put(name, std::string(data, size), name.size() + size);
+            return true;
+        }
+
+        // Written under a temporary name and renamed into place,
+        // so that nobody sharing the cache ever sees half of it.
+        std::string temporary = getTemporaryFilename(name);
+        std::ofstream file(temporary.c_str(), std::ios::out | std::ios::binary);
+        if(!file.is_open())
+        {
+            return false;
+        }
+        file.write(data, size);
+        file.close();
+        if(file.fail())
+        {
+            remove(temporary.c_str());
+            return false;
+        }
+        return moveIntoPlace(temporary, name);
+    }
+
+    bool BuildCache::hasEntry(const std::string& name)
+    {
+        if(directory.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return entries.find(name) != 0;
+        }
+
+        if(FILE* f = fopen(name.c_str(), "rb"))
+        {
+            fclose(f);
+            return true;
+        }
+        return false;
+    }
+
+    FileIdentity BuildCache::hashFile(const std::string& filename)
+    {
+        FileIdentity identity;
+        if(fileCache)
+        {
+            fileCache->read(filename, &identity);
+        }
+        else if(SourceBuffer* buffer = readFile(filename, !fileCache))
+        {
+            identity = buffer->getIdentity();
+            delete buffer;
+        }
+        return identity;
+    }
+
+    std::string BuildCache::getRomKey(const std::string& input, const FileIdentity& identity)
+    {
+        std::ostringstream key;
+        key << "rom\n" << input << "\n" << identity.getSize() << " " << toHex(identity.getHash());
+        return key.str();
+    }
+
+    bool BuildCache::fetchRom(const std::string& input, const std::string& output, std::vector<std::string>* dependencies)
+    {
+        FileIdentity main = hashFile(input);
+        if(!main.isHashed())
+        {
+            return false;
+        }
+
+        std::string key = getRomKey(input, main);
+        std::string text;
+        if(!readEntry(getEntryName(key, ".manifest"), text))
+        {
+            return false;
+        }
+
+        std::istringstream manifest(text);
+        std::string magic;
+        unsigned int version;
+        size_t romSize;
+        std::string romHash;
+        if(!(manifest >> magic >> version) || magic != MANIFEST_MAGIC || version != VERSION
+            || !(manifest >> romSize >> romHash))
+        {
+            return false;
+        }
+
+        // Every file that went into the ROM must still have the same text.
+        std::vector<std::string> filenames;
+        size_t size;
+        std::string hash;
+        while(manifest >> size >> hash)
+        {
+            std::string filename;
+            manifest.get();
+            if(!std::getline(manifest, filename))
+            {
+                return false;
+            }
+
+            FileIdentity identity = hashFile(filename);
+            if(!identity.isHashed() || identity.getSize() != size || toHex(identity.getHash()) != hash)
+            {
+                return false;
+            }
+            filenames.push_back(filename);
+        }
+        if(!manifest.eof())
+        {
+            return false;
+        }
+
+        // Someone else may have replaced the ROM since the manifest was read.
+        std::string rom;
+        FileIdentity romIdentity;
+        if(!readEntry(getEntryName(key, ".nes"), rom))
+        {
+            return false;
+        }
+        romIdentity.setText(rom.data(), rom.size());
+        if(rom.size() != romSize || toHex(romIdentity.getHash()) != romHash)
+        {
+            return false;
+        }
+
+        std::ofstream file(output.c_str(), std::ios::out | std::ios::binary);
+        file.write(rom.data(), rom.size());
+        file.close();
+        if(file.fail())
+        {
+            return false;
+        }
+        if(dependencies)
+        {
+            dependencies->swap(filenames);
+        }
+        return true;
+    }
+
+    bool BuildCache::storeRom(CompilationContext& context, const std::string& input, const std::string& output)
+    {
+        SourceFile* main = context.getSourceFile(1);
+        SourceBuffer* rom = readFile(output, !fileCache);
+        if(!main || !rom)
+        {
+            delete rom;
+            return false;
+        }
+
+        std::ostringstream manifest;
+        manifest << MANIFEST_MAGIC << " " << VERSION << "\n";
+        manifest << rom->getSize() << " " << toHex(rom->getIdentity().getHash()) << "\n";
+
+        // Every file in the file table went into the ROM, whether it was parsed or
+        // stood in for by a precompiled package, and so did every embedded file.
+        SourceFile* sourceFile;
+        for(unsigned int i = 1; (sourceFile = context.getSourceFile(i)) != 0; i++)
+        {
+            const FileIdentity& identity = sourceFile->getBuffer()->getIdentity();
+            manifest << identity.getSize() << " " << toHex(identity.getHash()) << " " << sourceFile->getFilename() << "\n";
+        }
+        const std::vector<std::string>& embeddedFiles = context.getEmbeddedFiles();
+        for(size_t i = 0; i < embeddedFiles.size(); i++)
+        {
+            FileIdentity identity = hashFile(embeddedFiles[i]);
+            if(!identity.isHashed())
+            {
+                delete rom;
+                return false;
+            }
+            manifest << identity.getSize() << " " << toHex(identity.getHash()) << " " << embeddedFiles[i] << "\n";
+        }
+
+        // The ROM goes in before the manifest that leads to it.
+        std::string key = getRomKey(input, main->getBuffer()->getIdentity());
+        std::string text = manifest.str();
+        bool success = writeEntry(getEntryName(key, ".nes"), rom->getData(), rom->getSize())
+            && writeEntry(getEntryName(key, ".manifest"), text.data(), text.size());
+        delete rom;
+        return success;
+    }
+
+    std::string BuildCache::getPackageName(const FileIdentity& source)
+    {
+        std::ostringstream key;
+        key << "package\n" << source.getSize() << " " << toHex(source.getHash());
+        return getEntryName(key.str(), ".nelpkg");
+    }
+
+    ListNode<Statement*>* BuildCache::loadPackage(const FileIdentity& source, unsigned int file)
+    {
+        std::string package;
+        if(!readEntry(getPackageName(source), package))
+        {
+            return 0;
+        }
+        return PrecompiledPackage::loadFromMemory(package.data(), package.size(), source, file);
+    }
+
+    bool BuildCache::hasPackage(const FileIdentity& source)
+    {
+        std::string name = getPackageName(source);
+        return hasEntry(name) || hasEntry(name + ".none");
+    }
+
+    bool BuildCache::storePackage(CompilationContext& context, const FileIdentity& source)
+    {
+        std::string package;
+        return PrecompiledPackage::writeToMemory(context, context.getStartNode(), source, package)
+            && writeEntry(getPackageName(source), package.data(), package.size());
+    }
+
+    void BuildCache::storeNonPackage(const FileIdentity& source)
+    {
+        writeEntry(getPackageName(source) + ".none", "", 0);
+    }
+}
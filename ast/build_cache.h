@@ -0,0 +1,144 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "file_identity.h"
+#include "list_node.h"
+#include "lru_map.h"
+#include "statement.h"
+
+namespace nel
+{
+    class CompilationContext;
+    class FileCache;
+
+    /**
+     * A directory of finished builds, kept between runs so that unchanged
+     * programs don't need to be compiled again.
+     *
+     * A ROM is filed under the compiler, the filename it was compiled from
+     * and that file's text, along with a manifest of every file that went
+     * into it: the main file, every file it required, and every file it
+     * embedded, each with its size and 128-bit hash. It's only used while every one
+     * of those still matches, so a hit costs no more than reading them.
+     *
+     * Required files that are only constants and packages are also kept as
+     * precompiled packages, filed under their text, so that a program that
+     * did change can still skip parsing the files that didn't.
+     *
+     * Entries are written to a temporary file and renamed into place,
+     * so any number of compilers may share a cache. A long-running compiler
+     * may keep its entries in memory instead, and look at files through
+     * a file cache, so that checking a file that hasn't changed since
+     * doesn't read it again.
+     */
+    class BuildCache
+    {
+        private:
+            // The directory holding the entries, ending in a separator, or "" if they're kept in memory.
+            std::string directory;
+            // What files are read through, or 0 if they're read every time.
+            FileCache* fileCache;
+            // A hash of the compiler itself, which every entry is filed under.
+            std::string compilerHash;
+            // The entries, when they're kept in memory, up to MEMORY_LIMIT bytes of them.
+            std::mutex mutex;
+            LruMap<std::string> entries;
+
+            // Not copyable.
+            BuildCache(const BuildCache&);
+            BuildCache& operator=(const BuildCache&);
+
+            /**
+             * Returns the name of an entry, named for a hash of a key.
+             */
+            std::string getEntryName(const std::string& key, const std::string& extension);
+
+            /**
+             * Reads an entry, and returns whether there was one.
+             */
+            bool readEntry(const std::string& name, std::string& data);
+
+            /**
+             * Writes an entry, replacing any there was, and returns whether it was written.
+             */
+            bool writeEntry(const std::string& name, const char* data, size_t size);
+
+            /**
+             * Returns whether there's an entry.
+             */
+            bool hasEntry(const std::string& name);
+
+            /**
+             * Returns the identity of a file's text, which matches nothing if it can't be read.
+             */
+            FileIdentity hashFile(const std::string& filename);
+
+            /**
+             * Returns the key that the ROM for a main file is filed under, given the identity of its text.
+             */
+            std::string getRomKey(const std::string& input, const FileIdentity& identity);
+
+            /**
+             * Returns the name of the entry for the precompiled package of a source file with the given identity.
+             */
+            std::string getPackageName(const FileIdentity& source);
+
+        public:
+            enum
+            {
+                // Bump this whenever the layout of the cache changes.
+                VERSION = 2,
+                // The most bytes of entries kept in memory, after which the least recently used go.
+                MEMORY_LIMIT = 128 << 20
+            };
+
+            /**
+             * Opens the cache in a directory, creating it if it doesn't exist,
+             * or keeps it in memory if the directory is "", where it holds up to
+             * MEMORY_LIMIT bytes of the most recently used entries. Files are read through
+             * the given file cache, if any, which the build cache doesn't own.
+             */
+            BuildCache(const std::string& directory, FileCache* fileCache = 0);
+
+            /**
+             * Copies the cached ROM for a main file to an output file, if there is one
+             * and nothing that went into it has changed since. Returns whether it did,
+             * setting the files that went into it, if asked.
+             */
+            bool fetchRom(const std::string& input, const std::string& output, std::vector<std::string>* dependencies = 0);
+
+            /**
+             * Stores the ROM that a compilation wrote to an output file, along with the manifest of
+             * the files that went into it. Returns whether it was stored.
+             */
+            bool storeRom(CompilationContext& context, const std::string& input, const std::string& output);
+
+            /**
+             * Reads the statements of the precompiled package for a source file with the given identity,
+             * which is the given file in the compilation's file table, or returns 0 if there isn't one.
+             */
+            ListNode<Statement*>* loadPackage(const FileIdentity& source, unsigned int file);
+
+            /**
+             * Returns whether a source file with the given identity was already looked at,
+             * either becoming a precompiled package or not.
+             */
+            bool hasPackage(const FileIdentity& source);
+
+            /**
+             * Stores a precompiled package of a compilation's aggregated and resolved block,
+             * which came from the source file with the given identity.
+             * Returns whether it was stored.
+             */
+            bool storePackage(CompilationContext& context, const FileIdentity& source);
+
+            /**
+             * Records that a source file with the given identity isn't a package,
+             * so there's no use trying it again.
+             */
+            void storeNonPackage(const FileIdentity& source);
+    };
+}
@@ -5,6 +5,519 @@
 
 namespace nel
 {
+    namespace
+    {
+        // What sizing a command has to do before its encoding is known.
+        enum Action
+        {
+            // The command can't take this receiver or argument, for the reason in the message.
+            REJECT,
+            // The encoding is already known.
+            ENCODE,
+            // The memory operand always takes one byte, like an immediate value.
+            FORCE_ZERO_PAGE,
+            // The memory operand takes one byte if its value fits in zero page, and two otherwise.
+            CHECK_ZERO_PAGE,
+            // The receiver and argument trade places, turning a get into a put or a put into a get.
+            SWAP
+        };
+
+        // Why a command can't take its receiver or argument.
+        enum Message
+        {
+            NO_MESSAGE,
+            GET_A_ARGUMENT,
+            GET_X_ARGUMENT,
+            GET_Y_ARGUMENT,
+            TRANSFER_S_ARGUMENT,
+            GET_RECEIVER,
+            PUT_A_ARGUMENT,
+            PUT_X_ARGUMENT,
+            PUT_Y_ARGUMENT,
+            PUT_RECEIVER,
+            CMP_A_ARGUMENT,
+            CMP_INDEX_ARGUMENT,
+            CMP_RECEIVER,
+            ARITHMETIC_ARGUMENT,
+            BIT_ARGUMENT,
+            A_RECEIVER,
+            INC_DEC_RECEIVER,
+            SHIFT_RECEIVER,
+            STACK_RECEIVER,
+            SET_ARGUMENT,
+            UNSET_ARGUMENT,
+            P_RECEIVER
+        };
+
+        const char* const MESSAGES[] =
+        {
+            "",
+            "if receiver is the register `a`, then the argument must be the register `x` or `y`, an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]",
+            "if receiver is the register `x`, then the argument must be the register `a` or `s`, an immediate value #foo, or a direct memory term of form @foo or @foo[y]",
+            "if receiver is the register `y`, then the argument must be the register `a`, an immediate value #foo, or a direct memory term of form @foo or @foo[x]",
+            "if receiver is the register `x`, then the argument must be `x`",
+            "receiver must be the register `a`, `x`, `y`, or `s`, or some memory term that is not an immediate value",
+            "if receiver is the register `a`, then the argument must be the register `x` or `y`, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]",
+            "if receiver is the register `x`, then the argument must be the register `a` or `s`, or a direct memory term of form @foo or @foo[y]",
+            "if receiver is the register `y`, then the argument must be the register `a`, or a direct memory term of form @foo or @foo[x]",
+            "receiver must be the register `a`, `x`, `y`, or `s`, or some memory term",
+            "if receiver is the register `a`, then the argument must be an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]",
+            "if receiver is an index register, then the argument must be an immediate value #foo, or a direct memory term of form @foo",
+            "receiver must be the register `a`, `x`, or `y`.",
+            "argument must be an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]",
+            "argument must be a direct memory term of form @foo",
+            "receiver must be the register `a`.",
+            "receiver must be the register `x`, register `y`, or a direct memory term of form @foo, or @foo[x].",
+            "receiver must be the register `a`, or a direct memory term of form @expr, or @expr[x].",
+            "receiver must be the register `a` or `p`.",
+            "argument must be the p-flag `carry`, `interrupt`, or `decimal`.",
+            "argument must be the p-flag `carry`, `interrupt`, `decimal`, or `overflow`.",
+            "receiver must be the register `p`."
+        };
+
+        // How a command is encoded, for one combination of command, receiver, argument,
+        // and whether its memory operand fits in zero page.
+        struct Encoding
+        {
+            unsigned char action;
+            unsigned char message;
+            // The size of the whole command, in bytes.
+            unsigned char size;
+            // The cycles the whole command takes, not counting the one an indexed read
+            // takes extra when it crosses a page, or anything for a mode with a zero page
+            // form that turns out not to be in zero page, which is a separate entry.
+            unsigned char cycles;
+            // The bytes written before the memory operand, if there is one.
+            // A synthetic command can need several instructions.
+            unsigned char codeSize;
+            unsigned char code[5];
+        };
+
+        constexpr Encoding reject(Message message)
+        {
+            return Encoding {REJECT, (unsigned char) message, 0, 0, 0, {0, 0, 0, 0, 0}};
+        }
+
+        constexpr Encoding swap()
+        {
+            return Encoding {SWAP, NO_MESSAGE, 0, 0, 0, {0, 0, 0, 0, 0}};
+        }
+
+        // An instruction with no operand, or one that's a register or p-flag.
+        // Most take two cycles, but those that touch the stack take more.
+        constexpr Encoding implied(unsigned char opcode, unsigned char cycles = 2)
+        {
+            return Encoding {ENCODE, NO_MESSAGE, 1, cycles, 1, {opcode, 0, 0, 0, 0}};
+        }
+
+        // An instruction with a memory operand, which takes one byte in zero page and two otherwise.
+        // The action says which it is: always zero page, whichever fits, or never, for modes without a zero page form.
+        // Immediate values count as zero page here, with their own cycles.
+        constexpr Encoding memory(Action action, unsigned char zeroPageOpcode, unsigned char zeroPageCycles,
+            unsigned char absoluteOpcode, unsigned char absoluteCycles, bool zeroPage)
+        {
+            return action == FORCE_ZERO_PAGE || (action == CHECK_ZERO_PAGE && zeroPage)
+                ? Encoding {(unsigned char) action, NO_MESSAGE, 2, zeroPageCycles, 1, {zeroPageOpcode, 0, 0, 0, 0}}
+                : Encoding {(unsigned char) action, NO_MESSAGE, 3, absoluteCycles, 1, {absoluteOpcode, 0, 0, 0, 0}};
+        }
+
+        // Puts a two-cycle implied instruction before one, like the clc of an add.
+        // Its byte is reserved even if the rest is rejected, so the positions in later errors don't move.
+        constexpr Encoding prefix(unsigned char opcode, Encoding encoding)
+        {
+            if(encoding.action != REJECT)
+            {
+                for(unsigned int i = encoding.codeSize; i > 0; i--)
+                {
+                    encoding.code[i] = encoding.code[i - 1];
+                }
+                encoding.code[0] = opcode;
+                encoding.codeSize++;
+                encoding.cycles += 2;
+            }
+            encoding.size++;
+            return encoding;
+        }
+
+        // The accumulator instructions (ora, and, eor, adc, sta, lda, cmp, sbc) share their addressing
+        // modes, each of which adds the same amount to the instruction's (zp, x) opcode, and takes the same cycles.
+        // Only sta can't take an immediate value, and it's a store, which always takes the cycle
+        // that an indexed read only takes when it crosses a page.
+        constexpr Encoding accumulator(unsigned char opcode, Argument::ArgumentType argument, bool zeroPage, bool immediate, Message message)
+        {
+            switch(argument)
+            {
+                case Argument::IMMEDIATE:
+                    return immediate ? memory(FORCE_ZERO_PAGE, opcode + 0x08, 2, 0, 0, zeroPage) : reject(message);
+                case Argument::ZP_INDEXED_INDIRECT:
+                    return memory(FORCE_ZERO_PAGE, opcode, 6, 0, 0, zeroPage);
+                case Argument::ZP_INDIRECT_INDEXED:
+                    return memory(FORCE_ZERO_PAGE, opcode + 0x10, immediate ? 5 : 6, 0, 0, zeroPage);
+                case Argument::DIRECT:
+                    return memory(CHECK_ZERO_PAGE, opcode + 0x04, 3, opcode + 0x0C, 4, zeroPage);
+                case Argument::INDEXED_BY_X:
+                    return memory(CHECK_ZERO_PAGE, opcode + 0x14, 4, opcode + 0x1C, immediate ? 4 : 5, zeroPage);
+                case Argument::INDEXED_BY_Y:
+                    return memory(ENCODE, 0, 0, opcode + 0x18, immediate ? 4 : 5, zeroPage);
+                default:
+                    return reject(message);
+            }
+        }
+
+        // The read-modify-write instructions (asl, rol, lsr, ror, dec, inc) work on memory the same way,
+        // and the shifts and rotates also work on the accumulator.
+        constexpr Encoding readModifyWrite(unsigned char opcode, Argument::ArgumentType receiver, bool zeroPage, bool accumulator, Message message)
+        {
+            switch(receiver)
+            {
+                case Argument::A:
+                    return accumulator ? implied(opcode + 0x08) : reject(message);
+                case Argument::DIRECT:
+                    return memory(CHECK_ZERO_PAGE, opcode + 0x04, 5, opcode + 0x0C, 6, zeroPage);
+                case Argument::INDEXED_BY_X:
+                    return memory(CHECK_ZERO_PAGE, opcode + 0x14, 6, opcode + 0x1C, 7, zeroPage);
+                default:
+                    return reject(message);
+            }
+        }
+
+        constexpr Encoding encodeGet(Argument::ArgumentType receiver, Argument::ArgumentType argument, bool zeroPage)
+        {
+            switch(receiver)
+            {
+                case Argument::A:
+                    switch(argument)
+                    {
+                        case Argument::X: return implied(0x8A); // txa
+                        case Argument::Y: return implied(0x98); // tya
+                        default: return accumulator(0xA1, argument, zeroPage, true, GET_A_ARGUMENT); // lda
+                    }
+                case Argument::X:
+                    switch(argument)
+                    {
+                        case Argument::A: return implied(0xAA); // tax
+                        case Argument::S: return implied(0xBA); // tsx
+                        case Argument::IMMEDIATE: return memory(FORCE_ZERO_PAGE, 0xA2, 2, 0, 0, zeroPage); // ldx #imm
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0xA6, 3, 0xAE, 4, zeroPage); // ldx mem
+                        case Argument::INDEXED_BY_Y: return memory(CHECK_ZERO_PAGE, 0xB6, 4, 0xBE, 4, zeroPage); // ldx mem, y
+                        default: return reject(GET_X_ARGUMENT);
+                    }
+                case Argument::Y:
+                    switch(argument)
+                    {
+                        case Argument::A: return implied(0xA8); // tay
+                        case Argument::IMMEDIATE: return memory(FORCE_ZERO_PAGE, 0xA0, 2, 0, 0, zeroPage); // ldy #imm
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0xA4, 3, 0xAC, 4, zeroPage); // ldy mem
+                        case Argument::INDEXED_BY_X: return memory(CHECK_ZERO_PAGE, 0xB4, 4, 0xBC, 4, zeroPage); // ldy mem, x
+                        default: return reject(GET_Y_ARGUMENT);
+                    }
+                case Argument::S:
+                    return argument == Argument::X ? implied(0x9A) : reject(TRANSFER_S_ARGUMENT); // txs
+                // 'M: get src' is 'src: put M'.
+                case Argument::DIRECT:
+                case Argument::INDEXED_BY_X:
+                case Argument::INDEXED_BY_Y:
+                case Argument::ZP_INDEXED_INDIRECT:
+                case Argument::ZP_INDIRECT_INDEXED:
+                    return swap();
+                default:
+                    return reject(GET_RECEIVER);
+            }
+        }
+
+        constexpr Encoding encodePut(Argument::ArgumentType receiver, Argument::ArgumentType argument, bool zeroPage)
+        {
+            switch(receiver)
+            {
+                case Argument::A:
+                    switch(argument)
+                    {
+                        case Argument::X: return implied(0xAA); // tax
+                        case Argument::Y: return implied(0xA8); // tay
+                        default: return accumulator(0x81, argument, zeroPage, false, PUT_A_ARGUMENT); // sta
+                    }
+                case Argument::X:
+                    switch(argument)
+                    {
+                        case Argument::A: return implied(0x8A); // txa
+                        case Argument::S: return implied(0x9A); // txs
+                        // There's no absolute form of stx mem, y, so it's assumed to be zero page.
+                        case Argument::INDEXED_BY_Y: return memory(FORCE_ZERO_PAGE, 0x96, 4, 0, 0, zeroPage); // stx zp, y
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0x86, 3, 0x8E, 4, zeroPage); // stx mem
+                        default: return reject(PUT_X_ARGUMENT);
+                    }
+                case Argument::Y:
+                    switch(argument)
+                    {
+                        case Argument::A: return implied(0x98); // tya
+                        // There's no absolute form of sty mem, x, so it's assumed to be zero page.
+                        case Argument::INDEXED_BY_X: return memory(FORCE_ZERO_PAGE, 0x94, 4, 0, 0, zeroPage); // sty zp, x
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0x84, 3, 0x8C, 4, zeroPage); // sty mem
+                        default: return reject(PUT_Y_ARGUMENT);
+                    }
+                case Argument::S:
+                    return argument == Argument::X ? implied(0xBA) : reject(TRANSFER_S_ARGUMENT); // tsx
+                // 'M: put dest' is 'dest: get M'.
+                case Argument::IMMEDIATE:
+                case Argument::DIRECT:
+                case Argument::INDEXED_BY_X:
+                case Argument::INDEXED_BY_Y:
+                case Argument::ZP_INDEXED_INDIRECT:
+                case Argument::ZP_INDIRECT_INDEXED:
+                    return swap();
+                default:
+                    return reject(PUT_RECEIVER);
+            }
+        }
+
+        constexpr Encoding encodeCompare(Argument::ArgumentType receiver, Argument::ArgumentType argument, bool zeroPage)
+        {
+            switch(receiver)
+            {
+                case Argument::A:
+                    return accumulator(0xC1, argument, zeroPage, true, CMP_A_ARGUMENT); // cmp
+                case Argument::X:
+                    switch(argument)
+                    {
+                        case Argument::IMMEDIATE: return memory(FORCE_ZERO_PAGE, 0xE0, 2, 0, 0, zeroPage); // cpx #imm
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0xE4, 3, 0xEC, 4, zeroPage); // cpx mem
+                        default: return reject(CMP_INDEX_ARGUMENT);
+                    }
+                case Argument::Y:
+                    switch(argument)
+                    {
+                        case Argument::IMMEDIATE: return memory(FORCE_ZERO_PAGE, 0xC0, 2, 0, 0, zeroPage); // cpy #imm
+                        case Argument::DIRECT: return memory(CHECK_ZERO_PAGE, 0xC4, 3, 0xCC, 4, zeroPage); // cpy mem
+                        default: return reject(CMP_INDEX_ARGUMENT);
+                    }
+                default:
+                    return reject(CMP_RECEIVER);
+            }
+        }
+
+        constexpr Encoding encode(Command::CommandType command, Argument::ArgumentType receiver, Argument::ArgumentType argument, bool zeroPage)
+        {
+            switch(command)
+            {
+                case Command::GET:
+                    return encodeGet(receiver, argument, zeroPage);
+                case Command::PUT:
+                    return encodePut(receiver, argument, zeroPage);
+                case Command::CMP:
+                    return encodeCompare(receiver, argument, zeroPage);
+                case Command::ADD:
+                    return receiver == Argument::A ? prefix(0x18, accumulator(0x61, argument, zeroPage, true, ARITHMETIC_ARGUMENT)) : reject(A_RECEIVER); // clc, adc
+                case Command::ADDC:
+                    return receiver == Argument::A ? accumulator(0x61, argument, zeroPage, true, ARITHMETIC_ARGUMENT) : reject(A_RECEIVER); // adc
+                case Command::SUB:
+                    return receiver == Argument::A ? prefix(0x38, accumulator(0xE1, argument, zeroPage, true, ARITHMETIC_ARGUMENT)) : reject(A_RECEIVER); // sec, sbc
+                case Command::SUBC:
+                    return receiver == Argument::A ? accumulator(0xE1, argument, zeroPage, true, ARITHMETIC_ARGUMENT) : reject(A_RECEIVER); // sbc
+                case Command::BITWISE_OR:
+                    return receiver == Argument::A ? accumulator(0x01, argument, zeroPage, true, ARITHMETIC_ARGUMENT) : reject(A_RECEIVER); // ora
+                case Command::BITWISE_AND:
+                    return receiver == Argument::A ? accumulator(0x21, argument, zeroPage, true, ARITHMETIC_ARGUMENT) : reject(A_RECEIVER); // and
+                case Command::BITWISE_XOR:
+                    return receiver == Argument::A ? accumulator(0x41, argument, zeroPage, true, ARITHMETIC_ARGUMENT) : reject(A_RECEIVER); // eor
+                case Command::BIT:
+                    if(receiver != Argument::A)
+                    {
+                        return reject(A_RECEIVER);
+                    }
+                    return argument == Argument::DIRECT ? memory(CHECK_ZERO_PAGE, 0x24, 3, 0x2C, 4, zeroPage) : reject(BIT_ARGUMENT); // bit mem
+                case Command::INC:
+                    switch(receiver)
+                    {
+                        case Argument::X: return implied(0xE8); // inx
+                        case Argument::Y: return implied(0xC8); // iny
+                        default: return readModifyWrite(0xE2, receiver, zeroPage, false, INC_DEC_RECEIVER); // inc
+                    }
+                case Command::DEC:
+                    switch(receiver)
+                    {
+                        case Argument::X: return implied(0xCA); // dex
+                        case Argument::Y: return implied(0x88); // dey
+                        default: return readModifyWrite(0xC2, receiver, zeroPage, false, INC_DEC_RECEIVER); // dec
+                    }
+                case Command::NOT:
+                    if(receiver != Argument::A)
+                    {
+                        return reject(A_RECEIVER);
+                    }
+                    return Encoding {ENCODE, NO_MESSAGE, 2, 2, 2, {0x49, 0xFF, 0, 0, 0}}; // eor #0xff
+                case Command::NEG:
+                    if(receiver != Argument::A)
+                    {
+                        return reject(A_RECEIVER);
+                    }
+                    return Encoding {ENCODE, NO_MESSAGE, 5, 6, 5, {0x18, 0x49, 0xFF, 0x69, 0x01}}; // clc, eor #0xff, adc #0x01
+                case Command::SHL:
+                    return readModifyWrite(0x02, receiver, zeroPage, true, SHIFT_RECEIVER); // asl
+                case Command::SHR:
+                    return readModifyWrite(0x42, receiver, zeroPage, true, SHIFT_RECEIVER); // lsr
+                case Command::ROL:
+                    return readModifyWrite(0x22, receiver, zeroPage, true, SHIFT_RECEIVER); // rol
+                case Command::ROR:
+                    return readModifyWrite(0x62, receiver, zeroPage, true, SHIFT_RECEIVER); // ror
+                case Command::PUSH:
+                    switch(receiver)
+                    {
+                        case Argument::A: return implied(0x48, 3); // pha
+                        case Argument::P: return implied(0x08, 3); // php
+                        default: return reject(STACK_RECEIVER);
+                    }
+                case Command::PULL:
+                    switch(receiver)
+                    {
+                        case Argument::A: return implied(0x68, 4); // pla
+                        case Argument::P: return implied(0x28, 4); // plp
+                        default: return reject(STACK_RECEIVER);
+                    }
+                case Command::SET:
+                    if(receiver != Argument::P)
+                    {
+                        return reject(P_RECEIVER);
+                    }
+                    switch(argument)
+                    {
+                        case Argument::CARRY: return implied(0x38); // sec
+                        case Argument::INTERRUPT: return implied(0x78); // sei
+                        case Argument::DECIMAL: return implied(0xF8); // sed
+                        default: return reject(SET_ARGUMENT);
+                    }
+                case Command::UNSET:
+                    if(receiver != Argument::P)
+                    {
+                        return reject(P_RECEIVER);
+                    }
+                    switch(argument)
+                    {
+                        case Argument::CARRY: return implied(0x18); // clc
+                        case Argument::INTERRUPT: return implied(0x58); // cli
+                        case Argument::DECIMAL: return implied(0xD8); // cld
+                        case Argument::OVERFLOW: return implied(0xB8); // clv
+                        default: return reject(UNSET_ARGUMENT);
+                    }
+                default:
+                    // An invalid command was already reported by the parser, and has nothing to write.
+                    return Encoding {ENCODE, NO_MESSAGE, 0, 0, 0, {0, 0, 0, 0, 0}};
+            }
+        }
+
+        // The number of values of each enumeration, which index the table.
+        const unsigned int COMMAND_TYPE_COUNT = Command::UNSET + 1;
+        const unsigned int ARGUMENT_TYPE_COUNT = Argument::ZP_INDIRECT_INDEXED + 1;
+
+        // Every encoding, by command, receiver, argument (INVALID if there's none),
+        // and whether the memory operand fits in zero page.
+        struct EncodingTable
+        {
+            Encoding encodings[COMMAND_TYPE_COUNT][ARGUMENT_TYPE_COUNT][ARGUMENT_TYPE_COUNT][2];
+        };
+
+        constexpr EncodingTable buildEncodingTable()
+        {
+            EncodingTable table = {};
+            for(unsigned int command = 0; command < COMMAND_TYPE_COUNT; command++)
+            {
+                for(unsigned int receiver = 0; receiver < ARGUMENT_TYPE_COUNT; receiver++)
+                {
+                    for(unsigned int argument = 0; argument < ARGUMENT_TYPE_COUNT; argument++)
+                    {
+                        for(unsigned int zeroPage = 0; zeroPage < 2; zeroPage++)
+                        {
+                            table.encodings[command][receiver][argument][zeroPage] = encode((Command::CommandType) command,
+                                (Argument::ArgumentType) receiver, (Argument::ArgumentType) argument, zeroPage != 0);
+                        }
+                    }
+                }
+            }
+            return table;
+        }
+
+        // Built by the compiler, so that looking up a command's encoding is a single index.
+        constexpr EncodingTable ENCODING_TABLE = buildEncodingTable();
+
+        // Checks every entry of the table: anything that writes code takes some cycles and has at most
+        // a two-byte operand after it, anything else takes no cycles, and an operand in zero page is
+        // always a byte shorter and never slower than the same one outside it.
+        constexpr bool checkEncodingTable()
+        {
+            for(unsigned int command = 0; command < COMMAND_TYPE_COUNT; command++)
+            {
+                for(unsigned int receiver = 0; receiver < ARGUMENT_TYPE_COUNT; receiver++)
+                {
+                    for(unsigned int argument = 0; argument < ARGUMENT_TYPE_COUNT; argument++)
+                    {
+                        const Encoding* encodings = ENCODING_TABLE.encodings[command][receiver][argument];
+                        for(unsigned int zeroPage = 0; zeroPage < 2; zeroPage++)
+                        {
+                            const Encoding& encoding = encodings[zeroPage];
+                            if(encoding.codeSize
+                                ? encoding.action == REJECT || encoding.action == SWAP || encoding.cycles < 2
+                                    || encoding.size < encoding.codeSize || encoding.size > encoding.codeSize + 2
+                                : encoding.cycles != 0)
+                            {
+                                return false;
+                            }
+                        }
+                        if(encodings[0].action == CHECK_ZERO_PAGE
+                            && (encodings[1].size + 1 != encodings[0].size || encodings[1].cycles > encodings[0].cycles))
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        static_assert(checkEncodingTable(), "an entry of the encoding table doesn't add up");
+
+        // Returns whether an entry ends in the given byte (the last instruction's opcode, or the immediate value of
+        // a synthetic command), and has the given size and cycles in all.
+        constexpr bool encodes(Command::CommandType command, Argument::ArgumentType receiver, Argument::ArgumentType argument, bool zeroPage,
+            unsigned char opcode, unsigned int size, unsigned int cycles)
+        {
+            const Encoding& encoding = ENCODING_TABLE.encodings[command][receiver][argument][zeroPage];
+            return encoding.codeSize && encoding.code[encoding.codeSize - 1] == opcode && encoding.size == size && encoding.cycles == cycles;
+        }
+
+        // Some of each kind of entry, against the datasheet.
+        static_assert(encodes(Command::GET, Argument::A, Argument::IMMEDIATE, true, 0xA9, 2, 2), "lda #imm");
+        static_assert(encodes(Command::GET, Argument::A, Argument::DIRECT, true, 0xA5, 2, 3), "lda zp");
+        static_assert(encodes(Command::GET, Argument::A, Argument::DIRECT, false, 0xAD, 3, 4), "lda abs");
+        static_assert(encodes(Command::GET, Argument::A, Argument::INDEXED_BY_X, true, 0xB5, 2, 4), "lda zp, x");
+        static_assert(encodes(Command::GET, Argument::A, Argument::INDEXED_BY_X, false, 0xBD, 3, 4), "lda abs, x");
+        static_assert(encodes(Command::GET, Argument::A, Argument::INDEXED_BY_Y, true, 0xB9, 3, 4), "lda abs, y");
+        static_assert(encodes(Command::GET, Argument::A, Argument::ZP_INDEXED_INDIRECT, false, 0xA1, 2, 6), "lda (zp, x)");
+        static_assert(encodes(Command::GET, Argument::A, Argument::ZP_INDIRECT_INDEXED, false, 0xB1, 2, 5), "lda (zp), y");
+        static_assert(encodes(Command::PUT, Argument::A, Argument::INDEXED_BY_X, false, 0x9D, 3, 5), "sta abs, x");
+        static_assert(encodes(Command::PUT, Argument::A, Argument::INDEXED_BY_Y, false, 0x99, 3, 5), "sta abs, y");
+        static_assert(encodes(Command::PUT, Argument::A, Argument::ZP_INDIRECT_INDEXED, false, 0x91, 2, 6), "sta (zp), y");
+        static_assert(encodes(Command::GET, Argument::X, Argument::INDEXED_BY_Y, true, 0xB6, 2, 4), "ldx zp, y");
+        static_assert(encodes(Command::GET, Argument::X, Argument::INDEXED_BY_Y, false, 0xBE, 3, 4), "ldx abs, y");
+        static_assert(encodes(Command::PUT, Argument::X, Argument::INDEXED_BY_Y, false, 0x96, 2, 4), "stx zp, y");
+        static_assert(encodes(Command::PUT, Argument::Y, Argument::DIRECT, false, 0x8C, 3, 4), "sty abs");
+        static_assert(encodes(Command::GET, Argument::S, Argument::X, false, 0x9A, 1, 2), "txs");
+        static_assert(encodes(Command::CMP, Argument::A, Argument::INDEXED_BY_Y, false, 0xD9, 3, 4), "cmp abs, y");
+        static_assert(encodes(Command::CMP, Argument::Y, Argument::IMMEDIATE, false, 0xC0, 2, 2), "cpy #imm");
+        static_assert(encodes(Command::BIT, Argument::A, Argument::DIRECT, false, 0x2C, 3, 4), "bit abs");
+        static_assert(encodes(Command::ADD, Argument::A, Argument::IMMEDIATE, false, 0x69, 3, 4), "clc, adc #imm");
+        static_assert(encodes(Command::SUB, Argument::A, Argument::DIRECT, false, 0xED, 4, 6), "sec, sbc abs");
+        static_assert(encodes(Command::INC, Argument::X, Argument::INVALID, false, 0xE8, 1, 2), "inx");
+        static_assert(encodes(Command::INC, Argument::DIRECT, Argument::INVALID, true, 0xE6, 2, 5), "inc zp");
+        static_assert(encodes(Command::DEC, Argument::INDEXED_BY_X, Argument::INVALID, false, 0xDE, 3, 7), "dec abs, x");
+        static_assert(encodes(Command::SHL, Argument::A, Argument::INVALID, false, 0x0A, 1, 2), "asl a");
+        static_assert(encodes(Command::ROR, Argument::INDEXED_BY_X, Argument::INVALID, true, 0x76, 2, 6), "ror zp, x");
+        static_assert(encodes(Command::NOT, Argument::A, Argument::INVALID, false, 0xFF, 2, 2), "eor #0xff");
+        static_assert(encodes(Command::NEG, Argument::A, Argument::INVALID, false, 0x01, 5, 6), "clc, eor #0xff, adc #0x01");
+        static_assert(encodes(Command::PUSH, Argument::A, Argument::INVALID, false, 0x48, 1, 3), "pha");
+        static_assert(encodes(Command::PULL, Argument::A, Argument::INVALID, false, 0x68, 1, 4), "pla");
+        static_assert(encodes(Command::PULL, Argument::P, Argument::INVALID, false, 0x28, 1, 4), "plp");
+        static_assert(encodes(Command::UNSET, Argument::P, Argument::OVERFLOW, false, 0xB8, 1, 2), "clv");
+    }
+
     Command::Command(CommandType commandType, SourcePosition* sourcePosition)
         : Node(sourcePosition), commandType(commandType), argument(0)
     {
@@ -16,19 +529,14 @@ namespace nel
     {
         init();
     }
-    
-    Command::~Command()
-    {
-        delete argument;
-    }
- 
+
     void Command::init()
     {
         oldCommandType = INVALID;
         receiver = 0;
     }
-    
-    void Command::commandError(std::string msg)
+
+    void Command::commandError(CompilationContext& context, std::string msg)
     {
         std::ostringstream os;
         os << "invalid `" << getCommandName(commandType) << "` command";
@@ -37,965 +545,88 @@ namespace nel
             os << " (converted from `M: " << getCommandName(oldCommandType) << " argument`)";
         }
         os << ": " << msg;
-        error(os.str(), getSourcePosition());
+        error(context, os.str(), getSourcePosition());
+    }
+
+    void Command::resolve(CompilationContext& context)
+    {
+        if(argument)
+        {
+            argument->resolve(context);
+        }
     }
-    
-    unsigned int Command::calculateSize()
+
+    Argument* Command::getOperand()
+    {
+        // At most one of the two is a memory term, once a command is sized.
+        if(receiver->isMemoryTerm())
+        {
+            return receiver;
+        }
+        return argument && argument->isMemoryTerm() ? argument : 0;
+    }
+
+    unsigned int Command::calculateSize(CompilationContext& context)
     {
         // Not possible by any command, and this prevents an infinite recursion
         // in some statements like get which convert 'M: get src' into 'src: put M'.
         if(receiver && receiver->isMemoryTerm() && argument && argument->isMemoryTerm())
         {
-            commandError("receiver and argument cannot both be memory terms.");
+            commandError(context, "receiver and argument cannot both be memory terms.");
             return 0;
         }
-        
-        unsigned int size = 0;
 
-        switch(commandType)
+        Argument::ArgumentType argumentType = argument ? argument->getArgumentType() : Argument::INVALID;
+        const Encoding* encodings = ENCODING_TABLE.encodings[commandType][receiver->getArgumentType()][argumentType];
+        Argument* operand = getOperand();
+        switch(encodings[0].action)
         {
-            case GET:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                            case Argument::Y:
-                                size = 1;
-                                break;
-                            case Argument::IMMEDIATE:
-                            case Argument::ZP_INDEXED_INDIRECT:
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                            case Argument::INDEXED_BY_X:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                size = 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `a`, then the argument must be the register `x` or `y`, an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]");
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                            case Argument::S:
-                                size = 1;
-                                break;
-                            case Argument::IMMEDIATE:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                            case Argument::INDEXED_BY_Y:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `x`, then the argument must be the register `a` or `s`, an immediate value #foo, or a direct memory term of form @foo or @foo[y]");
-                                break;
-                        }
-                        break;
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                size = 1;
-                                break;
-                            case Argument::IMMEDIATE:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                            case Argument::INDEXED_BY_X:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `y`, then the argument must be the register `a`, an immediate value #foo, or a direct memory term of form @foo or @foo[x]");
-                                break;
-                        }
-                        break;
-                    case Argument::S:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                size = 1;
-                                break;
-                            default:
-                                commandError("if receiver is the register `x`, then the argument must be `x`");
-                                break;
-                        }
-                        break;
-                    case Argument::DIRECT:
-                    case Argument::INDEXED_BY_X:
-                    case Argument::INDEXED_BY_Y:
-                    case Argument::ZP_INDEXED_INDIRECT:
-                    case Argument::ZP_INDIRECT_INDEXED:
-                    {
-                        // Swap receiver and argument, and make this a put.
-                        Argument* temp = receiver;
-                        receiver = argument;
-                        argument = temp;
-                        
-                        oldCommandType = commandType;
-                        commandType = PUT;
-                        // Recursive call to repeat instruction size selection.
-                        // Thankfully only one-deep.
-                        return calculateSize();
-                    }
-                    default:
-                        commandError("receiver must be the register `a`, `x`, `y`, or `s`, or some memory term that is not an immediate value");
-                        break;
-                }
-                break;  
-            case PUT:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                            case Argument::Y:
-                                size = 1;
-                                break;
-                            case Argument::ZP_INDEXED_INDIRECT:
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                            case Argument::INDEXED_BY_X:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                size = 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `a`, then the argument must be the register `x` or `y`, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]");
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                            case Argument::S:
-                                size = 1;
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                // Assume zero-page since there is no absolute direct-index mode for stx.
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `x`, then the argument must be the register `a` or `s`, or a direct memory term of form @foo or @foo[y]");
-                                break;
-                        }
-                        break;
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                size = 1;
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                // Assume zero-page since there is no absolute direct-index mode for sty.
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `y`, then the argument must be the register `a`, or a direct memory term of form @foo or @foo[x]");
-                                break;
-                        }
-                        break;
-                    case Argument::S:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                size = 1;
-                                break;
-                            default:
-                                commandError("if receiver is the register `x`, then the argument must be `x`");
-                                break;
-                        }
-                        break;
-                    case Argument::IMMEDIATE:
-                    case Argument::DIRECT:
-                    case Argument::INDEXED_BY_X:
-                    case Argument::INDEXED_BY_Y:
-                    case Argument::ZP_INDEXED_INDIRECT:
-                    case Argument::ZP_INDIRECT_INDEXED:
-                    {
-                        // Swap receiver and argument, and make this a get.
-                        Argument* temp = receiver;
-                        receiver = argument;
-                        argument = temp;
-                        
-                        oldCommandType = commandType;
-                        commandType = GET;
-                        // Recursive call to repeat instruction size selection.
-                        // Thankfully only one-deep.
-                        return calculateSize();
-                    }
-                    default:
-                        commandError("receiver must be the register `a`, `x`, `y`, or `s`, or some memory term");
-                        break;
-                }
-                break;
-            case CMP:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::IMMEDIATE:
-                            case Argument::ZP_INDEXED_INDIRECT:
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                            case Argument::INDEXED_BY_X:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                size = 3;
-                                break;
-                            default:
-                                commandError("if receiver is the register `a`, then the argument must be an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]");
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::IMMEDIATE:
-                                argument->forceZeroPage();
-                                size = 2;
-                                break;
-                            case Argument::DIRECT:
-                                argument->checkForZeroPage();
-                                size = argument->isZeroPage() ? 2 : 3;
-                                break;
-                            default:
-                                commandError("if receiver is an index register, then the argument must be an immediate value #foo, or a direct memory term of form @foo");
-                                break;
-                        }
-                        break;
-                    default:
-                        commandError("receiver must be the register `a`, `x`, or `y`.");
-                        break;
-                }
-                break;
-            case ADD:
-            case ADDC:
-            case SUB:
-            case SUBC:
-            case BITWISE_OR:
-            case BITWISE_AND:
-            case BITWISE_XOR:
-                if(receiver->getArgumentType() == Argument::A)
-                {
-                    switch(argument->getArgumentType())
-                    {
-                        case Argument::IMMEDIATE:
-                        case Argument::ZP_INDEXED_INDIRECT:
-                        case Argument::ZP_INDIRECT_INDEXED:
-                            argument->forceZeroPage();
-                            size = 2;
-                            break;
-                        case Argument::DIRECT:
-                        case Argument::INDEXED_BY_X:
-                            argument->checkForZeroPage();
-                            size = argument->isZeroPage() ? 2 : 3;
-                            break;
-                        case Argument::INDEXED_BY_Y:
-                            size = 3;
-                            break;
-                        default:
-                            commandError("argument must be an immediate value #foo, a direct memory term of form @foo, @foo[x] or @foo[y], or an indirect term of form @[foo[x]] or @[foo][y]");
-                            break;
-                    }
-                    if(commandType == ADD || commandType == SUB)
-                    {
-                        // add size of clc / sec {+1}
-                        size += 1;
-                    }
-                }
-                else
-                {
-                    commandError("receiver must be the register `a`.");
-                }
-                break;
-            case BIT:
-                if(receiver->getArgumentType() == Argument::A)
-                {
-                    switch(argument->getArgumentType())
-                    {
-                        case Argument::DIRECT:
-                            argument->checkForZeroPage();
-                            size = argument->isZeroPage() ? 2 : 3;
-                            break;
-                        default:
-                            commandError("argument must be a direct memory term of form @foo");
-                            break;
-                    }
-                }
-                else
-                {
-                    commandError("receiver must be the register `a`.");
-                }
-                break;
-            // This has X, Y or a memory term as a receiver. No argument.
-            case INC:
-            case DEC:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::X:
-                    case Argument::Y:
-                        size = 1;
-                        break;
-                    case Argument::DIRECT:
-                    case Argument::INDEXED_BY_X:
-                        receiver->checkForZeroPage();
-                        size = receiver->isZeroPage() ? 2 : 3;
-                        break;
-                    default:
-                        commandError("receiver must be the register `x`, register `y`, or a direct memory term of form @foo, or @foo[x].");
-                        break;
-                }
-                break;
-            // This has A as a receiver. No argument.
-            case NOT:
-                if(receiver->getArgumentType() == Argument::A)
-                {
-                    // size of eor #0xff {+2}
-                    size = 2;
-                }
-                else
-                {
-                    commandError("receiver must be the register `a`.");
-                }
-                break;
-            // This has A as a receiver. No argument.
-            case NEG:
-                if(receiver->getArgumentType() == Argument::A)
-                {
-                    // size of clc {+1}, eor #0xff {+2}, adc #01 {+2}
-                    size = 5;
-                }
-                else
-                {
-                    commandError("receiver must be the register `a`.");
-                }
-                break;
-            // These have A or a memory term as a receiver. No argument.
-            case SHL:
-            case SHR:
-            case ROL:
-            case ROR:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        size = 1;
-                        break;
-                    case Argument::DIRECT:
-                    case Argument::INDEXED_BY_X:
-                        receiver->checkForZeroPage();
-                        size = receiver->isZeroPage() ? 2 : 3;
-                        break;
-                    default:
-                        commandError("receiver must be the register `a`, or a direct memory term of form @expr, or @expr[x].");
-                        break;
-                }
-                break;
-            // These have A or P as a receiver.
-            case PUSH:
-            case PULL:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                    case Argument::P:
-                        size = 1;
-                        break;
-                    default:
-                        commandError("receiver must be the register `a` or `p`.");
-                        break;
-                }
-                break;
-            // These require a p-flag argument (error if there is none)
-            case SET:
-                if(receiver->getArgumentType() == Argument::P)
-                {
-                    switch(argument->getArgumentType())
-                    {
-                        case Argument::CARRY:
-                        case Argument::INTERRUPT:
-                        case Argument::DECIMAL:
-                            size = 1;
-                            break;
-                        default:
-                            commandError("argument must be the p-flag `carry`, `interrupt`, or `decimal`.");
-                            break;
-                    }
-                }
-                else
-                {
-                    commandError("receiver must be the register `p`.");
-                }
+            case REJECT:
+                commandError(context, MESSAGES[encodings[0].message]);
+                return encodings[0].size;
+            case SWAP:
+            {
+                // Swap receiver and argument, and make this a put or a get.
+                Argument* temp = receiver;
+                receiver = argument;
+                argument = temp;
+
+                oldCommandType = commandType;
+                commandType = commandType == GET ? PUT : GET;
+                // Recursive call to repeat instruction size selection.
+                // Thankfully only one-deep.
+                return calculateSize(context);
+            }
+            case FORCE_ZERO_PAGE:
+                operand->forceZeroPage();
                 break;
-            case UNSET:
-                if(receiver->getArgumentType() == Argument::P)
-                {
-                    switch(argument->getArgumentType())
-                    {
-                        case Argument::CARRY:
-                        case Argument::INTERRUPT:
-                        case Argument::DECIMAL:
-                        case Argument::OVERFLOW:
-                            size = 1;
-                            break;
-                        default:
-                            commandError("argument must be the p-flag `carry`, `interrupt`, `decimal`, or `overflow`.");
-                            break;
-                    }
-                }
-                else
-                {
-                    commandError("receiver must be the register `p`.");
-                }
+            case CHECK_ZERO_PAGE:
+                operand->checkForZeroPage(context);
                 break;
         }
-        return size;
+        return encodings[operand && operand->isZeroPage()].size;
     }
-    
-    void Command::write(RomBank* bank)
+
+    void Command::write(CompilationContext& context, RomBank* bank)
     {
-        bool defaultAssembly = true;
-        unsigned int opcode = 0;
-        switch(commandType)
+        Argument* operand = getOperand();
+        Argument::ArgumentType argumentType = argument ? argument->getArgumentType() : Argument::INVALID;
+        const Encoding& encoding = ENCODING_TABLE.encodings[commandType][receiver->getArgumentType()][argumentType][operand && operand->isZeroPage()];
+        if(encoding.action == REJECT || !encoding.codeSize)
         {
-            case GET:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                opcode = 0x8A; // txa
-                                break;
-                            case Argument::Y:
-                                opcode = 0x98; // tya
-                                break;
-                            case Argument::IMMEDIATE:
-                                opcode = 0xA9; // lda #imm
-                                break;
-                            case Argument::ZP_INDEXED_INDIRECT:
-                                opcode = 0xA1; // lda [mem, x]
-                                break;
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                opcode = 0xB1; // lda [mem], y
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xA5 : 0xAD; // lda mem
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                opcode = argument->isZeroPage() ? 0xB5 : 0xBD; // lda mem, x
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                opcode = 0xB9; // lda mem, y
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                opcode = 0xAA; // tax
-                                break;
-                            case Argument::S:
-                                opcode = 0xBA; // tsx
-                                break;
-                            case Argument::IMMEDIATE:
-                                opcode = 0xA2; // ldx #imm
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xA6 : 0xAE; // ldx mem
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                opcode = argument->isZeroPage() ? 0xB4 : 0xBE; // ldx mem, y
-                                break;
-                        }
-                        break;
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                opcode = 0xA8; // tay
-                                break;
-                            case Argument::IMMEDIATE:
-                                opcode = 0xA0; // ldy #imm
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xA4 : 0xAC; // ldy mem
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                opcode = argument->isZeroPage() ? 0xB4 : 0xBC; // ldy mem, x
-                                break;
-                        }
-                        break;
-                    case Argument::S:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                opcode = 0x9A; // txs
-                                break;
-                        }
-                        break;
-                }
-                break;
-            case PUT:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                opcode = 0xAA; // tax
-                                break;
-                            case Argument::Y:
-                                opcode = 0xA8; // tay
-                                break;
-                            case Argument::ZP_INDEXED_INDIRECT:
-                                opcode = 0x81; // sta [mem, x]
-                                break;
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                opcode = 0x91; // sta [mem], y
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0x85: 0x8D; // sta mem
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                opcode = argument->isZeroPage() ? 0x95: 0x9D; // sta mem, x
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                opcode = 0x99; // sta mem, y
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                opcode = 0x8A; // txa
-                                break;
-                            case Argument::S:
-                                opcode = 0x9A; // txs
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                opcode = 0x96; // stx zp, y
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0x86 : 0x8E; // stx mem
-                                break;
-                        }
-                        break;
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::A:
-                                opcode = 0x98; // tya
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                opcode = 0x94; // sty zp, x
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0x84 : 0x8C; // sty mem
-                                break;
-                        }
-                        break;
-                    case Argument::S:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::X:
-                                opcode = 0xBA; // tsx
-                                break;
-                        }
-                        break;
-                }
-                break;
-            case CMP:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::IMMEDIATE:
-                                opcode = 0xC9; // cmp #imm
-                                break;
-                            case Argument::ZP_INDEXED_INDIRECT:
-                                opcode = 0xC1; // cmp [mem, x]
-                                break;
-                            case Argument::ZP_INDIRECT_INDEXED:
-                                opcode = 0xD1; // cmp [mem], y
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xC5 : 0xCD; // cmp mem
-                                break;
-                            case Argument::INDEXED_BY_X:
-                                opcode = argument->isZeroPage() ? 0xD5 : 0xDD; // cmp mem, x
-                                break;
-                            case Argument::INDEXED_BY_Y:
-                                opcode = 0xD1; // cmp mem, y
-                                break;
-                        }
-                        break;
-                    case Argument::X:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::IMMEDIATE:
-                                opcode = 0xE0; // cpx #imm
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xE4 : 0xEC; // cpx mem
-                                break;
-                        }
-                        break;
-                    case Argument::Y:
-                        switch(argument->getArgumentType())
-                        {
-                            case Argument::IMMEDIATE:
-                                opcode = 0xC0; // cpy #imm
-                                break;
-                            case Argument::DIRECT:
-                                opcode = argument->isZeroPage() ? 0xC4 : 0xCC; // cpy mem
-                                break;
-                        }
-                        break;
-                }
-                break;
-            case ADD:
-                bank->writeByte(0x18, getSourcePosition()); // clc
-                // fallthrough for adc
-            case ADDC:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::IMMEDIATE:
-                        opcode = 0x69; // adc #imm
-                        break;
-                    case Argument::ZP_INDEXED_INDIRECT:
-                        opcode = 0x61; // adc [mem, x]
-                        break;
-                    case Argument::ZP_INDIRECT_INDEXED:
-                        opcode = 0x71; // adc [mem], y
-                        break;
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0x65 : 0x6D; // adc mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = argument->isZeroPage() ? 0x75 : 0x7D; // adc mem, x
-                        break;
-                    case Argument::INDEXED_BY_Y:
-                        opcode = 0x79; // adc mem, y
-                        break;
-                }
-                break;
-            case SUB:
-                bank->writeByte(0x38, getSourcePosition()); // secc
-                // fallthrough for sbc
-            case SUBC:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::IMMEDIATE:
-                        opcode = 0xE9; // sbc #imm
-                        break;
-                    case Argument::ZP_INDEXED_INDIRECT:
-                        opcode = 0xE1; // sbc [mem, x]
-                        break;
-                    case Argument::ZP_INDIRECT_INDEXED:
-                        opcode = 0xF1; // sbc [mem], y
-                        break;
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0xE5 : 0xED; // sbc mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = argument->isZeroPage() ? 0xF5 : 0xFD; // sbc mem, x
-                        break;
-                    case Argument::INDEXED_BY_Y:
-                        opcode = 0xF9; // sbc mem, y
-                        break;
-                }
-                break;
-            case BITWISE_OR:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::IMMEDIATE:
-                        opcode = 0x09; // ora #imm
-                        break;
-                    case Argument::ZP_INDEXED_INDIRECT:
-                        opcode = 0x01; // ora [mem, x]
-                        break;
-                    case Argument::ZP_INDIRECT_INDEXED:
-                        opcode = 0x11; // ora [mem], y
-                        break;
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0x05 : 0x0D; // ora mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = argument->isZeroPage() ? 0x15 : 0x1D; // ora mem, x
-                        break;
-                    case Argument::INDEXED_BY_Y:
-                        opcode = 0x19; // ora mem, y
-                        break;
-                }
-                break;
-            case BITWISE_AND:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::IMMEDIATE:
-                        opcode = 0x29; // and #imm
-                        break;
-                    case Argument::ZP_INDEXED_INDIRECT:
-                        opcode = 0x21; // and [mem, x]
-                        break;
-                    case Argument::ZP_INDIRECT_INDEXED:
-                        opcode = 0x31; // and [mem], y
-                        break;
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0x25 : 0x2D; // and mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = argument->isZeroPage() ? 0x35 : 0x3D; // and mem, x
-                        break;
-                    case Argument::INDEXED_BY_Y:
-                        opcode = 0x39; // and mem, y
-                        break;
-                }
-                break;
-            case BITWISE_XOR:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::IMMEDIATE:
-                        opcode = 0x49; // eor #imm
-                        break;
-                    case Argument::ZP_INDEXED_INDIRECT:
-                        opcode = 0x41; // eor [mem, x]
-                        break;
-                    case Argument::ZP_INDIRECT_INDEXED:
-                        opcode = 0x51; // eor [mem], y
-                        break;
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0x45 : 0x4D; // eor mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = argument->isZeroPage() ? 0x55 : 0x5D; // eor mem, x
-                        break;
-                    case Argument::INDEXED_BY_Y:
-                        opcode = 0x59; // eor mem, y
-                        break;
-                }
-                break;
-            case BIT:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::DIRECT:
-                        opcode = argument->isZeroPage() ? 0x24 : 0x2C; // bit mem
-                        break;
-                }
-                break;
-            case INC:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::X:
-                        opcode = 0xE8; // inx
-                        break;
-                    case Argument::Y:
-                        opcode = 0xC8; // iny
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0xE6 : 0xEE; // inc mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0xF6 : 0xFE; // inc mem, x
-                        break;
-                }
-                break;
-            case DEC:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::X:
-                        opcode = 0xCA; // dex
-                        break;
-                    case Argument::Y:
-                        opcode = 0x88; // dey
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0xC6 : 0xCE; // dec mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0xD6 : 0xDE; // dec mem, x
-                        break;
-                }
-                break;
-            case SHL:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x0A; // asl a
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0x06 : 0x0E; // asl mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0x16 : 0x1E; // asl mem, x
-                        break;
-                }
-                break;
-            case SHR:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x4A; // lsr a
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0x46 : 0x4E; // lsr mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0x56 : 0x5E; // lsr mem, x
-                        break;
-                }
-                break;
-            case ROL:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x2A; // rol a
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0x26 : 0x2E; // rol mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0x36 : 0x3E; // rol mem, x
-                        break;
-                }
-                break;
-            case ROR:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x6A; // ror a
-                        break;
-                    case Argument::DIRECT:
-                        opcode = receiver->isZeroPage() ? 0x66 : 0x6E; // ror mem
-                        break;
-                    case Argument::INDEXED_BY_X:
-                        opcode = receiver->isZeroPage() ? 0x76 : 0x7E; // ror mem, x
-                        break;
-                }
-                break;
-            case PUSH:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x48; // pha
-                    case Argument::P:
-                        opcode = 0x08; // php
-                        break;
-                }
-                break;
-            case PULL:
-                switch(receiver->getArgumentType())
-                {
-                    case Argument::A:
-                        opcode = 0x68; // pla
-                    case Argument::P:
-                        opcode = 0x28; // plp
-                        break;
-                }
-                break;
-            case SET:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::CARRY:
-                        opcode = 0x38; // sec
-                        break;
-                    case Argument::INTERRUPT:
-                        opcode = 0x78; // sei
-                        break;
-                    case Argument::DECIMAL:
-                        opcode = 0xF8; // sed
-                        break;
-                }
-                break;
-            case UNSET:
-                switch(argument->getArgumentType())
-                {
-                    case Argument::CARRY:
-                        opcode = 0x18; // clc
-                        break;
-                    case Argument::INTERRUPT:
-                        opcode = 0x58; // cli
-                        break;
-                    case Argument::DECIMAL:
-                        opcode = 0xD8; // cld
-                        break;
-                    case Argument::OVERFLOW:
-                        opcode = 0xB8; // clv
-                        break;
-                }
-                break;
-            case NOT:
-                defaultAssembly = false;
-                bank->writeByte(0x49, getSourcePosition()); // eor #imm
-                bank->writeByte(0xFF, getSourcePosition()); // with imm = 0xff
-                break;
-            case NEG:
-                defaultAssembly = false;
-                bank->writeByte(0x18, getSourcePosition()); // clc
-                bank->writeByte(0x49, getSourcePosition()); // eor #imm
-                bank->writeByte(0xFF, getSourcePosition()); // with imm = 0xff
-                bank->writeByte(0x69, getSourcePosition()); // adc #imm
-                bank->writeByte(0x01, getSourcePosition()); // with imm = 0x01
-                break;
+            error(context, "internal: output not generated for command", getSourcePosition(), true);
+            return;
         }
-        
-        if(defaultAssembly)
+
+        for(unsigned int i = 0; i < encoding.codeSize; i++)
         {
-            if(opcode)
-            {
-                // Write opcode byte.
-                bank->writeByte(opcode, getSourcePosition());
-                // Write receiver or argument, only one of which will have non-zero size.
-                receiver->write(bank);
-                if(argument)
-                {
-                    argument->write(bank);
-                }
-            }
-            else
-            {
-                error("internal: output not generated for command", getSourcePosition(), true);
-            }
+            bank->writeByte(encoding.code[i], getSourcePosition());
+        }
+        // Write receiver or argument, only one of which will have non-zero size.
+        receiver->write(context, bank);
+        if(argument)
+        {
+            argument->write(context, bank);
         }
     }
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@
 #include "node.h"
 #include "rom_bank.h"
 #include "argument.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -95,14 +96,14 @@ namespace nel
         public:
             Command(CommandType commandType, SourcePosition* sourcePosition);
             Command(CommandType commandType, Argument* argument, SourcePosition* sourcePosition);
-            ~Command();
             
         private:
             void init();
-            void commandError(std::string msg);
+            void commandError(CompilationContext& context, std::string msg);
             unsigned int calculateGetSize(Argument* receiver, Argument* argument);
             unsigned int calculatePutSize(Argument* receiver, Argument* argument);
-            
+            Argument* getOperand();
+
         public:
             /**
              * Returns the type of command this node represents.
@@ -137,14 +138,20 @@ namespace nel
                 return argument;
             }
             
+            /**
+             * Binds the names in this command's argument to the active scope.
+             * The receiver is shared by the whole command statement, which resolves it.
+             */
+            void resolve(CompilationContext& context);
+            
             /**
              * Returns the size of the full instruction in bytes, or 0 if invalid.
              */
-            unsigned int calculateSize();
+            unsigned int calculateSize(CompilationContext& context);
             
             /**
              * Writes this command into the rom.
              */
-            void write(RomBank* bank);
+            void write(CompilationContext& context, RomBank* bank);
     };
 }
\ No newline at end of file
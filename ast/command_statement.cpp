@@ -1,6 +1,3 @@
-#include "error.h"
-#include "rom_generator.h"
-#include "rom_bank.h"
 #include "command_statement.h"
 
 namespace nel
@@ -18,56 +15,24 @@ namespace nel
             }
         }
     }
-
-    CommandStatement::~CommandStatement()
-    {
-        delete receiver;
-        delete commands;
-    }
     
-    void CommandStatement::aggregate()
+    void CommandStatement::aggregate(CompilationContext& context)
     {        
     }
 
-    void CommandStatement::validate()
+    void CommandStatement::resolve(CompilationContext& context)
     {
-        // Reserve the bytes needed for this data.
-        RomBank* bank = romGenerator->getActiveBank();
-        if(!bank)
+        if(receiver)
         {
-            error("command statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
-            return;
+            receiver->resolve(context);
         }
         
         ListNode<Command*>::ListType& list = commands->getList();
         for(size_t i = 0; i < list.size(); i++)
         {
-            Command* command = list[i];
-            if(command)
-            {
-                unsigned int size = command->calculateSize();
-                bank->expand(size, command->getSourcePosition());
-            }
-        }
-    }
-    
-    void CommandStatement::generate()
-    {
-        // Get the bank to use for writing.
-        RomBank* bank = romGenerator->getActiveBank();
-        if(!bank)
-        {
-            error("command statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
-            return;
-        }
-        
-        ListNode<Command*>::ListType& list = commands->getList();
-        for(size_t i = 0; i < list.size(); i++)
-        {
-            Command* command = list[i];
-            if(command)
+            if(list[i])
             {
-                command->write(bank);
+                list[i]->resolve(context);
             }
         }
     }
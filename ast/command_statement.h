@@ -18,7 +18,6 @@ namespace nel
             
         public:    
             CommandStatement(Argument* receiver, ListNode<Command*>* commands, SourcePosition* sourcePosition);
-            ~CommandStatement();
             
             /**
              * Returns the receiver of the commands in this statement.
@@ -36,8 +35,7 @@ namespace nel
                 return commands;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
     };
 }
\ No newline at end of file
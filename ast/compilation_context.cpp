@@ -0,0 +1,106 @@
+#include "source_buffer.h"
+#include "rom_generator.h"
+#include "symbol_table.h"
+#include "block_statement.h"
+#include "lowered_program.h"
+#include "statistics.h"
+#include "trace_recorder.h"
+#include "compilation_context.h"
+
+namespace nel
+{
+    CompilationContext::CompilationContext(std::ostream& log)
+        : log(&log), errorCount(0), statistics(0), traceRecorder(0), fileCache(0), buildCache(0), mapSourceFiles(true), parseJobs(0),
+        romGenerator(0), builtins(0), activeScope(0), startNode(0), loweredProgram(0)
+    {
+        // Built up front, since threads parsing required files look up builtins as they go.
+        // The definitions belong to this compilation, whichever arena the caller allocates from.
+        Arena* previous = Arena::getCurrent();
+        Arena::setCurrent(&arena);
+        builtins = SymbolTable::createBuiltins();
+        Arena::setCurrent(previous);
+    }
+
+    CompilationContext::~CompilationContext()
+    {
+        delete loweredProgram;
+        delete romGenerator;
+        delete builtins;
+        delete statistics;
+        delete traceRecorder;
+
+        for(size_t i = 0; i < sourceBuffers.size(); i++)
+        {
+            delete sourceBuffers[i];
+        }
+        for(size_t i = 0; i < helperArenas.size(); i++)
+        {
+            delete helperArenas[i];
+        }
+    }
+
+    Arena* CompilationContext::addArena()
+    {
+        Arena* helperArena = new Arena();
+        helperArenas.push_back(helperArena);
+        return helperArena;
+    }
+
+    void CompilationContext::setStatistics(Statistics* value)
+    {
+        delete statistics;
+        statistics = value;
+    }
+
+    void CompilationContext::setTraceRecorder(TraceRecorder* value)
+    {
+        delete traceRecorder;
+        traceRecorder = value;
+    }
+
+    void CompilationContext::setRomGenerator(RomGenerator* value)
+    {
+        delete romGenerator;
+        romGenerator = value;
+    }
+
+    void CompilationContext::setLoweredProgram(LoweredProgram* value)
+    {
+        delete loweredProgram;
+        loweredProgram = value;
+    }
+
+    SourcePosition CompilationContext::addSourceFile(const std::string& filename, SourceBuffer* buffer, const SourcePosition& includePoint)
+    {
+        std::lock_guard<std::mutex> lock(sourceFileMutex);
+        sourceBuffers.push_back(buffer);
+        sourceFiles.push_back(SourceFile(filename, buffer, includePoint));
+        return SourcePosition(sourceFiles.size());
+    }
+
+    SourceFile* CompilationContext::getSourceFile(unsigned int file)
+    {
+        std::lock_guard<std::mutex> lock(sourceFileMutex);
+        return file > 0 && file <= sourceFiles.size() ? &sourceFiles[file - 1] : 0;
+    }
+
+    void CompilationContext::enterScope(SymbolTable* symbolTable)
+    {
+        scopeStack.push_back(symbolTable);
+        activeScope = symbolTable;
+    }
+
+    void CompilationContext::exitScope()
+    {
+        scopeStack.pop_back();
+
+        if(scopeStack.size() > 0)
+        {
+            activeScope = scopeStack[scopeStack.size() - 1];
+        }
+        else
+        {
+            activeScope = 0;
+        }
+    }
+}
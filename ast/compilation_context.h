@@ -0,0 +1,321 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <iostream>
+
+#include "arena.h"
+#include "source_file.h"
+#include "source_position.h"
+
+namespace nel
+{
+    class SymbolTable;
+    class RomGenerator;
+    class BlockStatement;
+    class LoweredProgram;
+    class Statistics;
+    class TraceRecorder;
+    class SourceBuffer;
+    class FileCache;
+    class BuildCache;
+
+    /**
+     * All of the state belonging to a single compilation, from the
+     * files that make up its source, to the scopes used by the semantic passes,
+     * to the generated ROM itself. The state of the parse that reads those
+     * files is kept apart, in a ParserContext.
+     *
+     * Nothing about a compilation lives outside of its context, so several
+     * contexts may be compiled at once within the same process.
+     */
+    class CompilationContext
+    {
+        private:
+            // Holds the AST and definitions, which are freed along with the context.
+            // Declared first, so that it outlives everything else here.
+            Arena arena;
+            // Arenas for other threads working on this compilation, such as those parsing required files.
+            std::vector<Arena*> helperArenas;
+            // Where diagnostics and progress messages are written.
+            std::ostream* log;
+            // The number of errors reported so far.
+            unsigned int errorCount;
+            // Timings and counters, or 0 if they aren't being gathered.
+            Statistics* statistics;
+            // Records spans for --trace, or 0 if this compilation isn't being traced.
+            TraceRecorder* traceRecorder;
+            // Keeps the contents of files between compilations, or 0 if files are read every time.
+            FileCache* fileCache;
+            // Where finished builds and precompiled packages are kept between compilations, or 0 if they aren't.
+            BuildCache* buildCache;
+            // Whether source files are mapped into memory, rather than read through stdio.
+            bool mapSourceFiles;
+            // How many threads required files may be parsed with, or 0 for one per core.
+            unsigned int parseJobs;
+
+            // The ROM being generated. Created by the ines header on the first pass.
+            RomGenerator* romGenerator;
+
+            // Contains the builtins. Created along with the context, and only read after that.
+            SymbolTable* builtins;
+            // Scope used for constants, variables and label declarations.
+            // The current top of the scopeStack.
+            SymbolTable* activeScope;
+            // A stack of all depths of active scopes.
+            // Necessary for checking when a label is declared outside of the current scope
+            // (but contained by an outer scope the inner scope can reference).
+            std::vector<SymbolTable*> scopeStack;
+
+            // Every file read by this compilation. A position's file is an index into this, starting from 1.
+            // Files are added and looked up by every thread parsing for this compilation, so it's guarded.
+            std::deque<SourceFile> sourceFiles;
+            std::mutex sourceFileMutex;
+            // The text of every file in the file table, freed when the context is destroyed.
+            std::vector<SourceBuffer*> sourceBuffers;
+            // The start node of the program. Set on a successful parse.
+            BlockStatement* startNode;
+            // The program flattened out of the start node for the later passes. Created at the start of the second pass.
+            LoweredProgram* loweredProgram;
+            // The files embedded into the ROM, as the first pass finds them.
+            std::vector<std::string> embeddedFiles;
+
+        public:
+            CompilationContext(std::ostream& log = std::cerr);
+            ~CompilationContext();
+
+        private:
+            // Contexts own their AST and ROM, so they can't be copied.
+            CompilationContext(const CompilationContext&);
+            CompilationContext& operator=(const CompilationContext&);
+
+        public:
+            /**
+             * Returns the arena that this compilation's AST and definitions are allocated from.
+             */
+            Arena& getArena()
+            {
+                return arena;
+            }
+
+            /**
+             * Creates another arena, for a thread helping with this compilation to allocate from.
+             * It's freed along with the context. Not safe to call from several threads at once.
+             */
+            Arena* addArena();
+
+            /**
+             * Returns the stream that diagnostics for this compilation are written to.
+             */
+            std::ostream& getLog()
+            {
+                return *log;
+            }
+
+            /**
+             * Returns the number of errors reported so far.
+             */
+            unsigned int getErrorCount()
+            {
+                return errorCount;
+            }
+
+            /**
+             * Records that another error was reported, and returns the new count.
+             */
+            unsigned int incrementErrorCount()
+            {
+                return ++errorCount;
+            }
+
+            /**
+             * Returns the statistics gathered for this compilation, or 0 if none are.
+             */
+            Statistics* getStatistics()
+            {
+                return statistics;
+            }
+
+            /**
+             * Sets the statistics to gather for this compilation. The context takes ownership of them.
+             */
+            void setStatistics(Statistics* value);
+
+            /**
+             * Returns the recorder tracing this compilation, or 0 if it isn't being traced.
+             */
+            TraceRecorder* getTraceRecorder()
+            {
+                return traceRecorder;
+            }
+
+            /**
+             * Sets the recorder to trace this compilation with. The context takes ownership of it.
+             */
+            void setTraceRecorder(TraceRecorder* value);
+
+            /**
+             * Returns the cache that files other than the source are read through, or 0 if there isn't one.
+             */
+            FileCache* getFileCache()
+            {
+                return fileCache;
+            }
+
+            /**
+             * Sets the cache that files other than the source are read through.
+             * It's shared with other compilations, so the context doesn't own it.
+             */
+            void setFileCache(FileCache* value)
+            {
+                fileCache = value;
+            }
+
+            /**
+             * Returns the cache that precompiled packages of required files are looked for in, or 0 if there isn't one.
+             */
+            BuildCache* getBuildCache()
+            {
+                return buildCache;
+            }
+
+            /**
+             * Sets the cache that precompiled packages of required files are looked for in.
+             * It's shared with other compilations, so the context doesn't own it.
+             */
+            void setBuildCache(BuildCache* value)
+            {
+                buildCache = value;
+            }
+
+            /**
+             * Returns whether source files are mapped into memory, rather than read through stdio. They are by default.
+             */
+            bool getMapSourceFiles()
+            {
+                return mapSourceFiles;
+            }
+
+            /**
+             * Sets whether source files are mapped into memory, rather than read through stdio.
+             */
+            void setMapSourceFiles(bool value)
+            {
+                mapSourceFiles = value;
+            }
+
+            /**
+             * Returns how many threads required files may be parsed with, or 0 for one per core, which is the default.
+             */
+            unsigned int getParseJobs()
+            {
+                return parseJobs;
+            }
+
+            /**
+             * Sets how many threads required files may be parsed with, or 0 for one per core.
+             */
+            void setParseJobs(unsigned int value)
+            {
+                parseJobs = value;
+            }
+
+            /**
+             * Returns the ROM being generated, or 0 if the header hasn't been handled yet.
+             */
+            RomGenerator* getRomGenerator()
+            {
+                return romGenerator;
+            }
+
+            /**
+             * Sets the ROM being generated. The context takes ownership of it.
+             */
+            void setRomGenerator(RomGenerator* value);
+
+            /**
+             * Get the symbol table containing the built-in definitions.
+             */
+            SymbolTable* getBuiltins()
+            {
+                return builtins;
+            }
+
+            /**
+             * Get the active scope containing user-supplied definitions.
+             */
+            SymbolTable* getActiveScope()
+            {
+                return activeScope;
+            }
+
+            /**
+             * Enters a new scope level, pushing it onto the scope stack.
+             */
+            void enterScope(SymbolTable* symbolTable);
+
+            /**
+             * Exits the current scope level, returning to its parent scope.
+             */
+            void exitScope();
+
+            /**
+             * Adds a file to the file table, taking ownership of its text,
+             * and returns the position at its start. Safe to call from any thread.
+             */
+            SourcePosition addSourceFile(const std::string& filename, SourceBuffer* buffer, const SourcePosition& includePoint = SourcePosition());
+
+            /**
+             * Returns the file at an index in the file table, or 0 if there isn't one.
+             * Safe to call from any thread, and the file stays put as others are added.
+             */
+            SourceFile* getSourceFile(unsigned int file);
+
+            /**
+             * Returns the start node of the program, or 0 if it hasn't been parsed.
+             */
+            BlockStatement* getStartNode()
+            {
+                return startNode;
+            }
+
+            /**
+             * Sets the start node of the program, which lives in the context's arena.
+             */
+            void setStartNode(BlockStatement* value)
+            {
+                startNode = value;
+            }
+
+            /**
+             * Returns the program as flattened for the second and third passes, or 0 if it hasn't been yet.
+             */
+            LoweredProgram* getLoweredProgram()
+            {
+                return loweredProgram;
+            }
+
+            /**
+             * Sets the flattened program. The context takes ownership of it.
+             */
+            void setLoweredProgram(LoweredProgram* value);
+
+            /**
+             * Returns the files embedded into the ROM, so far as the first pass has found them.
+             */
+            const std::vector<std::string>& getEmbeddedFiles()
+            {
+                return embeddedFiles;
+            }
+
+            /**
+             * Records a file that's embedded into the ROM.
+             */
+            void addEmbeddedFile(const std::string& filename)
+            {
+                embeddedFiles.push_back(filename);
+            }
+    };
+}
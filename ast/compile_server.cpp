@@ -0,0 +1,292 @@
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+// Elsewhere, SIGPIPE is ignored instead.
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+#include "error.h"
+#include "compile_server.h"
+
+namespace nel
+{
+#if defined(_WIN32)
+    bool CompileServer::serve(const std::string& socketPath, const Handler& handler, std::ostream& log)
+    {
+        log << "* " << PROGRAM_NAME << ": a compile server isn't supported on this platform." << std::endl;
+        return false;
+    }
+
+    bool CompileServer::forward(const std::string& socketPath, const std::vector<std::string>& args,
+        std::ostream& err, std::ostream& out, int& status)
+    {
+        return false;
+    }
+#else
+    namespace
+    {
+        // Nothing sent is ever this big, so anything that claims to be is garbage.
+        const unsigned int STRING_MAX = 1 << 24;
+        const unsigned int COUNT_MAX = 1 << 16;
+        // Clients are served one at a time, so one that stalls for this long is dropped rather than waited on.
+        const unsigned int CLIENT_TIMEOUT_SECONDS = 5;
+
+        bool sendAll(int fd, const std::string& data)
+        {
+            size_t sent = 0;
+            while(sent < data.size())
+            {
+                ssize_t count = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if(count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(count <= 0)
+                {
+                    return false;
+                }
+                sent += count;
+            }
+            return true;
+        }
+
+        bool receiveAll(int fd, char* data, size_t size)
+        {
+            size_t received = 0;
+            while(received < size)
+            {
+                ssize_t count = recv(fd, data + received, size - received, 0);
+                if(count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(count <= 0)
+                {
+                    return false;
+                }
+                received += count;
+            }
+            return true;
+        }
+
+        void putU32(std::string& output, unsigned int value)
+        {
+            for(unsigned int i = 0; i < 4; i++)
+            {
+                output += (char) ((value >> (i * 8)) & 0xFF);
+            }
+        }
+
+        void putString(std::string& output, const std::string& value)
+        {
+            putU32(output, value.size());
+            output += value;
+        }
+
+        bool receiveU32(int fd, unsigned int& value)
+        {
+            unsigned char bytes[4];
+            if(!receiveAll(fd, (char*) bytes, sizeof(bytes)))
+            {
+                return false;
+            }
+            value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int) bytes[3] << 24);
+            return true;
+        }
+
+        bool receiveString(int fd, std::string& value)
+        {
+            unsigned int size;
+            if(!receiveU32(fd, size) || size > STRING_MAX)
+            {
+                return false;
+            }
+            value.resize(size);
+            return !size || receiveAll(fd, &value[0], size);
+        }
+
+        // Fills in the address of a socket, or returns false if the path is too long for one.
+        bool getAddress(const std::string& socketPath, sockaddr_un& address)
+        {
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if(socketPath.size() >= sizeof(address.sun_path))
+            {
+                return false;
+            }
+            memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+            return true;
+        }
+
+        // Connects to a socket, returning the descriptor, or -1 if nobody's listening there.
+        int connectTo(const std::string& socketPath)
+        {
+            sockaddr_un address;
+            if(!getAddress(socketPath, address))
+            {
+                return -1;
+            }
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if(fd < 0)
+            {
+                return -1;
+            }
+            if(connect(fd, (sockaddr*) &address, sizeof(address)) != 0)
+            {
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+        // Reads a command line from a client and sends back how it went.
+        void handleClient(int fd, const CompileServer::Handler& handler, const std::string& directory)
+        {
+            unsigned int count;
+            if(!receiveU32(fd, count) || count < 1 || count > COUNT_MAX)
+            {
+                return;
+            }
+            std::string workingDirectory;
+            std::vector<std::string> args(count - 1);
+            if(!receiveString(fd, workingDirectory))
+            {
+                return;
+            }
+            for(unsigned int i = 0; i < args.size(); i++)
+            {
+                if(!receiveString(fd, args[i]))
+                {
+                    return;
+                }
+            }
+
+            std::ostringstream err;
+            std::ostringstream out;
+            int status = 1;
+            if(chdir(workingDirectory.c_str()) == 0)
+            {
+                status = handler(args, err, out);
+            }
+            else
+            {
+                err << "* " << PROGRAM_NAME << ": the compile server couldn't change to '" << workingDirectory << "'." << std::endl;
+            }
+            // Relative paths given to the server, like its socket, are still relative to where it started.
+            if(chdir(directory.c_str()) != 0)
+            {
+                err << "* " << PROGRAM_NAME << ": the compile server couldn't change back to '" << directory << "'." << std::endl;
+            }
+
+            std::string response;
+            putU32(response, status);
+            putString(response, err.str());
+            putString(response, out.str());
+            sendAll(fd, response);
+        }
+    }
+
+    bool CompileServer::serve(const std::string& socketPath, const Handler& handler, std::ostream& log)
+    {
+        sockaddr_un address;
+        if(!getAddress(socketPath, address))
+        {
+            log << "* " << PROGRAM_NAME << ": the socket path '" << socketPath << "' is too long." << std::endl;
+            return false;
+        }
+
+        // A socket left behind by a server that's gone is replaced, but one still in use isn't.
+        int existing = connectTo(socketPath);
+        if(existing >= 0)
+        {
+            close(existing);
+            log << "* " << PROGRAM_NAME << ": a compile server is already listening on '" << socketPath << "'." << std::endl;
+            return false;
+        }
+        unlink(socketPath.c_str());
+        // A client that goes away mid-reply shouldn't take the server with it.
+        signal(SIGPIPE, SIG_IGN);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0 || bind(fd, (sockaddr*) &address, sizeof(address)) != 0 || listen(fd, 16) != 0)
+        {
+            log << "* " << PROGRAM_NAME << ": couldn't listen on '" << socketPath << "': " << strerror(errno) << "." << std::endl;
+            if(fd >= 0)
+            {
+                close(fd);
+            }
+            return false;
+        }
+
+        char buffer[4096];
+        std::string directory = getcwd(buffer, sizeof(buffer)) ? buffer : ".";
+        log << "* " << PROGRAM_NAME << ": listening on '" << socketPath << "'." << std::endl;
+        for(;;)
+        {
+            int client = accept(fd, 0, 0);
+            if(client < 0)
+            {
+                if(errno == EINTR || errno == ECONNABORTED)
+                {
+                    continue;
+                }
+                log << "* " << PROGRAM_NAME << ": couldn't accept a connection: " << strerror(errno) << "." << std::endl;
+                close(fd);
+                return false;
+            }
+            timeval timeout = timeval();
+            timeout.tv_sec = CLIENT_TIMEOUT_SECONDS;
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            handleClient(client, handler, directory);
+            close(client);
+        }
+    }
+
+    bool CompileServer::forward(const std::string& socketPath, const std::vector<std::string>& args,
+        std::ostream& err, std::ostream& out, int& status)
+    {
+        char buffer[4096];
+        if(!getcwd(buffer, sizeof(buffer)))
+        {
+            return false;
+        }
+        int fd = connectTo(socketPath);
+        if(fd < 0)
+        {
+            return false;
+        }
+
+        std::string request;
+        putU32(request, args.size() + 1);
+        putString(request, buffer);
+        for(size_t i = 0; i < args.size(); i++)
+        {
+            putString(request, args[i]);
+        }
+
+        unsigned int result;
+        std::string errText;
+        std::string outText;
+        bool handled = sendAll(fd, request) && receiveU32(fd, result) && receiveString(fd, errText) && receiveString(fd, outText);
+        close(fd);
+        if(handled)
+        {
+            status = (int) result;
+            err << errText;
+            out << outText;
+        }
+        return handled;
+    }
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace nel
+{
+    /**
+     * Lets a long-running compiler take command lines from others over a
+     * Unix domain socket, so that whatever it keeps in memory between
+     * compilations is still warm for the next one, and nobody pays
+     * for starting up a compiler every time.
+     *
+     * A client sends its working directory and its command line, and the
+     * server compiles in that directory and sends back everything that would
+     * have been written to stderr and stdout, and the exit status. Numbers
+     * are little-endian:
+     *
+     *     request:  u32 count, then count strings: the working directory, then the arguments
+     *     response: u32 exit status, then two strings: stderr, then stdout
+     *     string:   u32 length, then that many bytes
+     *
+     * The server takes one command line at a time, since it changes its working
+     * directory for each, so a client that stops sending or receiving for a few
+     * seconds is dropped. Not supported on Windows.
+     */
+    class CompileServer
+    {
+        public:
+            /**
+             * Handles a command line, writing its messages to err and its reports to out,
+             * and returns its exit status.
+             */
+            typedef std::function<int (const std::vector<std::string>& args, std::ostream& err, std::ostream& out)> Handler;
+
+            /**
+             * Listens on a socket, handing each command line sent there to a handler, until the process
+             * is killed. Returns false if it couldn't listen, having said why to the log.
+             */
+            static bool serve(const std::string& socketPath, const Handler& handler, std::ostream& log);
+
+            /**
+             * Sends a command line to the server listening on a socket. Returns whether it was handled,
+             * setting the exit status and writing what the server wrote to err and out if so.
+             * It's up to the caller to handle the command line itself if not.
+             */
+            static bool forward(const std::string& socketPath, const std::vector<std::string>& args,
+                std::ostream& err, std::ostream& out, int& status);
+    };
+}
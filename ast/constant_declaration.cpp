@@ -8,23 +8,22 @@ namespace nel
         : Statement(Statement::CONSTANT_DECLARATION, sourcePosition), name(name), expression(expression)
     {
     }
-
-    ConstantDeclaration::~ConstantDeclaration()
+    
+    void ConstantDeclaration::aggregate(CompilationContext& context)
     {
-        delete name;
-        delete expression;
+        context.getActiveScope()->put(context, new ConstantDefinition(name->getValue(), this), name->getSourcePosition());
     }
-    
-    void ConstantDeclaration::aggregate()
+
+    void ConstantDeclaration::resolve(CompilationContext& context)
     {
-        SymbolTable::getActiveScope()->put(new ConstantDefinition(name->getValue(), this), name->getSourcePosition());
+        expression->resolve(context);
     }
 
-    void ConstantDeclaration::validate()
+    void ConstantDeclaration::validate(CompilationContext& context)
     {
     }
     
-    void ConstantDeclaration::generate()
+    void ConstantDeclaration::generate(CompilationContext& context)
     {
     }
 }
\ No newline at end of file
@@ -18,7 +18,6 @@ namespace nel
             
         public:    
             ConstantDeclaration(StringNode* name, Expression* expression, SourcePosition* sourcePosition);            
-            ~ConstantDeclaration();
             
             /**
              * Returns the name of the constant being defined.
@@ -36,8 +35,9 @@ namespace nel
                 return expression;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
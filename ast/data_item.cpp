@@ -13,20 +13,7 @@ namespace nel
     {
     }
     
-    DataItem::~DataItem()
-    {
-        switch(itemType)
-        {
-            case STRING_LITERAL:
-                delete expression;
-                break;
-            case EXPRESSION:
-                delete stringLiteral;
-                break;
-        }
-    }
-    
-    void DataItem::check()
+    void DataItem::check(CompilationContext& context)
     {
         switch(itemType)
         {
@@ -35,7 +22,7 @@ namespace nel
             case EXPRESSION:
                 // Check if the expression uses defined symbols.
                 // Don't fret if the value is unknown still.
-                expression->fold(false, true);
+                expression->fold(context, false, true);
                 break;
         }
     }
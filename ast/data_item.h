@@ -3,6 +3,7 @@
 #include "node.h"
 #include "string_node.h"
 #include "expression.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -35,7 +36,6 @@ namespace nel
         public:
             DataItem(Expression* expression, SourcePosition* sourcePosition);
             DataItem(StringNode* literal, SourcePosition* sourcePosition);
-            ~DataItem();
             
             /**
              * Returns the type of item this node represents.
@@ -64,6 +64,6 @@ namespace nel
             /**
              * Ensure that this item is defined (as for the value, it will possibly not yet be known).
              */
-            void check();
+            void check(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -9,17 +9,24 @@ namespace nel
         : Statement(Statement::DATA, sourcePosition), dataType(dataType), items(items)
     {
     }
-
-    DataStatement::~DataStatement()
+    
+    void DataStatement::aggregate(CompilationContext& context)
     {
-        delete items;
     }
-    
-    void DataStatement::aggregate()
+
+    void DataStatement::resolve(CompilationContext& context)
     {
+        ListNode<DataItem*>::ListType& list = items->getList();
+        for(size_t i = 0; i < list.size(); i++)
+        {
+            if(Expression* expression = list[i]->getExpression())
+            {
+                expression->resolve(context);
+            }
+        }
     }
 
-    void DataStatement::validate()
+    void DataStatement::validate(CompilationContext& context)
     {
         unsigned int baseSize = dataType == WORD ? 2 : 1;
         unsigned int size = 0;
@@ -30,7 +37,7 @@ namespace nel
         {
             DataItem* item = list[i];
             
-            item->check();
+            item->check(context);
             switch(item->getItemType())
             {
                 case DataItem::STRING_LITERAL:
@@ -44,10 +51,10 @@ namespace nel
         
         // Reserve the bytes needed for this data.
         // (Previous errors shouldn't wreck the size calculation).
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("data statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "data statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
         }
         else
         {
@@ -55,17 +62,17 @@ namespace nel
         }
     }
     
-    void DataStatement::generate()
+    void DataStatement::generate(CompilationContext& context)
     {
         // Get the bank to use for writing.
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("data statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "data statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
             return;
         }
         
-        ListNode<DataItem*>::ListType list = items->getList();
+        ListNode<DataItem*>::ListType& list = items->getList();
         
         for(size_t i = 0; i < list.size(); i++)
         {
@@ -94,7 +101,7 @@ namespace nel
                     break;
                 }
                 case DataItem::EXPRESSION:
-                    if(item->getExpression()->fold(true, true))
+                    if(item->getExpression()->fold(context, true, true))
                     {
                         if(dataType == WORD)
                         {
@@ -107,7 +114,7 @@ namespace nel
                     }
                     else
                     {
-                        error("data item has indeterminate value", getSourcePosition());
+                        error(context, "data item has indeterminate value", getSourcePosition());
                     }
                     break;
             }
@@ -29,7 +29,6 @@ namespace nel
             
         public:    
             DataStatement(DataType dataType, ListNode<DataItem*>* items, SourcePosition* sourcePosition);
-            ~DataStatement();
             
             /**
              * Returns the datatype that each value uses.
@@ -47,8 +46,9 @@ namespace nel
                 return items;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
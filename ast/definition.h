@@ -1,6 +1,8 @@
 #pragma once
 
+#include "arena.h"
 #include "source_position.h"
+#include "symbol_pool.h"
 
 namespace nel
 {
@@ -8,6 +10,8 @@ namespace nel
      * A definition of some piece of the language, which can
      * be looked up in a symbol table. For example, a variable,
      * constant, label or built-in register.
+     *
+     * Like nodes, definitions are allocated from the current arena.
      */
     class Definition
     {
@@ -39,18 +43,34 @@ namespace nel
             
         private:
             DefinitionType definitionType;
-            SourcePosition* declarationPoint;
+            SourcePosition declarationPoint;
             std::string name;
+            SymbolId symbol;
+            
+            static void finalize(void* definition)
+            {
+                static_cast<Definition*>(definition)->~Definition();
+            }
             
         public:
+            static void* operator new(size_t size)
+            {
+                return Arena::allocateObject(size, &finalize);
+            }
+            
+            static void operator delete(void* definition)
+            {
+                Arena::releaseObject(definition);
+            }
+            
+
             Definition(DefinitionType definitionType, std::string name)
-                : definitionType(definitionType), declarationPoint(0), name(name)
+                : definitionType(definitionType), name(name), symbol(SymbolPool::intern(name))
             {
             }
             
             virtual ~Definition()
             {
-                delete declarationPoint;
             }
             
             /**
@@ -67,15 +87,15 @@ namespace nel
              */            
             SourcePosition* getDeclarationPoint()
             {
-                return declarationPoint;
+                return declarationPoint.isKnown() ? &declarationPoint : 0;
             }
             
             /**
-             * Sets the point at which this symbol was defined.
+             * Sets the point at which this symbol was defined, keeping a copy of it.
              */            
             void setDeclarationPoint(SourcePosition* value)
             {
-                declarationPoint = value;
+                declarationPoint = value ? *value : SourcePosition();
             }
             
             /**
@@ -85,5 +105,13 @@ namespace nel
             {
                 return name;
             }
+            
+            /**
+             * Returns the interned id of the name associated with this definition.
+             */
+            SymbolId getSymbol()
+            {
+                return symbol;
+            }
     };
 }
\ No newline at end of file
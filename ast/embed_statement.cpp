@@ -5,30 +5,52 @@
 #include "path.h"
 #include "rom_generator.h"
 #include "rom_bank.h"
+#include "file_cache.h"
 #include "embed_statement.h"
+#include "trace_recorder.h"
 
 namespace nel
 {
     EmbedStatement::EmbedStatement(StringNode* relativePath, SourcePosition* sourcePosition)
         : Statement(Statement::EMBED, sourcePosition), relativePath(relativePath), filesize(0)
     {
-        filename = getDirectory(sourcePosition->getSourceFile()->getFilename()) + relativePath->getValue();
     }
-
-    EmbedStatement::~EmbedStatement()
+    
+    void EmbedStatement::aggregate(CompilationContext& context)
     {
-        delete relativePath;
+        // Embedded files are found relative to the file doing the embedding.
+        SourceFile* sourceFile = context.getSourceFile(getSourcePosition()->getFile());
+        filename = (sourceFile ? getDirectory(sourceFile->getFilename()) : "") + relativePath->getValue();
+        context.addEmbeddedFile(filename);
     }
-    
-    void EmbedStatement::aggregate()
+
+    void EmbedStatement::resolve(CompilationContext& context)
     {
     }
 
-    void EmbedStatement::validate()
+    void EmbedStatement::validate(CompilationContext& context)
     {   
-        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
-        
-        if(file.good() && file.is_open())
+        TraceRecorder::Span span(context.getTraceRecorder(), "embed", "embed size");
+        span.addArgument("file", filename);
+
+        // A long-running compiler keeps the file in memory, so it's only read again once it changes,
+        // and the third pass writes out exactly what was sized here.
+        if(FileCache* fileCache = context.getFileCache())
+        {
+            contents = fileCache->read(filename);
+        }
+
+        std::ifstream file;
+        if(!contents)
+        {
+            file.open(filename.c_str(), std::ios::in | std::ios::binary);
+        }
+
+        if(contents)
+        {
+            filesize = contents->size();
+        }
+        else if(file.good() && file.is_open())
         {
             file.seekg(0, std::ios_base::beg);
             std::ifstream::pos_type start = file.tellg();
@@ -40,16 +62,16 @@ namespace nel
         {
             std::ostringstream os;
             os << "could not open file `" << filename << "` required by an embed statement";
-            error(os.str(), getSourcePosition(), true);
+            error(context, os.str(), getSourcePosition(), true);
             return;
         }
         
         // Reserve the bytes needed for this data.
         // (Previous errors shouldn't wreck the size calculation).
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("embed statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "embed statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
         }
         else
         {
@@ -57,16 +79,28 @@ namespace nel
         }
     }
 
-    void EmbedStatement::generate()
+    void EmbedStatement::generate(CompilationContext& context)
     {
         // Get the bank to write into.
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(!bank)
         {
-            error("embed statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+            error(context, "embed statement found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
             return;
         }
         
+        TraceRecorder::Span span(context.getTraceRecorder(), "embed", "embed read");
+        span.addArgument("file", filename);
+
+        if(contents)
+        {
+            for(size_t i = 0; i < filesize; i++)
+            {
+                bank->writeByte((unsigned char) (*contents)[i], getSourcePosition());
+            }
+            return;
+        }
+
         std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
         
         if(file.good() && file.is_open())
@@ -84,7 +118,7 @@ namespace nel
         {
             std::ostringstream os;
             os << "could not open file `" << filename << " required by an embed statement";
-            error(os.str(), getSourcePosition(), true);
+            error(context, os.str(), getSourcePosition(), true);
             return;
         }
     }
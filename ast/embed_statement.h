@@ -1,6 +1,7 @@
 #pragma once
 
 #include "statement.h"
+#include "file_cache.h"
 #include "list_node.h"
 #include "data_item.h"
 
@@ -15,10 +16,11 @@ namespace nel
             StringNode* relativePath;
             std::string filename;
             unsigned int filesize;
+            // The file as it was read through the compilation's file cache, if it has one.
+            FileCache::Contents contents;
             
         public:    
             EmbedStatement(StringNode* relativePath, SourcePosition* sourcePosition);
-            ~EmbedStatement();
             
             /**
              * Returns the name of the file that is being embedded.
@@ -28,8 +30,9 @@ namespace nel
                 return filename;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -1,54 +1,64 @@
-#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include "error.h"
+#include "compilation_context.h"
 
 namespace nel
 {
-    unsigned int errorCount = 0;
-
-    static void printErrorSource(SourcePosition* sourcePosition)
+    static void printErrorSource(CompilationContext& context, SourcePosition* sourcePosition, std::ostream& os)
     {
-        if(sourcePosition)
+        if(sourcePosition && sourcePosition->isKnown())
         {
-            sourcePosition->print(std::cerr);
+            sourcePosition->print(context, os);
         }
         else
         {
-            std::cerr << "??? (source unknown)";
+            os << "??? (source unknown)";
         }
     }
 
-    static void incrementErrorCount(bool fatal)
+    static void incrementErrorCount(CompilationContext& context, bool fatal)
     {
-		errorCount++;
-		if(errorCount >= ERROR_MAX_COUNT)
+		if(context.incrementErrorCount() >= ERROR_MAX_COUNT)
 		{
             fatal = true;
-            std::cerr << "  fatal: too many errors (max of " << ERROR_MAX_COUNT << ")." << std::endl;
+            context.getLog() << "  fatal: too many errors (max of " << ERROR_MAX_COUNT << ")." << std::endl;
 		}
         if(fatal)
         {
-            failAndExit();
+            failCompilation(context);
         }
     }
     
-    void failAndExit()
+    void failCompilation(CompilationContext& context)
+    {
+        context.getLog() << "* " << PROGRAM_NAME << ": failed with " << context.getErrorCount() << " error(s)." << std::endl;
+        throw FatalError("compilation failed");
+    }
+
+    void internalError(CompilationContext& context, std::string message, bool fatal)
+    {
+        context.getLog() << "  " << (fatal ? "fatal: " : "") << " internal error: " << message << std::endl;
+        incrementErrorCount(context, fatal);
+    }
+
+    void error(CompilationContext& context, std::string message, SourcePosition* sourcePosition, bool fatal)
     {
-        std::cerr << "* " << PROGRAM_NAME << ": failed with " << errorCount << " error(s)." << std::endl;
-        exit(1);
+        reportError(context, formatError(context, message, sourcePosition, fatal), fatal);
     }
 
-    void internalError(std::string message, bool fatal)
+    std::string formatError(CompilationContext& context, const std::string& message, SourcePosition* sourcePosition, bool fatal)
     {
-        std::cerr << "  " << (fatal ? "fatal: " : "") << " internal error: " << message << std::endl;
-        incrementErrorCount(fatal);
+        std::ostringstream os;
+        os << "  " << (fatal ? "fatal: " : "");
+        printErrorSource(context, sourcePosition, os);
+        os << ": " << message;
+        return os.str();
     }
 
-    void error(std::string message, SourcePosition* sourcePosition, bool fatal)
+    void reportError(CompilationContext& context, const std::string& text, bool fatal)
     {
-        std::cerr << "  " << (fatal ? "fatal: " : "");
-        printErrorSource(sourcePosition);
-        std::cerr << ": " << message << std::endl;
-        incrementErrorCount(fatal);
+        context.getLog() << text << std::endl;
+        incrementErrorCount(context, fatal);
     }
-}
\ No newline at end of file
+}
@@ -1,26 +1,54 @@
 #pragma once 
 
+#include <string>
+#include <stdexcept>
+
 #include "source_position.h"
 
 namespace nel
 {
+    class CompilationContext;
+
     static const char* const PROGRAM_NAME = "nel";
     const unsigned int ERROR_MAX_COUNT = 30;
-    extern unsigned int errorCount;
     
     /**
-     * Print failure message and quit the program.
+     * Thrown when a compilation cannot continue, either because of a fatal error
+     * or because too many errors were reported. It unwinds back to whoever started
+     * the compilation, leaving the rest of the process alone.
+     */
+    class FatalError : public std::runtime_error
+    {
+        public:
+            FatalError(const std::string& message)
+                : std::runtime_error(message)
+            {
+            }
+    };
+    
+    /**
+     * Print failure message and abandon the compilation by throwing a FatalError.
      */
-    void failAndExit();
+    void failCompilation(CompilationContext& context);
     
     /**
      * Raises an internal error message which cannot be linked to a line in source.
      */
-    void internalError(std::string message, bool fatal = true);
+    void internalError(CompilationContext& context, std::string message, bool fatal = true);
     
     /**
      * Raises an error message due to a problem with lexing, syntax,
      * or the semantics of the user's code.
      */
-    void error(std::string message, SourcePosition* sourcePosition, bool fatal = false);
-}
\ No newline at end of file
+    void error(CompilationContext& context, std::string message, SourcePosition* sourcePosition, bool fatal = false);
+
+    /**
+     * Formats an error message the way that error() reports it, without reporting it.
+     */
+    std::string formatError(CompilationContext& context, const std::string& message, SourcePosition* sourcePosition, bool fatal = false);
+
+    /**
+     * Reports an error formatted by formatError(), counting it just as error() does.
+     */
+    void reportError(CompilationContext& context, const std::string& text, bool fatal = false);
+}
@@ -1,6 +1,7 @@
 #include <sstream>
 
 #include "error.h"
+#include "statistics.h"
 #include "symbol_table.h"
 #include "constant_definition.h"
 #include "label_definition.h"
@@ -27,38 +28,40 @@ namespace nel
         init();
     }
     
-    Expression::~Expression()
+    void Expression::init()
+    {
+        folded = false;
+        // An arbitrary uninitialized value outside of 0..65536,
+        // to make use of unfolded expressions easier to debug.
+        foldedValue = 0xDEADFACE;
+    }
+    
+    void Expression::resolve(CompilationContext& context)
     {
         switch(expressionType)
         {
             case NUMBER:
-                delete number;
                 break;
             case ATTRIBUTE:
-                delete attribute;
+                attribute->resolve(context);
                 break;
             case OPERATION:
-                delete operation;
+                operation->getLeft()->resolve(context);
+                operation->getRight()->resolve(context);
                 break;
         }
     }
-    
-    void Expression::init()
-    {
-        folded = false;
-        // An arbitrary uninitialized value outside of 0..65536,
-        // to make use of unfolded expressions easier to debug.
-        foldedValue = 0xDEADFACE;
-    }
-    
-    bool Expression::fold(bool mustFold, bool forbidUndefined, std::vector<Definition*>& expansionStack)
+
+    bool Expression::fold(CompilationContext& context, bool mustFold, bool forbidUndefined, std::vector<Definition*>& expansionStack)
     {
         // expansionStack contains a stack of all named constants that are being expanded.
         // This is the max size that this stack is allowed to grow.
         const unsigned int EXPANSION_STACK_MAX = 16;
         
+        Statistics::count(Statistics::FOLDS);
         if(folded)
         {
+            Statistics::count(Statistics::FOLD_CACHE_HITS);
             return true;
         }
         
@@ -72,7 +75,7 @@ namespace nel
             }
             case ATTRIBUTE:
             {
-                Definition* def = attribute->findDefinition(forbidUndefined);
+                Definition* def = attribute->findDefinition(context, forbidUndefined);
 
                 // Get the position of the attribute's first element, used for errors.
                 SourcePosition* pos = attribute->getPieces()->getList().front()->getSourcePosition();
@@ -95,14 +98,21 @@ namespace nel
                                 for(size_t i = 0; i < expansionStack.size(); i++)
                                 {
                                     Definition* entry = expansionStack[i];
-                                    os << std::endl << "    `" << entry->getName() << "` at " <<
-                                        entry->getDeclarationPoint();
+                                    os << std::endl << "    `" << entry->getName() << "` at ";
+                                    if(SourcePosition* point = entry->getDeclarationPoint())
+                                    {
+                                        point->print(context, os);
+                                    }
+                                    else
+                                    {
+                                        os << "???";
+                                    }
                                 }
-                                error(os.str(), pos, true);
+                                error(context, os.str(), pos, true);
                             }
                             else
                             {
-                                folded = expression->fold(mustFold, forbidUndefined, expansionStack);
+                                folded = expression->fold(context, mustFold, forbidUndefined, expansionStack);
                             }
                             expansionStack.pop_back();
                             
@@ -127,7 +137,7 @@ namespace nel
                         {
                             std::ostringstream os;
                             os << "package `" << attribute->getName() << "` may not be directly used in a numeric expression because it's a scope, lacking any address or numeric value.";
-                            error(os.str(), pos);
+                            error(context, os.str(), pos);
                             folded = false;
                             forbidUndefined = true; // this line is to prevent more the general 'indeterminate value' message below.
                             break;
@@ -142,14 +152,14 @@ namespace nel
                 {
                     std::ostringstream os;
                     os << "attribute `" << attribute->getName() << "` has an indeterminate value.";
-                    error(os.str(), pos);
+                    error(context, os.str(), pos);
                 }
                 break;
             }
             case OPERATION:
             {
-                operation->getLeft()->fold(mustFold, forbidUndefined, expansionStack);
-                operation->getRight()->fold(mustFold, forbidUndefined, expansionStack);
+                operation->getLeft()->fold(context, mustFold, forbidUndefined, expansionStack);
+                operation->getRight()->fold(context, mustFold, forbidUndefined, expansionStack);
                 
                 if(!operation->getLeft()->isFolded() || !operation->getRight()->isFolded())
                 {
@@ -166,7 +176,7 @@ namespace nel
                     {
                         if(ls > MAX_VALUE / rs)
                         {
-                            error("multiplication yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
+                            error(context, "multiplication yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -179,7 +189,7 @@ namespace nel
                     {
                         if(rs == 0)
                         {
-                            error("division by zero is undefined.", operation->getRight()->getSourcePosition());
+                            error(context, "division by zero is undefined.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -192,7 +202,7 @@ namespace nel
                     {
                         if(rs == 0)
                         {
-                            error("modulo by zero is undefined.", operation->getRight()->getSourcePosition());
+                            error(context, "modulo by zero is undefined.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -205,7 +215,7 @@ namespace nel
                     {
                         if(ls + MAX_VALUE < rs)
                         {
-                            error("addition yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
+                            error(context, "addition yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -218,7 +228,7 @@ namespace nel
                     {
                         if(ls < rs)
                         {
-                            error("subtraction yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
+                            error(context, "subtraction yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -232,7 +242,7 @@ namespace nel
                         // If shifting more than N bits, or ls << rs > 2^N-1, then error.
                         if(rs > 16 || rs > 0 && (ls & ~(1 << (16 - rs))) != 0)
                         {
-                            error("logical shift left yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
+                            error(context, "logical shift left yields result which will overflow outside of 0..65535.", operation->getRight()->getSourcePosition());
                             folded = false;
                         }
                         else
@@ -268,9 +278,9 @@ namespace nel
         return folded;
     }
     
-    bool Expression::fold(bool mustFold, bool forbidUndefined)
+    bool Expression::fold(CompilationContext& context, bool mustFold, bool forbidUndefined)
     {
         std::vector<Definition*> expansionStack;
-        return fold(mustFold, forbidUndefined, expansionStack);
+        return fold(context, mustFold, forbidUndefined, expansionStack);
     }
 }
\ No newline at end of file
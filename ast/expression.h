@@ -7,6 +7,7 @@
 #include "attribute.h"
 #include "operation.h"
 #include "definition.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -48,12 +49,11 @@ namespace nel
             Expression(NumberNode* number, SourcePosition* sourcePosition);
             Expression(Attribute* attribute, SourcePosition* sourcePosition);
             Expression(Operation* operation, SourcePosition* sourcePosition);
-            ~Expression();
             
         private:
             void init();
             
-            bool fold(bool mustFold, bool symbolsMustExist, std::vector<Definition*>& expansionStack);
+            bool fold(CompilationContext& context, bool mustFold, bool symbolsMustExist, std::vector<Definition*>& expansionStack);
             
         public:
             /**
@@ -108,6 +108,11 @@ namespace nel
              * Attempts to fold together the expression tree underneath this node.
              * If it succeeds, returns true. Otherwise, it returns false.
              */
-            bool fold(bool mustFold, bool forbidUndefined);
+            bool fold(CompilationContext& context, bool mustFold, bool forbidUndefined);
+
+            /**
+             * Binds every attribute in the expression tree to the active scope.
+             */
+            void resolve(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <ctime>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "file_cache.h"
+
+namespace nel
+{
+    FileCache::FileCache()
+        : entries(MEMORY_LIMIT)
+    {
+    }
+
+    FileCache::Contents FileCache::read(const std::string& filename, FileIdentity* identity)
+    {
+        // The file is looked at before it's read, so that if it changes partway through,
+        // it won't match next time and is read again.
+        Entry entry = Entry();
+        #if defined(_WIN32)
+            struct _stat64 info;
+            if(_stat64(filename.c_str(), &info) != 0)
+            {
+                return Contents();
+            }
+        #else
+            struct stat info;
+            if(stat(filename.c_str(), &info) != 0)
+            {
+                return Contents();
+            }
+            entry.device = info.st_dev;
+            entry.inode = info.st_ino;
+        #endif
+        entry.size = info.st_size;
+        entry.modified = info.st_mtime;
+        #if defined(__linux__)
+            entry.modifiedNanoseconds = info.st_mtim.tv_nsec;
+        #endif
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(const Entry* found = entries.find(filename))
+            {
+                const Entry& cached = *found;
+                // A file modified no earlier than it was read may have changed since without its time moving on.
+                if(cached.device == entry.device && cached.inode == entry.inode && cached.size == entry.size
+                    && cached.modified == entry.modified && cached.modifiedNanoseconds == entry.modifiedNanoseconds
+                    && cached.modified < cached.readTime)
+                {
+                    if(identity)
+                    {
+                        *identity = cached.identity;
+                    }
+                    return cached.contents;
+                }
+            }
+        }
+
+        entry.readTime = time(0);
+        FILE* f = fopen(filename.c_str(), "rb");
+        if(!f)
+        {
+            return Contents();
+        }
+        std::string* text = new std::string();
+        char buffer[65536];
+        size_t count;
+        while((count = fread(buffer, 1, sizeof(buffer), f)) != 0)
+        {
+            text->append(buffer, count);
+        }
+        bool failed = ferror(f) != 0;
+        fclose(f);
+        if(failed)
+        {
+            delete text;
+            return Contents();
+        }
+
+        entry.contents = Contents(text);
+        entry.identity.setText(text->data(), text->size());
+        if(identity)
+        {
+            *identity = entry.identity;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.put(filename, entry, filename.size() + text->size());
+        return entry.contents;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "file_identity.h"
+#include "lru_map.h"
+
+namespace nel
+{
+    /**
+     * The contents of files, kept in memory between compilations by a
+     * long-running compiler, so that files that haven't changed aren't read again.
+     *
+     * A file is only read again once its size, modification time or inode
+     * has changed. A file modified in the same second it was read could
+     * still change without any of those changing, so it's read again until
+     * it has been left alone for longer than that. Every file is hashed as it's read, so that anything
+     * kept by the hash of a file's text still applies after a file is
+     * touched without being changed. Up to MEMORY_LIMIT bytes of the most
+     * recently used files are kept.
+     *
+     * Safe to use from any thread.
+     */
+    class FileCache
+    {
+        public:
+            /**
+             * The contents of a file, which stay put even after the file changes.
+             */
+            typedef std::shared_ptr<const std::string> Contents;
+
+        private:
+            struct Entry
+            {
+                // What the file looked like on disk when it was read.
+                unsigned long long device;
+                unsigned long long inode;
+                unsigned long long size;
+                long long modified;
+                long long modifiedNanoseconds;
+                // When the file was read, to the second.
+                long long readTime;
+
+                Contents contents;
+                FileIdentity identity;
+            };
+
+            std::mutex mutex;
+            LruMap<Entry> entries;
+
+            // Not copyable.
+            FileCache(const FileCache&);
+            FileCache& operator=(const FileCache&);
+
+        public:
+            enum
+            {
+                // The most bytes of files kept, after which the least recently used go.
+                MEMORY_LIMIT = 128 << 20
+            };
+
+            FileCache();
+
+            /**
+             * Returns the contents of a file, reading it only if it changed since the last time,
+             * or 0 if it can't be read. Sets the identity of its text, if given.
+             */
+            Contents read(const std::string& filename, FileIdentity* identity = 0);
+    };
+}
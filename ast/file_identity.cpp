@@ -0,0 +1,131 @@
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+#include "file_identity.h"
+
+namespace nel
+{
+    FileIdentity::FileIdentity()
+        : device(0), inode(0), hashed(false), size(0)
+    {
+        hash.low = 0;
+        hash.high = 0;
+    }
+
+#if defined(_WIN32)
+    // Inodes aren't meaningful here, so files are only ever matched by their text.
+    FileIdentity FileIdentity::ofPath(const std::string& filename)
+    {
+        return FileIdentity();
+    }
+
+    void FileIdentity::setFile(int fd)
+    {
+    }
+#else
+    FileIdentity FileIdentity::ofPath(const std::string& filename)
+    {
+        FileIdentity identity;
+        struct stat info;
+        if(stat(filename.c_str(), &info) == 0)
+        {
+            identity.device = info.st_dev;
+            identity.inode = info.st_ino;
+        }
+        return identity;
+    }
+
+    void FileIdentity::setFile(int fd)
+    {
+        struct stat info;
+        if(fstat(fd, &info) == 0)
+        {
+            device = info.st_dev;
+            inode = info.st_ino;
+        }
+    }
+#endif
+
+    namespace
+    {
+        inline unsigned long long rotate(unsigned long long value, unsigned int bits)
+        {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        inline void sipRound(unsigned long long* v)
+        {
+            v[0] += v[1]; v[1] = rotate(v[1], 13); v[1] ^= v[0]; v[0] = rotate(v[0], 32);
+            v[2] += v[3]; v[3] = rotate(v[3], 16); v[3] ^= v[2];
+            v[0] += v[3]; v[3] = rotate(v[3], 21); v[3] ^= v[0];
+            v[2] += v[1]; v[1] = rotate(v[1], 17); v[1] ^= v[2]; v[2] = rotate(v[2], 32);
+        }
+
+        inline void sipCompress(unsigned long long* v, unsigned long long word)
+        {
+            v[3] ^= word;
+            sipRound(v);
+            sipRound(v);
+            v[0] ^= word;
+        }
+
+        inline void sipFinish(unsigned long long* v)
+        {
+            for(unsigned int i = 0; i < 4; i++)
+            {
+                sipRound(v);
+            }
+        }
+    }
+
+    FileIdentity::Hash FileIdentity::hashText(const char* data, size_t size)
+    {
+        // SipHash-2-4 with 128 bits of output. Every bit of every byte reaches every
+        // bit of the hash, so that files which differ in a handful of bytes don't collide,
+        // unlike a multiply-and-xor hash taken a word at a time. The key is fixed (the one
+        // from the reference test vectors), since hashes are kept in files on disk.
+        const unsigned long long k0 = 0x0706050403020100ULL;
+        const unsigned long long k1 = 0x0F0E0D0C0B0A0908ULL;
+        unsigned long long v[4] = {
+            k0 ^ 0x736F6D6570736575ULL,
+            k1 ^ 0x646F72616E646F6DULL ^ 0xEE,
+            k0 ^ 0x6C7967656E657261ULL,
+            k1 ^ 0x7465646279746573ULL
+        };
+
+        const unsigned char* p = (const unsigned char*) data;
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8)
+        {
+            unsigned long long word = 0;
+            for(unsigned int j = 0; j < 8; j++)
+            {
+                word |= (unsigned long long) p[i + j] << (j * 8);
+            }
+            sipCompress(v, word);
+        }
+        unsigned long long last = (unsigned long long) size << 56;
+        for(unsigned int j = 0; i + j < size; j++)
+        {
+            last |= (unsigned long long) p[i + j] << (j * 8);
+        }
+        sipCompress(v, last);
+
+        Hash hash;
+        v[2] ^= 0xEE;
+        sipFinish(v);
+        hash.low = v[0] ^ v[1] ^ v[2] ^ v[3];
+        v[1] ^= 0xDD;
+        sipFinish(v);
+        hash.high = v[0] ^ v[1] ^ v[2] ^ v[3];
+        return hash;
+    }
+
+    void FileIdentity::setText(const char* data, size_t size)
+    {
+        this->size = size;
+        hash = hashText(data, size);
+        hashed = true;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace nel
+{
+    /**
+     * What makes two source files the same file, for require once.
+     *
+     * A file is the same as another if it's the same file on disk,
+     * by device and inode, however it was named. Failing that, it's
+     * the same if its text is, so that a copy of a shared file
+     * counts too.
+     */
+    class FileIdentity
+    {
+        public:
+            /**
+             * A 128-bit hash of a file's text.
+             */
+            struct Hash
+            {
+                unsigned long long low;
+                unsigned long long high;
+
+                bool operator ==(const Hash& other) const
+                {
+                    return low == other.low && high == other.high;
+                }
+
+                bool operator !=(const Hash& other) const
+                {
+                    return !(*this == other);
+                }
+            };
+
+        private:
+            // Where the file lives on disk, or both 0 if that's unknown.
+            unsigned long long device;
+            unsigned long long inode;
+            // Whether the text was hashed, and its size and hash if so.
+            bool hashed;
+            size_t size;
+            Hash hash;
+
+        public:
+            /**
+             * Creates an identity that matches nothing.
+             */
+            FileIdentity();
+
+            /**
+             * Returns the identity of the file on disk that a filename names,
+             * without its text. It matches nothing if the file can't be found.
+             */
+            static FileIdentity ofPath(const std::string& filename);
+
+            /**
+             * Sets where the file lives on disk, from an open descriptor.
+             */
+            void setFile(int fd);
+
+            /**
+             * Returns the 128-bit SipHash-2-4 of some text, under a fixed key.
+             */
+            static Hash hashText(const char* data, size_t size);
+
+            /**
+             * Hashes the file's text. This must be done before the lexer scans it,
+             * since scanning writes into the text.
+             */
+            void setText(const char* data, size_t size);
+
+            /**
+             * Returns whether the file's text was hashed.
+             */
+            bool isHashed() const
+            {
+                return hashed;
+            }
+
+            /**
+             * Returns the size of the file's text, if it was hashed.
+             */
+            size_t getSize() const
+            {
+                return size;
+            }
+
+            /**
+             * Returns the hash of the file's text, if it was hashed.
+             */
+            const Hash& getHash() const
+            {
+                return hash;
+            }
+
+            /**
+             * Returns whether this and another are the same file on disk.
+             */
+            bool isSameFile(const FileIdentity& other) const
+            {
+                return (device || inode) && device == other.device && inode == other.inode;
+            }
+
+            /**
+             * Returns whether this and another are the same file, either on disk or by their text.
+             */
+            bool matches(const FileIdentity& other) const
+            {
+                return isSameFile(other)
+                    || (hashed && other.hashed && size == other.size && hash == other.hash);
+            }
+    };
+}
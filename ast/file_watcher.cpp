@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include "path.h"
+#include "file_watcher.h"
+
+namespace nel
+{
+    namespace
+    {
+        // How long to wait for more changes after one, before reporting them.
+        const int SETTLE_MILLISECONDS = 50;
+        // How often files are looked at, where they can't be watched.
+        const int POLL_MILLISECONDS = 250;
+
+        // Returns when a file was modified and its size, or -1 for both if it's not there.
+        std::pair<long long, long long> look(const std::string& filename)
+        {
+            #if defined(_WIN32)
+                struct _stat64 info;
+                if(_stat64(filename.c_str(), &info) != 0)
+                {
+                    return std::make_pair(-1LL, -1LL);
+                }
+            #else
+                struct stat info;
+                if(stat(filename.c_str(), &info) != 0)
+                {
+                    return std::make_pair(-1LL, -1LL);
+                }
+            #endif
+            return std::make_pair((long long) info.st_mtime, (long long) info.st_size);
+        }
+    }
+
+    FileWatcher::FileWatcher()
+        : fd(-1)
+    {
+        #if defined(__linux__)
+            fd = inotify_init1(IN_CLOEXEC);
+        #endif
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        #if defined(__linux__)
+            if(fd >= 0)
+            {
+                close(fd);
+            }
+        #endif
+    }
+
+    bool FileWatcher::watch(const std::vector<std::string>& filenames)
+    {
+        files = std::set<std::string>(filenames.begin(), filenames.end());
+
+        // Directories stay watched once they are, so that changes made while a
+        // rebuild was running are still waiting to be read afterwards.
+        #if defined(__linux__)
+            if(fd >= 0)
+            {
+                for(size_t i = 0; i < filenames.size(); i++)
+                {
+                    std::string prefix = getDirectory(filenames[i]);
+                    int wd = inotify_add_watch(fd, prefix.empty() ? "." : prefix.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+                    if(wd >= 0)
+                    {
+                        std::vector<std::string>& prefixes = directories[wd];
+                        if(std::find(prefixes.begin(), prefixes.end(), prefix) == prefixes.end())
+                        {
+                            prefixes.push_back(prefix);
+                        }
+                    }
+                }
+                return !directories.empty();
+            }
+        #endif
+
+        // Likewise, files already looked at keep what they looked like before.
+        for(size_t i = 0; i < filenames.size(); i++)
+        {
+            if(lastSeen.find(filenames[i]) == lastSeen.end())
+            {
+                lastSeen[filenames[i]] = look(filenames[i]);
+            }
+        }
+        return !files.empty();
+    }
+
+    std::vector<std::string> FileWatcher::wait()
+    {
+        std::set<std::string> changed;
+
+        #if defined(__linux__)
+            if(fd >= 0)
+            {
+                alignas(inotify_event) char buffer[4096];
+                for(;;)
+                {
+                    // Once something's changed, anything else has a moment to follow.
+                    if(!changed.empty())
+                    {
+                        pollfd waiting = {fd, POLLIN, 0};
+                        int ready = poll(&waiting, 1, SETTLE_MILLISECONDS);
+                        if(ready < 0 && errno == EINTR)
+                        {
+                            continue;
+                        }
+                        if(ready <= 0)
+                        {
+                            break;
+                        }
+                    }
+
+                    ssize_t size = read(fd, buffer, sizeof(buffer));
+                    if(size < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if(size <= 0)
+                    {
+                        return std::vector<std::string>();
+                    }
+
+                    for(ssize_t offset = 0; offset < size; )
+                    {
+                        const inotify_event* event = (const inotify_event*) (buffer + offset);
+                        offset += sizeof(inotify_event) + event->len;
+
+                        // Events were lost, so anything might have changed.
+                        if(event->mask & IN_Q_OVERFLOW)
+                        {
+                            changed.insert(files.begin(), files.end());
+                        }
+                        else if(event->len)
+                        {
+                            std::map<int, std::vector<std::string> >::iterator it = directories.find(event->wd);
+                            if(it == directories.end())
+                            {
+                                continue;
+                            }
+                            for(size_t i = 0; i < it->second.size(); i++)
+                            {
+                                std::string filename = it->second[i] + event->name;
+                                if(files.find(filename) != files.end())
+                                {
+                                    changed.insert(filename);
+                                }
+                            }
+                        }
+                    }
+                }
+                return std::vector<std::string>(changed.begin(), changed.end());
+            }
+        #endif
+
+        if(files.empty())
+        {
+            return std::vector<std::string>();
+        }
+        for(;;)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(changed.empty() ? POLL_MILLISECONDS : SETTLE_MILLISECONDS));
+
+            bool changedNow = false;
+            for(std::set<std::string>::iterator it = files.begin(); it != files.end(); ++it)
+            {
+                std::pair<long long, long long> seen = look(*it);
+                if(seen != lastSeen[*it])
+                {
+                    lastSeen[*it] = seen;
+                    changed.insert(*it);
+                    changedNow = true;
+                }
+            }
+            if(!changed.empty() && !changedNow)
+            {
+                return std::vector<std::string>(changed.begin(), changed.end());
+            }
+        }
+    }
+}
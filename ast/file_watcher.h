@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace nel
+{
+    /**
+     * Waits for any of a set of files to change, for --watch.
+     *
+     * On Linux, the directories holding the files are watched with inotify,
+     * so that a file is still seen when an editor saves it by writing a new
+     * file and renaming it over the old one. Elsewhere, the files are looked
+     * at every so often instead.
+     *
+     * Changes that come close together are gathered up and reported at once,
+     * since saving a file often takes several steps.
+     */
+    class FileWatcher
+    {
+        private:
+            // The files being watched, as they were named.
+            std::set<std::string> files;
+
+            // The inotify instance, or -1 if there isn't one.
+            int fd;
+            // The prefixes that each watched directory was named with, by watch descriptor.
+            // Naming one directory several ways only gets one watch.
+            std::map<int, std::vector<std::string> > directories;
+
+            // What each file looked like when it was last looked at, when files are looked at every so often.
+            std::map<std::string, std::pair<long long, long long> > lastSeen;
+
+            // Not copyable.
+            FileWatcher(const FileWatcher&);
+            FileWatcher& operator=(const FileWatcher&);
+
+        public:
+            FileWatcher();
+            ~FileWatcher();
+
+            /**
+             * Watches these files, instead of any that were watched before.
+             * Returns false if none of them can be watched.
+             */
+            bool watch(const std::vector<std::string>& filenames);
+
+            /**
+             * Waits for watched files to change, and returns the names of those that did,
+             * or nothing if they can't be waited on.
+             */
+            std::vector<std::string> wait();
+    };
+}
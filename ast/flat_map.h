@@ -0,0 +1,271 @@
+#pragma once
+
+#include <string>
+
+#include "map.h"
+
+namespace nel
+{
+    /**
+     * Hashes keys for a FlatMap. Specialized for each key type in use.
+     */
+    template <typename K>
+    struct FlatHash;
+
+    template <>
+    struct FlatHash<unsigned int>
+    {
+        static unsigned int hash(unsigned int key)
+        {
+            // Symbol ids are handed out in sequence, so spread them over the whole word.
+            key *= 0x9E3779B1u;
+            return key ^ (key >> 15);
+        }
+    };
+
+    template <>
+    struct FlatHash<std::string>
+    {
+        static unsigned int hash(const std::string& key)
+        {
+            // FNV-1a.
+            unsigned int h = 2166136261u;
+            for(size_t i = 0; i < key.size(); i++)
+            {
+                h = (h ^ (unsigned char) key[i]) * 16777619u;
+            }
+            return h;
+        }
+    };
+
+    /**
+     * A hash map that keeps its keys and values inline in a single array,
+     * probed linearly, with each entry's hash stored alongside it so that
+     * mismatched keys are usually rejected without comparing them.
+     *
+     * It's meant for the many small scopes that begin/end blocks create:
+     * an empty map allocates nothing, the first insert allocates a handful
+     * of entries, and a lookup touches one or two adjacent cache lines.
+     *
+     * Entries can't be removed, since nothing here ever needs to.
+     * The interface is the subset of std::map that the compiler uses,
+     * so either can sit behind the same typedef.
+     */
+    template <typename K, typename V>
+    class FlatMap
+    {
+        public:
+            struct Entry
+            {
+                // The key's hash, with the top bit set. 0 marks an empty entry.
+                unsigned int hash;
+                K first;
+                V second;
+
+                Entry()
+                    : hash(0), first(), second()
+                {
+                }
+            };
+
+            class iterator
+            {
+                private:
+                    Entry* entry;
+                    Entry* last;
+
+                    void skipEmpty()
+                    {
+                        while(entry != last && !entry->hash)
+                        {
+                            entry++;
+                        }
+                    }
+
+                public:
+                    iterator(Entry* entry, Entry* last)
+                        : entry(entry), last(last)
+                    {
+                        skipEmpty();
+                    }
+
+                    Entry& operator*() const
+                    {
+                        return *entry;
+                    }
+
+                    Entry* operator->() const
+                    {
+                        return entry;
+                    }
+
+                    iterator& operator++()
+                    {
+                        entry++;
+                        skipEmpty();
+                        return *this;
+                    }
+
+                    bool operator==(const iterator& other) const
+                    {
+                        return entry == other.entry;
+                    }
+
+                    bool operator!=(const iterator& other) const
+                    {
+                        return entry != other.entry;
+                    }
+            };
+
+        private:
+            enum
+            {
+                // Entries allocated by the first insert.
+                INITIAL_CAPACITY = 8
+            };
+
+            // The entries, or 0 until something is inserted. The capacity is always a power of two.
+            Entry* entries;
+            unsigned int capacity;
+            unsigned int count;
+
+            // Not copyable.
+            FlatMap(const FlatMap&);
+            FlatMap& operator=(const FlatMap&);
+
+            static unsigned int hashOf(const K& key)
+            {
+                return FlatHash<K>::hash(key) | 0x80000000u;
+            }
+
+            /**
+             * Returns the entry holding the key, or the empty entry where it belongs.
+             * Requires that the table has been allocated.
+             */
+            Entry* probe(const K& key, unsigned int hash) const
+            {
+                unsigned int mask = capacity - 1;
+                for(unsigned int i = hash & mask;; i = (i + 1) & mask)
+                {
+                    Entry* entry = &entries[i];
+                    if(!entry->hash || (entry->hash == hash && entry->first == key))
+                    {
+                        return entry;
+                    }
+                }
+            }
+
+            void grow()
+            {
+                Entry* old = entries;
+                unsigned int oldCapacity = capacity;
+
+                capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+                entries = new Entry[capacity];
+                for(unsigned int i = 0; i < oldCapacity; i++)
+                {
+                    if(old[i].hash)
+                    {
+                        Entry* entry = probe(old[i].first, old[i].hash);
+                        entry->hash = old[i].hash;
+                        entry->first = old[i].first;
+                        entry->second = old[i].second;
+                    }
+                }
+                delete[] old;
+            }
+
+        public:
+            FlatMap()
+                : entries(0), capacity(0), count(0)
+            {
+            }
+
+            ~FlatMap()
+            {
+                delete[] entries;
+            }
+
+            iterator begin() const
+            {
+                return iterator(entries, entries + capacity);
+            }
+
+            iterator end() const
+            {
+                return iterator(entries + capacity, entries + capacity);
+            }
+
+            size_t size() const
+            {
+                return count;
+            }
+
+            bool empty() const
+            {
+                return count == 0;
+            }
+
+            /**
+             * Returns an iterator to the entry for the key, or end() if there isn't one.
+             */
+            iterator find(const K& key) const
+            {
+                if(!count)
+                {
+                    return end();
+                }
+                Entry* entry = probe(key, hashOf(key));
+                return entry->hash ? iterator(entry, entries + capacity) : end();
+            }
+
+            /**
+             * Returns the value for the key, inserting a default one if there isn't one yet.
+             */
+            V& operator[](const K& key)
+            {
+                unsigned int hash = hashOf(key);
+                if(count)
+                {
+                    Entry* entry = probe(key, hash);
+                    if(entry->hash)
+                    {
+                        return entry->second;
+                    }
+                }
+
+                // Keep the table at most 3/4 full, so probe sequences stay short.
+                if((count + 1) * 4 > capacity * 3)
+                {
+                    grow();
+                }
+                Entry* entry = probe(key, hash);
+                entry->hash = hash;
+                entry->first = key;
+                count++;
+                return entry->second;
+            }
+
+            void clear()
+            {
+                delete[] entries;
+                entries = 0;
+                capacity = 0;
+                count = 0;
+            }
+    };
+
+    /**
+     * The map used for symbol lookups, which is a FlatMap unless NEL_USE_NODE_MAP
+     * asks for the configured Map instead, for comparison.
+     */
+    template <typename K, typename V>
+    struct LookupMap
+    {
+#if defined(NEL_USE_NODE_MAP)
+        typedef typename Map<K, V>::Type Type;
+#else
+        typedef FlatMap<K, V> Type;
+#endif
+    };
+}
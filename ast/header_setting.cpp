@@ -9,19 +9,13 @@ namespace nel
     {
     }
     
-    HeaderSetting::~HeaderSetting()
+    bool HeaderSetting::checkValue(CompilationContext& context, unsigned int min, unsigned int max)
     {
-        delete name;
-        delete expression;
-    }
-    
-    bool HeaderSetting::checkValue(unsigned int min, unsigned int max)
-    {
-        if(!expression->fold(true, false))
+        if(!expression->fold(context, true, false))
         {
             std::ostringstream os;
             os << "ines header has `" << name->getValue() << "` setting with a value which could not be resolved.";
-            error(os.str(), getSourcePosition());
+            error(context, os.str(), getSourcePosition());
             return false;
         }
         else if(expression->getFoldedValue() < min || expression->getFoldedValue() > max)
@@ -29,7 +23,7 @@ namespace nel
             std::ostringstream os;
             os << "ines header's `" << name->getValue() << "` setting must be between " <<
                 min << ".." << max << ", but got " << expression->getFoldedValue() << " instead.";
-            error(os.str(), getSourcePosition());
+            error(context, os.str(), getSourcePosition());
             return false;
         }
         return true;
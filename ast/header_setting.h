@@ -2,6 +2,7 @@
 
 #include "node.h"
 #include "expression.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -17,7 +18,6 @@ namespace nel
             
         public:    
             HeaderSetting(StringNode* name, Expression* expression, SourcePosition* sourcePosition);
-            ~HeaderSetting();
             
             /**
              * Returns the name of thing being assigned by this header setting.
@@ -39,6 +39,6 @@ namespace nel
              * Checks if a setting's value could be folded, and is acceptable.
              * Returns true when successful, and returns false and errors when invalid.
              */
-            bool checkValue(unsigned int min, unsigned int max);
+            bool checkValue(CompilationContext& context, unsigned int min, unsigned int max);
     };
 }
\ No newline at end of file
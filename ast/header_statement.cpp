@@ -7,18 +7,22 @@
 namespace nel
 {
 
+    static Set<std::string>::Type createRecognizedSettings()
+    {
+        Set<std::string>::Type recognizedSettings;
+        recognizedSettings.insert("mapper");
+        recognizedSettings.insert("prg");
+        recognizedSettings.insert("chr");
+        recognizedSettings.insert("mirroring");
+        recognizedSettings.insert("battery");
+        recognizedSettings.insert("fourscreen");
+        return recognizedSettings;
+    }
+
     Set<std::string>::Type& HeaderStatement::getRecognizedSettings()
     {
-        static Set<std::string>::Type recognizedSettings;
-        if(recognizedSettings.empty())
-        {
-            recognizedSettings.insert("mapper");
-            recognizedSettings.insert("prg");
-            recognizedSettings.insert("chr");
-            recognizedSettings.insert("mirroring");
-            recognizedSettings.insert("battery");
-            recognizedSettings.insert("fourscreen");
-        }
+        // Initialized once, even when several compilations reach this at the same time.
+        static Set<std::string>::Type recognizedSettings = createRecognizedSettings();
         return recognizedSettings;
     }
 
@@ -27,12 +31,7 @@ namespace nel
     {
     }
     
-    HeaderStatement::~HeaderStatement()
-    {
-        delete settings;
-    }
-    
-    HeaderSetting* HeaderStatement::findSetting(SettingTable& settingTable, std::string name, bool optional)
+    HeaderSetting* HeaderStatement::findSetting(CompilationContext& context, SettingTable& settingTable, std::string name, bool optional)
     {
         SettingTable::iterator match = settingTable.find(name);
         if(match != settingTable.end())
@@ -45,13 +44,13 @@ namespace nel
             {
                 std::ostringstream os;
                 os << "ines header is missing required setting `" << name << "`";
-                error(os.str(), getSourcePosition());
+                error(context, os.str(), getSourcePosition());
             }
             return 0;
         }
     }
     
-    void HeaderStatement::aggregate()
+    void HeaderStatement::aggregate(CompilationContext& context)
     {
         ListNode<HeaderSetting*>::ListType& list = settings->getList();
         SettingTable settingTable;
@@ -71,8 +70,10 @@ namespace nel
                     std::ostringstream os;
                     HeaderSetting* setting = match->second;
                     os << "ines header contains multiple `" << setting->getName()->getValue() <<
-                        "` settings, previously declared on " << setting->getSourcePosition() << ".";
-                    error(os.str(), list[i]->getSourcePosition());
+                        "` settings, previously declared on ";
+                    setting->getSourcePosition()->print(context, os);
+                    os << ".";
+                    error(context, os.str(), list[i]->getSourcePosition());
                     headerValid = false;
                 }
                 // If it doesn't, you can add it.
@@ -86,52 +87,57 @@ namespace nel
             {
                 std::ostringstream os;
                 os << "ines header contains unrecognized header setting `" << name << "`";
-                error(os.str(), list[i]->getSourcePosition());
+                error(context, os.str(), list[i]->getSourcePosition());
                 headerValid = false;
             }
         }       
         
-        HeaderSetting* mapper = findSetting(settingTable, "mapper");
-        HeaderSetting* prg = findSetting(settingTable, "prg");
-        HeaderSetting* chr = findSetting(settingTable, "chr");
-        HeaderSetting* mirroring = findSetting(settingTable, "mirroring", true);
-        HeaderSetting* battery = findSetting(settingTable, "battery", true);
-        HeaderSetting* fourscreen = findSetting(settingTable, "fourscreen", true);
+        HeaderSetting* mapper = findSetting(context, settingTable, "mapper");
+        HeaderSetting* prg = findSetting(context, settingTable, "prg");
+        HeaderSetting* chr = findSetting(context, settingTable, "chr");
+        HeaderSetting* mirroring = findSetting(context, settingTable, "mirroring", true);
+        HeaderSetting* battery = findSetting(context, settingTable, "battery", true);
+        HeaderSetting* fourscreen = findSetting(context, settingTable, "fourscreen", true);
         
         // I use bitwise operators with boolean expressions
         // to ensure that all checks are evaluated (more error reporting).
         // Here, the ternary operator's false case is used to
         // determine whether the header can still be valid if it
         // is missing a particular setting.
-        headerValid &= mapper ? mapper->checkValue(0, 255) : false;
-        headerValid &= prg ? prg->checkValue(1, 255) : false;
-        headerValid &= chr ? chr->checkValue(1, 255) : false;
-        headerValid &= mirroring ? mirroring->checkValue(0, 1) : true;
-        headerValid &= battery ? battery->checkValue(0, 1) : true;
-        headerValid &= fourscreen ? fourscreen->checkValue(0, 1) : true;
+        headerValid &= mapper ? mapper->checkValue(context, 0, 255) : false;
+        headerValid &= prg ? prg->checkValue(context, 1, 255) : false;
+        headerValid &= chr ? chr->checkValue(context, 1, 255) : false;
+        headerValid &= mirroring ? mirroring->checkValue(context, 0, 1) : true;
+        headerValid &= battery ? battery->checkValue(context, 0, 1) : true;
+        headerValid &= fourscreen ? fourscreen->checkValue(context, 0, 1) : true;
         
         if(headerValid)
         {
-            romGenerator = new RomGenerator(
+            context.setRomGenerator(new RomGenerator(
+                context,
                 mapper->getExpression()->getFoldedValue(),
                 prg->getExpression()->getFoldedValue(),
                 chr->getExpression()->getFoldedValue(),
                 mirroring ? mirroring->getExpression()->getFoldedValue() != 0 : false,
                 battery ? battery->getExpression()->getFoldedValue() != 0 : false,
                 fourscreen ? fourscreen->getExpression()->getFoldedValue() != 0 : false
-            );
+            ));
         }
         else
         {
-            error("ines header is invalid", getSourcePosition(), true);
+            error(context, "ines header is invalid", getSourcePosition(), true);
         }
     }
 
-    void HeaderStatement::validate()
+    void HeaderStatement::resolve(CompilationContext& context)
+    {
+    }
+
+    void HeaderStatement::validate(CompilationContext& context)
     {
     }
     
-    void HeaderStatement::generate()
+    void HeaderStatement::generate(CompilationContext& context)
     {
     }
     
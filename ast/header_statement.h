@@ -1,7 +1,7 @@
 #pragma once
 
 #include "set.h"
-#include "map.h"
+#include "flat_map.h"
 #include "statement.h"
 #include "list_node.h"
 #include "header_setting.h"
@@ -18,15 +18,14 @@ namespace nel
         private:
             ListNode<HeaderSetting*>* settings;
             typedef Set<std::string>::Type StringSet;
-            typedef Map<std::string, HeaderSetting*>::Type SettingTable;
+            typedef LookupMap<std::string, HeaderSetting*>::Type SettingTable;
             
             static StringSet& getRecognizedSettings();
         public:
             HeaderStatement(ListNode<HeaderSetting*>* settings, SourcePosition* sourcePosition);
-            ~HeaderStatement();
             
         private:
-            HeaderSetting* findSetting(SettingTable& settingTable, std::string name, bool optional = false);
+            HeaderSetting* findSetting(CompilationContext& context, SettingTable& settingTable, std::string name, bool optional = false);
             
         public:
             /**
@@ -37,8 +36,9 @@ namespace nel
                 return settings;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <cstdio>
+
+#include "json.h"
+
+namespace nel
+{
+    void writeJsonString(std::ostream& os, const std::string& s)
+    {
+        os << "\"";
+        for(size_t i = 0; i < s.size(); i++)
+        {
+            unsigned char c = s[i];
+            if(c == '"' || c == '\\')
+            {
+                os << "\\" << c;
+            }
+            else if(c < 0x20)
+            {
+                char escape[8];
+                sprintf(escape, "\\u%04x", c);
+                os << escape;
+            }
+            else
+            {
+                os << c;
+            }
+        }
+        os << "\"";
+    }
+}
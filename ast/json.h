@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+
+namespace nel
+{
+    /**
+     * Writes a string to a stream as a quoted JSON string literal.
+     */
+    void writeJsonString(std::ostream& os, const std::string& s);
+}
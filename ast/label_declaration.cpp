@@ -12,20 +12,19 @@ namespace nel
     {
     }
     
-    LabelDeclaration::~LabelDeclaration()
+    void LabelDeclaration::aggregate(CompilationContext& context)
     {
-        delete name;
+        definition = new LabelDefinition(name->getValue(), this);
+        context.getActiveScope()->put(context, definition, name->getSourcePosition());
     }
     
-    void LabelDeclaration::aggregate()
+    void LabelDeclaration::resolve(CompilationContext& context)
     {
-        definition = new LabelDefinition(name->getValue(), this);
-        SymbolTable::getActiveScope()->put(definition, name->getSourcePosition());
     }
-    
-    void LabelDeclaration::validate()
+
+    void LabelDeclaration::validate(CompilationContext& context)
     {
-        RomBank* bank = romGenerator->getActiveBank();
+        RomBank* bank = context.getRomGenerator()->getActiveBank();
         if(bank)
         {
             if(bank->hasOrigin())
@@ -34,16 +33,16 @@ namespace nel
             }
             else
             {
-                error("label declaration was found before the rom location in the current bank was set.", getSourcePosition(), true);
+                error(context, "label declaration was found before the rom location in the current bank was set.", getSourcePosition(), true);
             }
         }
         else
         {
-            error("label declaration found, but a rom bank hasn't been selected yet.", getSourcePosition(), true);
+            error(context, "label declaration found, but a rom bank hasn't been selected yet.", getSourcePosition(), true);
         }
     }
     
-    void LabelDeclaration::generate()
+    void LabelDeclaration::generate(CompilationContext& context)
     {
     }
 }
\ No newline at end of file
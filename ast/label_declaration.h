@@ -19,7 +19,6 @@ namespace nel
             
         public:    
             LabelDeclaration(StringNode* name, SourcePosition* sourcePosition);
-            ~LabelDeclaration();
             
             /**
              * Returns the name of the label being defined.
@@ -29,8 +28,9 @@ namespace nel
                 return name;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -2,42 +2,36 @@
 
 #include <vector>
 
+#include "arena.h"
 #include "node.h"   
 
 namespace nel
 {
     /**
      * A node representing a list of child nodes.
-     * The underlying structure is a contiguous list of items.
+     * The underlying structure is a contiguous list of items,
+     * stored in the same arena as the node.
      */
     template <typename T>
     class ListNode : public Node
     {
         public:
-            typedef std::vector<T> ListType;
+            typedef std::vector<T, ArenaAllocator<T> > ListType;
         private:
             ListType list;
             
         public:
             ListNode(SourcePosition* sourcePosition)
-                : Node(sourcePosition)
+                : Node(sourcePosition), list(ArenaAllocator<T>(Arena::getCurrent()))
             {
             }
             
             ListNode(T firstItem, SourcePosition* sourcePosition)
-                : Node(sourcePosition)
+                : Node(sourcePosition), list(ArenaAllocator<T>(Arena::getCurrent()))
             {
                 list.push_back(firstItem);
             }
             
-            ~ListNode()
-            {
-                for(size_t i = 0; i < list.size(); i++)
-                {
-                    delete list[i];
-                }
-            }
-            
             /**
              * Returns the underlying list contained by this node.
              */
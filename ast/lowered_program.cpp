@@ -0,0 +1,206 @@
+#include "error.h"
+#include "rom_generator.h"
+#include "rom_bank.h"
+#include "trace_recorder.h"
+#include "block_statement.h"
+#include "command_statement.h"
+#include "lowered_program.h"
+
+namespace nel
+{
+    namespace
+    {
+        // Spans for the blocks that a pass is inside of, which end innermost first,
+        // including when a fatal error unwinds past them.
+        struct BlockSpans
+        {
+            std::vector<TraceRecorder::Span*> spans;
+
+            ~BlockSpans()
+            {
+                while(!spans.empty())
+                {
+                    end();
+                }
+            }
+
+            void begin(CompilationContext& context, const char* pass, BlockStatement* block)
+            {
+                TraceRecorder::Span* span = new TraceRecorder::Span(context.getTraceRecorder(), pass, block->getName() ? "package" : "block");
+                spans.push_back(span);
+                block->describeSpan(context, *span);
+            }
+
+            void end()
+            {
+                delete spans.back();
+                spans.pop_back();
+            }
+        };
+
+        // Reports an error and returns false if there's no bank selected for a command statement's commands to go in.
+        bool hasBank(CompilationContext& context, RomBank* bank, Statement* statement)
+        {
+            if(!bank)
+            {
+                error(context, "command statement found, but a rom bank hasn't been selected yet", statement->getSourcePosition(), true);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    LoweredProgram::LoweredProgram()
+    {
+        // A record's commands end where the next record's begin, so the last record needs something after it.
+        firstCommands.push_back(0);
+    }
+
+    void LoweredProgram::addRecord(RecordType recordType, Statement* statement)
+    {
+        recordTypes.push_back(recordType);
+        statements.push_back(statement);
+        firstCommands.push_back(commands.size());
+    }
+
+    void LoweredProgram::beginBlock(BlockStatement* block)
+    {
+        addRecord(BLOCK_BEGIN, block);
+    }
+
+    void LoweredProgram::endBlock(BlockStatement* block)
+    {
+        addRecord(BLOCK_END, block);
+    }
+
+    void LoweredProgram::addStatement(Statement* statement)
+    {
+        switch(statement->getStatementType())
+        {
+            case Statement::COMMAND:
+            {
+                ListNode<Command*>::ListType& list = static_cast<CommandStatement*>(statement)->getCommands()->getList();
+                for(size_t i = 0; i < list.size(); i++)
+                {
+                    Command* command = list[i];
+                    if(command)
+                    {
+                        commands.push_back(command);
+                        commandPositions.push_back(command->getSourcePosition());
+                    }
+                }
+                addRecord(COMMANDS, statement);
+                break;
+            }
+            case Statement::LABEL_DECLARATION:
+                addRecord(LABEL, statement);
+                break;
+            // Everything these do is done by the first pass.
+            case Statement::HEADER:
+            case Statement::CONSTANT_DECLARATION:
+            case Statement::VARAIBLE_DECLARATION:
+                break;
+            default:
+                addRecord(STATEMENT, statement);
+                break;
+        }
+    }
+
+    void LoweredProgram::validate(CompilationContext& context)
+    {
+        RomGenerator* romGenerator = context.getRomGenerator();
+        bool tracing = context.getTraceRecorder() != 0;
+        BlockSpans blockSpans;
+
+        // Only other statements can select a different bank, so it's looked up again after each of them.
+        RomBank* bank = romGenerator->getActiveBank();
+        for(size_t i = 0; i < recordTypes.size(); i++)
+        {
+            switch(recordTypes[i])
+            {
+                case BLOCK_BEGIN:
+                    if(tracing)
+                    {
+                        blockSpans.begin(context, "validate", static_cast<BlockStatement*>(statements[i]));
+                    }
+                    break;
+                case BLOCK_END:
+                    if(tracing)
+                    {
+                        blockSpans.end();
+                    }
+                    break;
+                case COMMANDS:
+                {
+                    // Reserve the bytes needed for these commands.
+                    if(!hasBank(context, bank, statements[i]))
+                    {
+                        break;
+                    }
+
+                    unsigned int end = firstCommands[i + 1];
+                    for(unsigned int j = firstCommands[i]; j < end; j++)
+                    {
+                        bank->expand(commands[j]->calculateSize(context), commandPositions[j]);
+                    }
+                    break;
+                }
+                case LABEL:
+                    statements[i]->validate(context);
+                    break;
+                case STATEMENT:
+                    statements[i]->validate(context);
+                    bank = romGenerator->getActiveBank();
+                    break;
+            }
+        }
+    }
+
+    void LoweredProgram::generate(CompilationContext& context)
+    {
+        RomGenerator* romGenerator = context.getRomGenerator();
+        bool tracing = context.getTraceRecorder() != 0;
+        BlockSpans blockSpans;
+
+        RomBank* bank = romGenerator->getActiveBank();
+        for(size_t i = 0; i < recordTypes.size(); i++)
+        {
+            switch(recordTypes[i])
+            {
+                case BLOCK_BEGIN:
+                    if(tracing)
+                    {
+                        blockSpans.begin(context, "generate", static_cast<BlockStatement*>(statements[i]));
+                    }
+                    break;
+                case BLOCK_END:
+                    if(tracing)
+                    {
+                        blockSpans.end();
+                    }
+                    break;
+                case COMMANDS:
+                {
+                    if(!hasBank(context, bank, statements[i]))
+                    {
+                        break;
+                    }
+
+                    unsigned int end = firstCommands[i + 1];
+                    for(unsigned int j = firstCommands[i]; j < end; j++)
+                    {
+                        commands[j]->write(context, bank);
+                    }
+                    break;
+                }
+                case LABEL:
+                    // Labels were placed by the second pass.
+                    break;
+                case STATEMENT:
+                    statements[i]->generate(context);
+                    bank = romGenerator->getActiveBank();
+                    break;
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+
+#include "source_position.h"
+#include "compilation_context.h"
+
+namespace nel
+{
+    class Statement;
+    class BlockStatement;
+    class Command;
+
+    /**
+     * The statements of a program, flattened out of its tree of blocks as the
+     * first pass resolves them, so that the second and third passes can run as
+     * loops over contiguous arrays instead of walking the tree through virtual calls.
+     *
+     * Each statement gets a record, with nested blocks marked by a record where
+     * they begin and another where they end. The commands of every command
+     * statement, which make up most of a program, are laid out in arrays of
+     * their own, so that sizing and writing them doesn't go through the
+     * statement or its list. Statements with nothing to do in either pass,
+     * like declarations of constants, are left out.
+     */
+    class LoweredProgram
+    {
+        public:
+            /**
+             * An enumeration of all the kinds of records.
+             */
+            enum RecordType
+            {
+                BLOCK_BEGIN,    /**< The start of a block, which is the record's statement. */
+                BLOCK_END,      /**< The end of the block most recently begun. */
+                COMMANDS,       /**< A command statement, whose commands run up to the next record's first command. */
+                LABEL,          /**< A label declaration, which only has its location taken by the second pass. */
+                STATEMENT       /**< Any other statement, which each pass calls into. */
+            };
+
+        private:
+            // One of each of these per record.
+            std::vector<unsigned char> recordTypes;
+            std::vector<Statement*> statements;
+            // The index of the record's first command, or of the next command for records without any.
+            // Has one more entry than there are records, so a record's commands always end at the next entry.
+            std::vector<unsigned int> firstCommands;
+
+            // One of each of these per command.
+            std::vector<Command*> commands;
+            std::vector<SourcePosition*> commandPositions;
+
+            // Not copyable.
+            LoweredProgram(const LoweredProgram&);
+            LoweredProgram& operator=(const LoweredProgram&);
+
+            void addRecord(RecordType recordType, Statement* statement);
+
+        public:
+            LoweredProgram();
+
+            /**
+             * Marks where a block begins, before any of its statements are added.
+             */
+            void beginBlock(BlockStatement* block);
+
+            /**
+             * Marks where the block most recently begun ends, after all of its statements were added.
+             */
+            void endBlock(BlockStatement* block);
+
+            /**
+             * Adds a statement, other than a block, after those added before it.
+             */
+            void addStatement(Statement* statement);
+
+            /**
+             * Basic validation of statements and calculating operation sizes and label positions.
+             */
+            void validate(CompilationContext& context);
+
+            /**
+             * Final validation and code output.
+             */
+            void generate(CompilationContext& context);
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+#include <cstddef>
+
+namespace nel
+{
+    /**
+     * A map from names to values that holds at most a given number of bytes,
+     * for caches kept in memory by a long-running compiler.
+     *
+     * Each value is put with what it costs. When the total goes over the limit,
+     * the values used least recently are dropped until it fits again, though
+     * the value just put is always kept, however much it costs.
+     *
+     * Not safe to use from more than one thread at once.
+     */
+    template <typename V>
+    class LruMap
+    {
+        private:
+            struct Entry
+            {
+                V value;
+                size_t cost;
+                // Where the entry's name is in the order of use.
+                std::list<std::string>::iterator use;
+            };
+
+            // The most bytes to hold.
+            size_t limit;
+            // The bytes held.
+            size_t total;
+            std::map<std::string, Entry> entries;
+            // The names of the entries, from the most recently used to the least.
+            std::list<std::string> uses;
+
+        public:
+            LruMap(size_t limit)
+                : limit(limit), total(0)
+            {
+            }
+
+            /**
+             * Returns the value under a name, marking it as used, or 0 if there isn't one.
+             */
+            V* find(const std::string& name)
+            {
+                typename std::map<std::string, Entry>::iterator it = entries.find(name);
+                if(it == entries.end())
+                {
+                    return 0;
+                }
+                uses.splice(uses.begin(), uses, it->second.use);
+                return &it->second.value;
+            }
+
+            /**
+             * Puts a value under a name, replacing any there was, then drops the
+             * least recently used values until the rest fit within the limit.
+             */
+            void put(const std::string& name, const V& value, size_t cost)
+            {
+                typename std::map<std::string, Entry>::iterator it = entries.find(name);
+                if(it != entries.end())
+                {
+                    total -= it->second.cost;
+                    uses.erase(it->second.use);
+                    entries.erase(it);
+                }
+
+                uses.push_front(name);
+                Entry& entry = entries[name];
+                entry.value = value;
+                entry.cost = cost;
+                entry.use = uses.begin();
+                total += cost;
+
+                while(total > limit && uses.size() > 1)
+                {
+                    typename std::map<std::string, Entry>::iterator last = entries.find(uses.back());
+                    total -= last->second.cost;
+                    entries.erase(last);
+                    uses.pop_back();
+                }
+            }
+
+            /**
+             * Returns the number of values held.
+             */
+            size_t size() const
+            {
+                return entries.size();
+            }
+
+            /**
+             * Returns the bytes held.
+             */
+            size_t getTotal() const
+            {
+                return total;
+            }
+    };
+}
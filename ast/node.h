@@ -3,29 +3,51 @@
 #include <string>
 #include <iostream>
 
+#include "arena.h"
 #include "source_position.h"
+#include "statistics.h"
 
 namespace nel
 {
-    class SourcePosition;
-
     /**
      * An abstract node from which all other nodes are defined.
+     *
+     * Nodes are allocated from the current arena, which owns them,
+     * so a node never deletes the nodes underneath it.
      */
     class Node
     {
         private:
-            SourcePosition* sourcePosition;
+            SourcePosition sourcePosition;
+            
+            static void finalize(void* node)
+            {
+                static_cast<Node*>(node)->~Node();
+            }
             
         public:
+            static void* operator new(size_t size)
+            {
+                return Arena::allocateObject(size, &finalize);
+            }
+            
+            static void operator delete(void* node)
+            {
+                Arena::releaseObject(node);
+            }
+            
+
+            /**
+             * Creates a node at a copy of the given position, or an unknown position if that's 0.
+             */
             Node(SourcePosition* sourcePosition)
-                : sourcePosition(sourcePosition)
+                : sourcePosition(sourcePosition ? *sourcePosition : SourcePosition())
             {
+                Statistics::count(Statistics::NODES_ALLOCATED);
             }
             
             virtual ~Node()
             {
-                delete sourcePosition;
             }
             
             /**
@@ -33,7 +55,7 @@ namespace nel
              */
             virtual SourcePosition* getSourcePosition()
             {
-                return sourcePosition;
+                return &sourcePosition;
             }
     };
 }
\ No newline at end of file
@@ -6,10 +6,4 @@ namespace nel
         : Node(sourcePosition), operationType(operationType), left(left), right(right)
     {
     }
-    
-    Operation::~Operation()
-    {
-        delete left;
-        delete right;
-    }
 }
\ No newline at end of file
@@ -43,7 +43,6 @@ namespace nel
             Expression* right;
         public:
             Operation(OperationType operationType, Expression* left, Expression* right, SourcePosition* sourcePosition);
-            ~Operation();
             
             /**
              * Gets the type of operation to perform.
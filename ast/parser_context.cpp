@@ -0,0 +1,74 @@
+#include "error.h"
+#include "compilation_context.h"
+#include "required_file.h"
+#include "parser_context.h"
+
+namespace nel
+{
+    ParserContext::ParserContext(CompilationContext& context, bool deferred)
+        : context(&context), scanner(0), stringTerminator(0), deferred(deferred),
+        requireQueue(0), nextRequire(0), statements(0)
+    {
+    }
+
+    TraceRecorder* ParserContext::getTraceRecorder()
+    {
+        return deferred ? 0 : context->getTraceRecorder();
+    }
+
+    void ParserContext::error(const std::string& message, SourcePosition* sourcePosition, bool fatal)
+    {
+        if(!deferred)
+        {
+            nel::error(*context, message, sourcePosition, fatal);
+            return;
+        }
+
+        Diagnostic diagnostic;
+        diagnostic.text = formatError(*context, message, sourcePosition, fatal);
+        diagnostic.fatal = fatal;
+        diagnostics.push_back(diagnostic);
+        if(fatal)
+        {
+            // Abandon the parse. The compilation fails once this is reported.
+            throw FatalError("compilation failed");
+        }
+    }
+
+    void ParserContext::report(const std::vector<Diagnostic>& diagnostics)
+    {
+        for(size_t i = 0; i < diagnostics.size(); i++)
+        {
+            const Diagnostic& diagnostic = diagnostics[i];
+            if(!deferred)
+            {
+                reportError(*context, diagnostic.text, diagnostic.fatal);
+            }
+            else
+            {
+                this->diagnostics.push_back(diagnostic);
+                if(diagnostic.fatal)
+                {
+                    throw FatalError("compilation failed");
+                }
+            }
+        }
+    }
+
+    RequiredFile* ParserContext::findRequire(const std::string& filename, SourcePosition includePoint)
+    {
+        // Requires are reached in the order they were queued, unless error recovery skipped some.
+        for(size_t i = nextRequire; i < requires.size(); i++)
+        {
+            RequiredFile* file = requires[i];
+            if(file->getIncludePoint().getFile() == includePoint.getFile()
+                && file->getIncludePoint().getOffset() == includePoint.getOffset()
+                && file->getFilename() == filename)
+            {
+                nextRequire = i + 1;
+                return file;
+            }
+        }
+        return 0;
+    }
+}
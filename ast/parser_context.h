@@ -0,0 +1,253 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "source_position.h"
+
+namespace nel
+{
+    class CompilationContext;
+    class TraceRecorder;
+    class Statement;
+    class RequiredFile;
+    class RequireQueue;
+    template <typename T> class ListNode;
+
+    /**
+     * The state of a single parse, shared by the parser and the lexer:
+     * where the lexer is in the source, which files it's in the middle of,
+     * and the string literal it's scanning.
+     *
+     * Neither of them keep anything in globals, so any number of files
+     * may be parsed at once, each on a thread of its own, as long as
+     * every parse has its own context.
+     *
+     * A parse of a required file runs ahead of the rest of its compilation,
+     * on another thread. Its errors are deferred: they're kept here, and
+     * reported once the parse that required it gets to the require.
+     */
+    class ParserContext
+    {
+        public:
+            /**
+             * An error kept by a deferred parse, already formatted for the log.
+             */
+            struct Diagnostic
+            {
+                std::string text;
+                bool fatal;
+            };
+
+            /**
+             * A file required by this one, or by one that was spliced into it.
+             * Plain requires are spliced in as soon as they're reached, and only kept
+             * so that require once knows about them. A require once is spliced in later,
+             * at index in list, if nothing earlier in the program required the same file.
+             */
+            struct Inclusion
+            {
+                RequiredFile* file;
+                bool once;
+                ListNode<Statement*>* list;
+                size_t index;
+            };
+
+        private:
+            // The compilation that the parsed program belongs to.
+            CompilationContext* context;
+            // The lexer's own state, from createLexer(), or 0 if it hasn't been created.
+            void* scanner;
+            // The current position in source.
+            SourcePosition currentPosition;
+            // The stack of all included files.
+            std::vector<SourcePosition> includeStack;
+            // Contains the content of a string literal being scanned.
+            std::string stringContent;
+            // The character used to terminate an active string literal.
+            char stringTerminator;
+
+            // Whether errors are kept in diagnostics, rather than reported to the compilation.
+            bool deferred;
+            std::vector<Diagnostic> diagnostics;
+            // Parses the files that this one requires.
+            RequireQueue* requireQueue;
+            // The files required by this one that were queued before it was parsed, in order.
+            std::vector<RequiredFile*> requires;
+            size_t nextRequire;
+            // The statements of the whole file, once it's been parsed.
+            ListNode<Statement*>* statements;
+            // Every file required so far, in the order they appear in the program.
+            std::vector<Inclusion> inclusions;
+
+        public:
+            ParserContext(CompilationContext& context, bool deferred = false);
+
+        private:
+            // Parses can't be copied in the middle of their input.
+            ParserContext(const ParserContext&);
+            ParserContext& operator=(const ParserContext&);
+
+        public:
+            /**
+             * Returns the compilation that this parse belongs to.
+             */
+            CompilationContext& getContext()
+            {
+                return *context;
+            }
+
+            /**
+             * Returns the lexer's state, or 0 if it hasn't been created.
+             */
+            void* getScanner()
+            {
+                return scanner;
+            }
+
+            /**
+             * Sets the lexer's state. Only createLexer() and destroyLexer() should need this.
+             */
+            void setScanner(void* value)
+            {
+                scanner = value;
+            }
+
+            /**
+             * Returns the current position of the lexer in source.
+             * It's unknown until the first file is opened.
+             */
+            SourcePosition* getCurrentPosition()
+            {
+                return &currentPosition;
+            }
+
+            /**
+             * Sets the current position of the lexer in source.
+             */
+            void setCurrentPosition(const SourcePosition& value)
+            {
+                currentPosition = value;
+            }
+
+            /**
+             * Returns the stack of positions where each active file was included.
+             */
+            std::vector<SourcePosition>& getIncludeStack()
+            {
+                return includeStack;
+            }
+
+            /**
+             * Returns the content of the string literal being scanned.
+             */
+            std::string& getStringContent()
+            {
+                return stringContent;
+            }
+
+            /**
+             * Returns the character that terminates the string literal being scanned.
+             */
+            char& getStringTerminator()
+            {
+                return stringTerminator;
+            }
+
+            /**
+             * Returns whether this parse's errors are deferred.
+             */
+            bool isDeferred()
+            {
+                return deferred;
+            }
+
+            /**
+             * Returns the recorder tracing this parse, or 0 if it isn't traced.
+             * Deferred parses aren't, since they run on threads of their own.
+             */
+            TraceRecorder* getTraceRecorder();
+
+            /**
+             * Raises an error in the source being parsed, like nel::error(). A deferred
+             * parse keeps it until it's reported, although a fatal error still ends the parse.
+             */
+            void error(const std::string& message, SourcePosition* sourcePosition, bool fatal = false);
+
+            /**
+             * Reports the errors kept by a deferred parse, as if they were raised by this one.
+             */
+            void report(const std::vector<Diagnostic>& diagnostics);
+
+            /**
+             * Returns the errors kept so far, if this parse is deferred.
+             */
+            std::vector<Diagnostic>& getDiagnostics()
+            {
+                return diagnostics;
+            }
+
+            /**
+             * Returns the queue that parses this one's required files, or 0 if there isn't one.
+             */
+            RequireQueue* getRequireQueue()
+            {
+                return requireQueue;
+            }
+
+            /**
+             * Sets the queue that parses this one's required files.
+             */
+            void setRequireQueue(RequireQueue* value)
+            {
+                requireQueue = value;
+            }
+
+            /**
+             * Adds a required file that was queued before this file was parsed.
+             * Required files must be added in the order they appear.
+             */
+            void addRequire(RequiredFile* file)
+            {
+                requires.push_back(file);
+            }
+
+            /**
+             * Finds the queued file for a require of filename that ends at the given position,
+             * or returns 0 if it wasn't queued.
+             */
+            RequiredFile* findRequire(const std::string& filename, SourcePosition includePoint);
+
+            /**
+             * Returns the files required so far, in the order they appear in the program.
+             */
+            std::vector<Inclusion>& getInclusions()
+            {
+                return inclusions;
+            }
+
+            /**
+             * Adds a file required by this one, after all the others.
+             */
+            void addInclusion(const Inclusion& inclusion)
+            {
+                inclusions.push_back(inclusion);
+            }
+
+            /**
+             * Returns the statements of the file, or 0 if it hasn't been parsed.
+             */
+            ListNode<Statement*>* getStatements()
+            {
+                return statements;
+            }
+
+            /**
+             * Sets the statements of the file, once it's been parsed.
+             */
+            void setStatements(ListNode<Statement*>* value)
+            {
+                statements = value;
+            }
+    };
+}
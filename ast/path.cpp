@@ -18,5 +18,17 @@ namespace nel
         }
 
         return s.substr(0, p + 1);
-    }   
+    }
+
+    std::string replaceExtension(const std::string& s, const std::string& extension)
+    {
+        std::string::size_type slash = s.find_last_of(delimiters);
+        std::string::size_type dot = s.find_last_of('.');
+        if(dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        {
+            return s + extension;
+        }
+
+        return s.substr(0, dot) + extension;
+    }
 }
\ No newline at end of file
@@ -5,4 +5,5 @@
 namespace nel
 {
     std::string getDirectory(const std::string& path);
+    std::string replaceExtension(const std::string& path, const std::string& extension);
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "error.h"
+#include "path.h"
+#include "symbol_pool.h"
+#include "source_buffer.h"
+#include "string_node.h"
+#include "number_node.h"
+#include "expression.h"
+#include "block_statement.h"
+#include "constant_declaration.h"
+#include "precompiled_package.h"
+
+namespace nel
+{
+    namespace
+    {
+        const char MAGIC[8] = {'N', 'E', 'L', 'P', 'K', 'G', 0, 0};
+
+        void putU32(std::string& output, unsigned int value)
+        {
+            for(unsigned int i = 0; i < 4; i++)
+            {
+                output += (char) ((value >> (i * 8)) & 0xFF);
+            }
+        }
+
+        void putU64(std::string& output, unsigned long long value)
+        {
+            putU32(output, (unsigned int) (value & 0xFFFFFFFF));
+            putU32(output, (unsigned int) (value >> 32));
+        }
+
+        unsigned int getU32(const char* data)
+        {
+            const unsigned char* p = (const unsigned char*) data;
+            return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+        }
+
+        unsigned long long getU64(const char* data)
+        {
+            return getU32(data) | ((unsigned long long) getU32(data + 4) << 32);
+        }
+
+        /**
+         * The records and names of a package being written.
+         */
+        struct Output
+        {
+            unsigned int file;
+            unsigned int count;
+            std::string records;
+            std::string names;
+
+            void addRecord(unsigned int kind, SourcePosition* position, SourcePosition* namePosition, SourcePosition* valuePosition,
+                const std::string& name, unsigned int value)
+            {
+                putU32(records, kind);
+                putU32(records, position->getOffset());
+                putU32(records, namePosition ? namePosition->getOffset() : 0);
+                putU32(records, valuePosition ? valuePosition->getOffset() : 0);
+                putU32(records, names.size());
+                putU32(records, name.size());
+                putU32(records, value);
+                names += name;
+                count++;
+            }
+        };
+
+        // Adds the records for a list of statements, and returns false if any can't be precompiled.
+        bool writeStatements(CompilationContext& context, ListNode<Statement*>* statements, Output& output)
+        {
+            bool success = true;
+            ListNode<Statement*>::ListType& list = statements->getList();
+            for(size_t i = 0; i < list.size(); i++)
+            {
+                Statement* statement = list[i];
+                if(statement->getSourcePosition()->getFile() != output.file)
+                {
+                    error(context, "a precompiled package cannot require other files.", statement->getSourcePosition());
+                    success = false;
+                    continue;
+                }
+
+                switch(statement->getStatementType())
+                {
+                    case Statement::CONSTANT_DECLARATION:
+                    {
+                        ConstantDeclaration* constant = (ConstantDeclaration*) statement;
+                        Expression* expression = constant->getExpression();
+                        if(expression->fold(context, true, true))
+                        {
+                            output.addRecord(PrecompiledPackage::CONSTANT, constant->getSourcePosition(), constant->getName()->getSourcePosition(),
+                                expression->getSourcePosition(), constant->getName()->getValue(), expression->getFoldedValue());
+                        }
+                        else
+                        {
+                            success = false;
+                        }
+                        break;
+                    }
+                    case Statement::BLOCK:
+                    {
+                        BlockStatement* block = (BlockStatement*) statement;
+                        if(block->getName())
+                        {
+                            output.addRecord(PrecompiledPackage::PACKAGE_BEGIN, block->getSourcePosition(), block->getName()->getSourcePosition(),
+                                0, block->getName()->getValue(), 0);
+                            success = writeStatements(context, block->getStatements(), output) && success;
+                            output.addRecord(PrecompiledPackage::PACKAGE_END, block->getSourcePosition(), 0, 0, "", 0);
+                            break;
+                        }
+                        // Otherwise, it's a begin/end block, which can't be precompiled.
+                    }
+                    default:
+                    {
+                        error(context, "only constants and packages can be precompiled.", statement->getSourcePosition());
+                        success = false;
+                        break;
+                    }
+                }
+            }
+            return success;
+        }
+
+        /**
+         * A package whose statements are still being read.
+         */
+        struct OpenPackage
+        {
+            ListNode<Statement*>* statements;
+            StringNode* name;
+            SourcePosition position;
+        };
+    }
+
+    std::string PrecompiledPackage::getFilename(const std::string& sourceFilename)
+    {
+        return replaceExtension(sourceFilename, ".nelpkg");
+    }
+
+    bool PrecompiledPackage::writeToMemory(CompilationContext& context, BlockStatement* block, const FileIdentity& source, std::string& package)
+    {
+        Output output;
+        output.file = block->getSourcePosition()->getFile();
+        output.count = 0;
+        if(!writeStatements(context, block->getStatements(), output))
+        {
+            return false;
+        }
+
+        package.assign(MAGIC, sizeof(MAGIC));
+        putU32(package, VERSION);
+        putU32(package, output.count);
+        putU32(package, output.names.size());
+        putU32(package, 0);
+        putU64(package, source.getSize());
+        putU64(package, source.getHash().low);
+        putU64(package, source.getHash().high);
+        package += output.records;
+        package += output.names;
+        return true;
+    }
+
+    bool PrecompiledPackage::write(CompilationContext& context, BlockStatement* block, const FileIdentity& source, const std::string& filename)
+    {
+        std::string package;
+        if(!writeToMemory(context, block, source, package))
+        {
+            return false;
+        }
+
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+        if(!file.is_open())
+        {
+            context.getLog() << "* " << PROGRAM_NAME << ": failed to open '" << filename << "' for writing." << std::endl;
+            return false;
+        }
+        file << package;
+        file.close();
+        return !file.fail();
+    }
+
+    ListNode<Statement*>* PrecompiledPackage::load(const std::string& filename, const FileIdentity& source, unsigned int file, bool mapFile)
+    {
+        SourceBuffer* buffer = mapFile ? SourceBuffer::map(filename) : 0;
+        if(!buffer)
+        {
+            if(FILE* f = fopen(filename.c_str(), "rb"))
+            {
+                buffer = SourceBuffer::read(f);
+                fclose(f);
+            }
+        }
+        if(!buffer)
+        {
+            return 0;
+        }
+
+        ListNode<Statement*>* statements = loadFromMemory(buffer->getData(), buffer->getSize(), source, file);
+        delete buffer;
+        return statements;
+    }
+
+    ListNode<Statement*>* PrecompiledPackage::loadFromMemory(const char* data, size_t size, const FileIdentity& source, unsigned int file)
+    {
+        if(size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) || getU32(data + 8) != VERSION
+            || !source.isHashed() || getU64(data + 24) != source.getSize() || getU64(data + 32) != source.getHash().low
+            || getU64(data + 40) != source.getHash().high)
+        {
+            return 0;
+        }
+
+        unsigned long long count = getU32(data + 12);
+        unsigned long long namesSize = getU32(data + 16);
+        if(HEADER_SIZE + count * RECORD_SIZE + namesSize != size)
+        {
+            return 0;
+        }
+
+        const char* names = data + HEADER_SIZE + count * RECORD_SIZE;
+        std::vector<OpenPackage> packages;
+        SourcePosition start(file);
+        OpenPackage top = {new ListNode<Statement*>(&start), 0, start};
+        packages.push_back(top);
+
+        bool damaged = false;
+        for(unsigned long long i = 0; i < count && !damaged; i++)
+        {
+            const char* record = data + HEADER_SIZE + i * RECORD_SIZE;
+            unsigned int kind = getU32(record);
+            unsigned int offsets[3] = {getU32(record + 4), getU32(record + 8), getU32(record + 12)};
+            unsigned int nameStart = getU32(record + 16);
+            unsigned int nameLength = getU32(record + 20);
+            unsigned int value = getU32(record + 24);
+
+            SourcePosition positions[3] = {SourcePosition(file), SourcePosition(file), SourcePosition(file)};
+            for(unsigned int j = 0; j < 3; j++)
+            {
+                damaged = damaged || offsets[j] > source.getSize();
+                positions[j].setOffset(offsets[j]);
+            }
+            damaged = damaged || (unsigned long long) nameStart + nameLength > namesSize;
+            if(damaged)
+            {
+                break;
+            }
+
+            switch(kind)
+            {
+                case CONSTANT:
+                {
+                    StringNode* name = new StringNode(SymbolPool::intern(std::string(names + nameStart, nameLength)), &positions[1]);
+                    Expression* expression = new Expression(new NumberNode(value, &positions[2]), &positions[2]);
+                    packages.back().statements->getList().push_back(new ConstantDeclaration(name, expression, &positions[0]));
+                    break;
+                }
+                case PACKAGE_BEGIN:
+                {
+                    StringNode* name = new StringNode(SymbolPool::intern(std::string(names + nameStart, nameLength)), &positions[1]);
+                    OpenPackage package = {new ListNode<Statement*>(&positions[0]), name, positions[0]};
+                    packages.push_back(package);
+                    break;
+                }
+                case PACKAGE_END:
+                {
+                    if(packages.size() < 2)
+                    {
+                        damaged = true;
+                        break;
+                    }
+                    OpenPackage package = packages.back();
+                    packages.pop_back();
+                    packages.back().statements->getList().push_back(
+                        new BlockStatement(BlockStatement::SCOPE, package.name, package.statements, &package.position));
+                    break;
+                }
+                default:
+                {
+                    damaged = true;
+                    break;
+                }
+            }
+        }
+
+        // Whatever was read of a damaged package is left to the arena.
+        if(damaged || packages.size() != 1)
+        {
+            return 0;
+        }
+        return packages.back().statements;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+
+#include "file_identity.h"
+#include "list_node.h"
+#include "statement.h"
+
+namespace nel
+{
+    class CompilationContext;
+    class BlockStatement;
+
+    /**
+     * A source file of constants and packages, compiled ahead of time so that
+     * requiring it doesn't need to lex or parse it, like a precompiled header.
+     *
+     * Every constant is stored folded down to its value, along with the
+     * positions of its declaration in the source, so that errors about it
+     * still point there. Packages are stored as the constants and packages
+     * between a begin and an end record.
+     *
+     * A precompiled package is made from one source file with nothing required,
+     * and records the size and hash of its text. It's only used in place of
+     * a file whose text still matches. All numbers are little-endian:
+     *
+     *     header:  "NELPKG" 0 0, u32 version, u32 record count, u32 names size,
+     *              u32 reserved, u64 source size, u64 low and u64 high half of the source hash
+     *     records: u32 kind, u32 position, u32 name position, u32 value position,
+     *              u32 name start, u32 name length, u32 value
+     *     names:   the names of every constant and package, back to back
+     */
+    class PrecompiledPackage
+    {
+        public:
+            enum RecordKind
+            {
+                CONSTANT,       /**< A constant, with its folded value. */
+                PACKAGE_BEGIN,  /**< The start of a package, with its name. */
+                PACKAGE_END     /**< The end of the last package begun. */
+            };
+
+            enum
+            {
+                VERSION = 2,
+                HEADER_SIZE = 48,
+                RECORD_SIZE = 28
+            };
+
+            /**
+             * Returns the filename that the precompiled package for a source file is expected to have.
+             */
+            static std::string getFilename(const std::string& sourceFilename);
+
+            /**
+             * Writes a precompiled package of an aggregated and resolved block, which came from
+             * the source file with the given identity. Reports an error and returns false
+             * if the block holds anything but constants that fold and packages of them.
+             */
+            static bool write(CompilationContext& context, BlockStatement* block, const FileIdentity& source, const std::string& filename);
+
+            /**
+             * Like the above, but writes the package into memory instead of a file.
+             */
+            static bool writeToMemory(CompilationContext& context, BlockStatement* block, const FileIdentity& source, std::string& package);
+
+            /**
+             * Reads the statements of a precompiled package for the source file with the given identity,
+             * which is the given file in the compilation's file table. Returns 0 if there's no
+             * package, or it was made from different text, or it's damaged, so the source is parsed instead.
+             * The package is mapped into memory if mapFile is set, like a source file, or read otherwise.
+             */
+            static ListNode<Statement*>* load(const std::string& filename, const FileIdentity& source, unsigned int file, bool mapFile);
+
+            /**
+             * Like the above, but reads a package that's already in memory.
+             */
+            static ListNode<Statement*>* loadFromMemory(const char* data, size_t size, const FileIdentity& source, unsigned int file);
+    };
+}
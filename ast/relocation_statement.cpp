@@ -14,54 +14,60 @@ namespace nel
         : Statement(Statement::RELOCATION, sourcePosition), relocationType(relocationType), bankExpression(bankExpression), destinationExpression(destinationExpression)
     {
     }
-
-    RelocationStatement::~RelocationStatement()
-    {
-        delete bankExpression;
-        delete destinationExpression;
-    }
     
-    void RelocationStatement::aggregate()
+    void RelocationStatement::aggregate(CompilationContext& context)
     {
         if(relocationType == RAM)
         {
             if(destinationExpression)
             {
-                if(destinationExpression->fold(true, false))
+                if(destinationExpression->fold(context, true, false))
                 {
-                    romGenerator->moveRam(destinationExpression->getFoldedValue());
+                    context.getRomGenerator()->moveRam(destinationExpression->getFoldedValue());
                 }
                 else
                 {
-                    error("could not resolve the destination address provided to this ram relocation statement", getSourcePosition(), true);
+                    error(context, "could not resolve the destination address provided to this ram relocation statement", getSourcePosition(), true);
                 }
             }
         }
     }
 
-    void RelocationStatement::validate()
+    void RelocationStatement::resolve(CompilationContext& context)
+    {
+        if(bankExpression)
+        {
+            bankExpression->resolve(context);
+        }
+        if(destinationExpression)
+        {
+            destinationExpression->resolve(context);
+        }
+    }
+
+    void RelocationStatement::validate(CompilationContext& context)
     {
         if(relocationType == ROM)
         {
             if(bankExpression)
             {
-                if(bankExpression->fold(true, true))
+                if(bankExpression->fold(context, true, true))
                 {
-                    romGenerator->switchBank(bankExpression->getFoldedValue(), getSourcePosition());
+                    context.getRomGenerator()->switchBank(bankExpression->getFoldedValue(), getSourcePosition());
                 }
                 else
                 {
-                    error("could not resolve the bank number provided to this rom relocation statement", getSourcePosition(), true);
+                    error(context, "could not resolve the bank number provided to this rom relocation statement", getSourcePosition(), true);
                 }
             }
             if(destinationExpression)
             {
-                if(destinationExpression->fold(true, true))
+                if(destinationExpression->fold(context, true, true))
                 {
-                    RomBank* bank = romGenerator->getActiveBank();
+                    RomBank* bank = context.getRomGenerator()->getActiveBank();
                     if(!bank)
                     {
-                        error("rom relocation found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+                        error(context, "rom relocation found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
                     }
                     else
                     {
@@ -70,25 +76,25 @@ namespace nel
                 }
                 else
                 {
-                    error("could not resolve the destination address provided to this rom relocation statement", getSourcePosition(), true);
+                    error(context, "could not resolve the destination address provided to this rom relocation statement", getSourcePosition(), true);
                 }
             }
         }
     }
     
-    void RelocationStatement::generate()
+    void RelocationStatement::generate(CompilationContext& context)
     {
         if(relocationType == ROM)
         {
             if(bankExpression)
             {
-                romGenerator->switchBank(bankExpression->getFoldedValue(), getSourcePosition());
+                context.getRomGenerator()->switchBank(bankExpression->getFoldedValue(), getSourcePosition());
             }
             
-            RomBank* bank = romGenerator->getActiveBank();
+            RomBank* bank = context.getRomGenerator()->getActiveBank();
             if(!bank)
             {
-                error("rom relocation found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
+                error(context, "rom relocation found, but a rom bank hasn't been selected yet", getSourcePosition(), true);
             }
             else
             {
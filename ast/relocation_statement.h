@@ -29,7 +29,6 @@ namespace nel
         public:
             RelocationStatement(RelocationType relocationType, Expression* destinationExpression, SourcePosition* sourcePosition);
             RelocationStatement(RelocationType relocationType, Expression* bankExpression, Expression* destinationExpression, SourcePosition* sourcePosition);            
-            ~RelocationStatement();
             
             /**
              * Returns the type of relocation that this node represents.
@@ -55,8 +54,9 @@ namespace nel
                 return destinationExpression;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "arena.h"
+#include "statistics.h"
+#include "required_file.h"
+#include "compilation_context.h"
+#include "require_queue.h"
+
+namespace nel
+{
+    RequireQueue::RequireQueue(CompilationContext& context, ParseFunction parse, unsigned int threadCount)
+        : context(&context), parse(parse), workerCount(threadCount > 1 ? threadCount - 1 : 0), stopping(false)
+    {
+    }
+
+    RequireQueue::~RequireQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            pending.clear();
+        }
+        changed.notify_all();
+
+        for(size_t i = 0; i < workers.size(); i++)
+        {
+            workers[i].join();
+        }
+        for(size_t i = 0; i < workerStatistics.size(); i++)
+        {
+            context->getStatistics()->addCounters(*workerStatistics[i]);
+            delete workerStatistics[i];
+        }
+        for(size_t i = 0; i < files.size(); i++)
+        {
+            delete files[i];
+        }
+    }
+
+    RequiredFile* RequireQueue::add(const std::string& filename, const SourcePosition& includePoint, const std::vector<SourcePosition>& includeStack, bool once)
+    {
+        FileIdentity identity;
+        if(once)
+        {
+            identity = FileIdentity::ofPath(filename);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if(once)
+        {
+            for(size_t i = 0; i < onceFiles.size(); i++)
+            {
+                if(onceFiles[i].first.isSameFile(identity))
+                {
+                    return onceFiles[i].second;
+                }
+            }
+        }
+
+        RequiredFile* file = new RequiredFile(filename, includePoint, includeStack, once);
+        files.push_back(file);
+        if(once)
+        {
+            onceFiles.push_back(std::make_pair(identity, file));
+        }
+        if(workerCount)
+        {
+            pending.push_back(file);
+
+            // First file? Start up the workers.
+            if(workers.empty())
+            {
+                for(unsigned int i = 0; i < workerCount; i++)
+                {
+                    Statistics* statistics = 0;
+                    if(context->getStatistics())
+                    {
+                        statistics = new Statistics("");
+                        workerStatistics.push_back(statistics);
+                    }
+                    workers.push_back(std::thread(&RequireQueue::work, this, context->addArena(), statistics));
+                }
+            }
+            changed.notify_one();
+        }
+        return file;
+    }
+
+    void RequireQueue::finish(RequiredFile& file)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(!file.claimed)
+        {
+            file.claimed = true;
+            lock.unlock();
+            parse(*this, file);
+            lock.lock();
+            file.finished = true;
+            changed.notify_all();
+        }
+
+        while(!file.finished)
+        {
+            changed.wait(lock);
+        }
+    }
+
+    void RequireQueue::finishAll()
+    {
+        // Parsing a file can queue more after it, so the list is checked again after each one.
+        for(size_t i = 0; ; i++)
+        {
+            RequiredFile* file;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(i >= files.size())
+                {
+                    break;
+                }
+                file = files[i];
+            }
+            finish(*file);
+        }
+    }
+
+    void RequireQueue::work(Arena* arena, Statistics* statistics)
+    {
+        Arena::setCurrent(arena);
+        Statistics::setCurrent(statistics);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;)
+        {
+            while(pending.empty() && !stopping)
+            {
+                changed.wait(lock);
+            }
+            if(stopping)
+            {
+                break;
+            }
+
+            RequiredFile* file = pending.front();
+            pending.pop_front();
+            // A parse that needed it may have gotten to it first.
+            if(file->claimed)
+            {
+                continue;
+            }
+
+            file->claimed = true;
+            lock.unlock();
+            parse(*this, *file);
+            lock.lock();
+            file->finished = true;
+            changed.notify_all();
+        }
+
+        Arena::setCurrent(0);
+        Statistics::setCurrent(0);
+    }
+}
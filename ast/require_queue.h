@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "source_position.h"
+#include "file_identity.h"
+
+namespace nel
+{
+    class CompilationContext;
+    class RequiredFile;
+    class Statistics;
+    class Arena;
+
+    /**
+     * Parses a compilation's required files on a pool of threads.
+     *
+     * Files are queued as soon as their requires are found, and parsed by
+     * whichever thread gets to them first. That's either one of the queue's
+     * workers, or a parse that needs the file's statements before any worker
+     * has started on it, so no thread ever waits on a file nobody is parsing.
+     *
+     * Workers are only started once there's something for them to do,
+     * each with an arena from the compilation to allocate from.
+     */
+    class RequireQueue
+    {
+        public:
+            /**
+             * Parses a required file, on whichever thread claimed it.
+             * Must not throw; whatever goes wrong is kept in the file.
+             */
+            typedef void (*ParseFunction)(RequireQueue& queue, RequiredFile& file);
+
+        private:
+            CompilationContext* context;
+            ParseFunction parse;
+            // The number of worker threads to start.
+            unsigned int workerCount;
+
+            // Every file ever queued. They belong to the queue.
+            std::vector<RequiredFile*> files;
+            // The files that were required once, with the identity of the file each names on disk.
+            std::vector<std::pair<FileIdentity, RequiredFile*> > onceFiles;
+            // Files that no thread has claimed yet, in the order they were queued.
+            std::deque<RequiredFile*> pending;
+            std::vector<std::thread> workers;
+            // The counters gathered by each worker, or empty if the compilation doesn't keep any.
+            std::vector<Statistics*> workerStatistics;
+            bool stopping;
+
+            // Guards everything above, along with the state of each file.
+            std::mutex mutex;
+            // Signalled when a file is queued or finished, or the queue is stopping.
+            std::condition_variable changed;
+
+            // Not copyable.
+            RequireQueue(const RequireQueue&);
+            RequireQueue& operator=(const RequireQueue&);
+
+            void work(Arena* arena, Statistics* statistics);
+
+        public:
+            /**
+             * Creates a queue that parses files for a compilation with the given function,
+             * on up to threadCount threads including the one that waits on it.
+             * With just one, files are only parsed once they're needed.
+             */
+            RequireQueue(CompilationContext& context, ParseFunction parse, unsigned int threadCount);
+
+            /**
+             * Abandons any files that haven't been started, waits for the rest,
+             * and adds the workers' counters to the compilation's statistics.
+             */
+            ~RequireQueue();
+
+            /**
+             * Returns the compilation that the files are parsed for.
+             */
+            CompilationContext& getContext()
+            {
+                return *context;
+            }
+
+            /**
+             * Returns whether files are parsed ahead of when they're needed.
+             */
+            bool isParallel()
+            {
+                return workerCount > 0;
+            }
+
+            /**
+             * Queues a required file to be parsed, and returns it. A file required once
+             * is only queued the first time, and the same file is returned after that.
+             */
+            RequiredFile* add(const std::string& filename, const SourcePosition& includePoint, const std::vector<SourcePosition>& includeStack, bool once);
+
+            /**
+             * Returns once a queued file has been parsed, parsing it on this thread if no other has started.
+             */
+            void finish(RequiredFile& file);
+
+            /**
+             * Returns once every queued file has been parsed, including any queued by those parses,
+             * helping with the ones no other thread has started. The workers are idle after that,
+             * so nothing they allocated is in use by another thread.
+             */
+            void finishAll();
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <exception>
+
+#include "source_position.h"
+#include "file_identity.h"
+#include "parser_context.h"
+
+namespace nel
+{
+    class Statement;
+    template <typename T> class ListNode;
+
+    /**
+     * A file named by a require statement, which is parsed on its own,
+     * possibly on another thread, and then spliced in where it was required.
+     * Each plain require gets a file of its own, even if another names the same file,
+     * since each was required from a different place. Every require once of the same
+     * file shares one, since only one of them is ever spliced in.
+     */
+    class RequiredFile
+    {
+        private:
+            std::string filename;
+            // Where the file was required, just after the require's filename.
+            SourcePosition includePoint;
+            // Where each of the files enclosing that one were required, outermost first.
+            std::vector<SourcePosition> includeStack;
+            // Whether the file was required once.
+            bool once;
+
+            // Whether a thread has started parsing the file, and whether it's done.
+            // Only changed by the RequireQueue, under its lock.
+            bool claimed;
+            bool finished;
+
+            // The file's statements, or 0 if it couldn't be opened or parsed.
+            ListNode<Statement*>* statements;
+            // The errors raised by the parse, to report where the file was required.
+            std::vector<ParserContext::Diagnostic> diagnostics;
+            // Anything else thrown by the parse, to be rethrown there too.
+            std::exception_ptr exception;
+            // Which file was parsed, or one that matches nothing if it couldn't be opened.
+            FileIdentity identity;
+            // The files that it required in turn.
+            std::vector<ParserContext::Inclusion> inclusions;
+
+            friend class RequireQueue;
+
+        public:
+            RequiredFile(const std::string& filename, const SourcePosition& includePoint, const std::vector<SourcePosition>& includeStack, bool once)
+                : filename(filename), includePoint(includePoint), includeStack(includeStack), once(once),
+                claimed(false), finished(false), statements(0)
+            {
+            }
+
+            /**
+             * Returns the name of the file, relative to the directory the compiler was run from.
+             */
+            const std::string& getFilename()
+            {
+                return filename;
+            }
+
+            /**
+             * Returns the position where the file was required.
+             */
+            SourcePosition& getIncludePoint()
+            {
+                return includePoint;
+            }
+
+            /**
+             * Returns the positions where each file enclosing the require was required.
+             */
+            const std::vector<SourcePosition>& getIncludeStack()
+            {
+                return includeStack;
+            }
+
+            /**
+             * Returns whether the file was required once.
+             */
+            bool isOnce()
+            {
+                return once;
+            }
+
+            /**
+             * Returns the file's statements, or 0 if it couldn't be opened or parsed.
+             */
+            ListNode<Statement*>* getStatements()
+            {
+                return statements;
+            }
+
+            /**
+             * Sets the file's statements, once it's been parsed.
+             */
+            void setStatements(ListNode<Statement*>* value)
+            {
+                statements = value;
+            }
+
+            /**
+             * Returns the errors raised while parsing the file.
+             */
+            std::vector<ParserContext::Diagnostic>& getDiagnostics()
+            {
+                return diagnostics;
+            }
+
+            /**
+             * Returns what the parse threw other than a fatal error, if anything.
+             */
+            std::exception_ptr getException()
+            {
+                return exception;
+            }
+
+            /**
+             * Sets what the parse threw other than a fatal error.
+             */
+            void setException(std::exception_ptr value)
+            {
+                exception = value;
+            }
+
+            /**
+             * Returns the identity of the file that was parsed.
+             */
+            const FileIdentity& getIdentity()
+            {
+                return identity;
+            }
+
+            /**
+             * Sets the identity of the file that was parsed.
+             */
+            void setIdentity(const FileIdentity& value)
+            {
+                identity = value;
+            }
+
+            /**
+             * Returns the files that this one required, in the order they appear in it.
+             */
+            std::vector<ParserContext::Inclusion>& getInclusions()
+            {
+                return inclusions;
+            }
+    };
+}
@@ -7,8 +7,8 @@
 
 namespace nel
 {
-    RomBank::RomBank()
-        : originSet(false), position(0), reservedSize(0)
+    RomBank::RomBank(CompilationContext& context)
+        : context(context), originSet(false), position(0), reservedSize(0), bytesWritten(0)
     {
         memset(data, PAD_VALUE, sizeof(data));
     }
@@ -28,7 +28,7 @@ namespace nel
         {
             std::ostringstream os;
             os << "bank's position went outside of addressable memory 0..65535 (attempted to expand to position = " << origin + position + amount << ")";
-            error(os.str(), sourcePosition, true);
+            error(context, os.str(), sourcePosition, true);
             return;
         }
         
@@ -37,13 +37,13 @@ namespace nel
         
         if(!originSet)
         {
-            error("no origin point was set before bank was expanded.", sourcePosition, true);
+            error(context, "no origin point was set before bank was expanded.", sourcePosition, true);
         }
         if(reservedSize > BANK_SIZE)
         {
             std::ostringstream os;
             os << "bank expanded beyond its " << BANK_SIZE << " byte boundary by " << (reservedSize - BANK_SIZE) << " bytes";
-            error(os.str(), sourcePosition, true);
+            error(context, os.str(), sourcePosition, true);
         }
     }
     
@@ -55,7 +55,7 @@ namespace nel
             {
                 std::ostringstream os;
                 os << "attempt to move backwards within the bank. (location " << origin + position << " -> " << pos << ")";
-                error(os.str(), sourcePosition, true);
+                error(context, os.str(), sourcePosition, true);
             }
             else
             {   
@@ -73,7 +73,7 @@ namespace nel
     {
         if(pos > origin + reservedSize)
         {
-            error("attempt to move outside of bank's reserved space.", sourcePosition, true);
+            error(context, "attempt to move outside of bank's reserved space.", sourcePosition, true);
         }
         else
         {        
@@ -87,15 +87,16 @@ namespace nel
     {
         if(position >= reservedSize)
         {
-            error("attempt to write outside of bank's reserved space.", sourcePosition, true);
+            error(context, "attempt to write outside of bank's reserved space.", sourcePosition, true);
         }
         else if(value > 255)
         {
-            error("value is outside of representable 16-bit range 0..255", sourcePosition);
+            error(context, "value is outside of representable 16-bit range 0..255", sourcePosition);
         }
         else
         {
             data[position++] = value & 0xFF;
+            bytesWritten++;
         }
     }
 
@@ -103,17 +104,18 @@ namespace nel
     {
         if(position >= reservedSize)
         {
-            error("attempt to write outside of bank's reserved space.", sourcePosition, true);
+            error(context, "attempt to write outside of bank's reserved space.", sourcePosition, true);
         }
         else if(value > 65535)
         {
-            error("value is outside of representable 16-bit range 0..65536", sourcePosition);
+            error(context, "value is outside of representable 16-bit range 0..65536", sourcePosition);
         }
         else
         {
             // Write word in little-endian order.
             data[position++] = value & 0xFF;
             data[position++] = (value >> 8) & 0xFF;
+            bytesWritten += 2;
         }
     }
     
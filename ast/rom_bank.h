@@ -1,6 +1,7 @@
 #pragma once
 
 #include "source_position.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -19,6 +20,9 @@ namespace nel
             // Value used to pad unused bank space.
             static const unsigned char PAD_VALUE = 0xFF;
             
+            // The compilation this bank belongs to.
+            CompilationContext& context;
+            
             // Until a ROM relocation occurs, this page has no origin.
             bool originSet;
             // Origin point as an absolute memory address where this bank starts.
@@ -29,11 +33,13 @@ namespace nel
             // error-check bank overflows, and to some extent,
             // to prevent discrepencies between predicted size and actual size.
             unsigned int reservedSize;
+            // The number of bytes written into this bank so far.
+            unsigned int bytesWritten;
             // The byte data held by this bank.
             unsigned char data[BANK_SIZE];
             
         public:
-            RomBank();
+            RomBank(CompilationContext& context);
             ~RomBank();
             
             /**
@@ -66,6 +72,14 @@ namespace nel
             {
                 return originSet ? origin + position : 0xDEAAAAAD;
             }
+            
+            /**
+             * Returns the number of bytes written into this bank so far.
+             */
+            unsigned int getBytesWritten()
+            {
+                return bytesWritten;
+            }
         
             /**
              * Reserve program space for data in an early pass.
@@ -6,14 +6,12 @@
 
 namespace nel
 {
-    RomGenerator* romGenerator;
-    
-    RomGenerator::RomGenerator(unsigned int mapper, unsigned int prg, unsigned int chr, bool mirroring, bool battery, bool fourscreen)
-        : mapper(mapper), prg(prg), chr(chr), mirroring(mirroring), battery(battery), fourscreen(fourscreen), bankSet(false), ramCounterSet(false)
+    RomGenerator::RomGenerator(CompilationContext& context, unsigned int mapper, unsigned int prg, unsigned int chr, bool mirroring, bool battery, bool fourscreen)
+        : context(context), mapper(mapper), prg(prg), chr(chr), mirroring(mirroring), battery(battery), fourscreen(fourscreen), bankSet(false), ramCounterSet(false)
     {
         for(unsigned int i = 0; i < prg * 2 + chr; i++)
         {
-            banks.push_back(new RomBank());
+            banks.push_back(new RomBank(context));
         }
     }
 
@@ -40,7 +38,7 @@ namespace nel
         {
             std::ostringstream os;
             os << "Bank index " << bankIndex << " is outside of range 0.." << banks.size() - 1;
-            error(os.str(), sourcePosition, true);
+            error(context, os.str(), sourcePosition, true);
         }
         else
         {
@@ -55,7 +53,7 @@ namespace nel
         {
             std::ostringstream os;
             os << "ram counter goes past addressable memory 0..65536 by " << (ramCounter + size - 65536) << " bytes";
-            error(os.str(), sourcePosition, true);
+            error(context, os.str(), sourcePosition, true);
             return false;
         }
         else
@@ -1,15 +1,18 @@
+#pragma once
+
 #include <vector>
 
 #include "rom_bank.h"
+#include "compilation_context.h"
 
 namespace nel
 {
-    class RomGenerator;
-    extern RomGenerator* romGenerator;
-
     class RomGenerator
     {
         private:
+            // The compilation this ROM belongs to.
+            CompilationContext& context;
+            
             // Mapper number, as designated by the iNES header formate.
             unsigned int mapper;
             // Number of 16K PRG ROM banks.
@@ -36,7 +39,7 @@ namespace nel
             unsigned int ramCounter;
             
         public:
-            RomGenerator(unsigned int mapper, unsigned int prg, unsigned int chr, bool mirroring, bool battery, bool fourscreen);
+            RomGenerator(CompilationContext& context, unsigned int mapper, unsigned int prg, unsigned int chr, bool mirroring, bool battery, bool fourscreen);
             ~RomGenerator();
             
             /**
@@ -59,6 +62,22 @@ namespace nel
                 return bankSet ? banks[activeBankIndex] : 0;
             }
             
+            /**
+             * Returns the number of 8K banks in the ROM.
+             */
+            unsigned int getBankCount()
+            {
+                return banks.size();
+            }
+            
+            /**
+             * Returns the bank at the given index.
+             */
+            RomBank* getBank(unsigned int index)
+            {
+                return banks[index];
+            }
+            
             /**
              * Returns whether or not the ram counter has been initialized.
              */
@@ -0,0 +1,123 @@
+#include <cstdlib>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "source_buffer.h"
+
+namespace nel
+{
+    SourceBuffer::SourceBuffer(char* data, size_t size, size_t mappedSize)
+        : data(data), size(size), mappedSize(mappedSize)
+    {
+        identity.setText(data, size);
+    }
+
+    SourceBuffer* SourceBuffer::read(FILE* file)
+    {
+        size_t capacity = 4096;
+        size_t size = 0;
+        char* data = (char*) malloc(capacity);
+        while(data)
+        {
+            size += fread(data + size, 1, capacity - size - PADDING, file);
+            if(size < capacity - PADDING)
+            {
+                break;
+            }
+
+            capacity *= 2;
+            char* grown = (char*) realloc(data, capacity);
+            if(!grown)
+            {
+                free(data);
+            }
+            data = grown;
+        }
+
+        if(!data || ferror(file))
+        {
+            free(data);
+            return 0;
+        }
+        memset(data + size, 0, PADDING);
+
+        SourceBuffer* buffer = new SourceBuffer(data, size, 0);
+        #if !defined(_WIN32)
+            buffer->identity.setFile(fileno(file));
+        #endif
+        return buffer;
+    }
+
+#if defined(_WIN32)
+    SourceBuffer* SourceBuffer::map(const std::string& filename)
+    {
+        // Not supported here, so files are always read through stdio.
+        return 0;
+    }
+
+    SourceBuffer::~SourceBuffer()
+    {
+        free(data);
+    }
+#else
+    SourceBuffer* SourceBuffer::map(const std::string& filename)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            return 0;
+        }
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0)
+        {
+            close(fd);
+            return 0;
+        }
+
+        size_t size = info.st_size;
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t mappedSize = (size + PADDING + pageSize - 1) / pageSize * pageSize;
+
+        // Reserve zeroed pages for the file and its padding, then map the file over the start of them.
+        // The rest of the file's last page reads as zero, and any page after that is still the zeroed reservation.
+        void* base = mmap(0, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(base == MAP_FAILED)
+        {
+            close(fd);
+            return 0;
+        }
+        if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+        {
+            munmap(base, mappedSize);
+            close(fd);
+            return 0;
+        }
+
+        SourceBuffer* buffer = new SourceBuffer((char*) base, size, mappedSize);
+        buffer->identity.setFile(fd);
+
+        // The mapping stays valid without the descriptor.
+        close(fd);
+        return buffer;
+    }
+
+    SourceBuffer::~SourceBuffer()
+    {
+        if(mappedSize)
+        {
+            munmap(data, mappedSize);
+        }
+        else
+        {
+            free(data);
+        }
+    }
+#endif
+}
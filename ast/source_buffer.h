@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#include "file_identity.h"
+
+namespace nel
+{
+    /**
+     * The text of a source file, held in memory so the lexer can scan it
+     * in place, and so positions can be turned into lines and columns later.
+     *
+     * Regular files are mapped into memory. Anything else, like a pipe,
+     * is read through stdio into a buffer on the heap instead.
+     * A mapping is private and writable, since the lexer writes into the
+     * text as it scans, and the file mustn't be truncated while it's mapped.
+     *
+     * Either way, the text is followed by PADDING zero bytes. flex needs two
+     * of them to mark the end of its buffer, and the hand-written scanner
+     * reads ahead a word at a time.
+     */
+    class SourceBuffer
+    {
+        private:
+            char* data;
+            size_t size;
+            // The size of the mapping, or 0 if the text is on the heap.
+            size_t mappedSize;
+            // Which file the text came from, taken before anything scanned it.
+            FileIdentity identity;
+
+            SourceBuffer(char* data, size_t size, size_t mappedSize);
+
+            // Not copyable.
+            SourceBuffer(const SourceBuffer&);
+            SourceBuffer& operator=(const SourceBuffer&);
+
+        public:
+            enum
+            {
+                // Zero bytes following the text.
+                PADDING = 8
+            };
+
+            /**
+             * Maps a file into memory, or returns 0 if it can't be mapped.
+             * Only non-empty regular files are mapped.
+             */
+            static SourceBuffer* map(const std::string& filename);
+
+            /**
+             * Reads the rest of a stream into memory, or returns 0 if it can't be read.
+             */
+            static SourceBuffer* read(FILE* file);
+
+            ~SourceBuffer();
+
+            /**
+             * Returns the text, followed by the padding.
+             */
+            char* getData()
+            {
+                return data;
+            }
+
+            /**
+             * Returns the size of the text, not counting the padding.
+             */
+            size_t getSize()
+            {
+                return size;
+            }
+
+            /**
+             * Returns the identity of the file that the text came from.
+             */
+            const FileIdentity& getIdentity()
+            {
+                return identity;
+            }
+    };
+}
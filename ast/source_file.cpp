@@ -1,20 +1,42 @@
-#include "source_position.h"
+#include <algorithm>
+
+#include "source_buffer.h"
 #include "source_file.h"
    
 namespace nel
 {
-    SourceFile::SourceFile(std::string filename, SourcePosition* includePoint)
-        : filename(filename), includePoint(includePoint)
+    SourceFile::SourceFile(const std::string& filename, SourceBuffer* buffer, const SourcePosition& includePoint)
+        : filename(filename), includePoint(includePoint), buffer(buffer), indexedLength(0)
     {
+        lineStarts.push_back(0);
     }
-    
-    SourceFile::SourceFile(SourceFile* sourceFile)
-        : filename(sourceFile->filename), includePoint(sourceFile->includePoint)
+
+    void SourceFile::indexTo(unsigned int offset)
     {
+        unsigned int end = buffer ? (unsigned int) std::min<size_t>(offset, buffer->getSize()) : 0;
+        const char* text = buffer ? buffer->getData() : 0;
+        for(; indexedLength < end; indexedLength++)
+        {
+            if(text[indexedLength] == '\n')
+            {
+                lineStarts.push_back(indexedLength + 1);
+            }
+        }
     }
-    
-    SourceFile::~SourceFile()
+
+    void SourceFile::indexLines()
     {
-        delete includePoint;
+        indexTo(buffer ? (unsigned int) buffer->getSize() : 0);
     }
-}
\ No newline at end of file
+
+    void SourceFile::locate(unsigned int offset, unsigned int& line, unsigned int& column)
+    {
+        // Index no further than the offset, since the lexer may still be scanning
+        // the text after it, and flex writes into the text it hasn't finished with.
+        indexTo(offset);
+
+        std::vector<unsigned int>::iterator next = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+        line = next - lineStarts.begin();
+        column = offset - *(next - 1) + 1;
+    }
+}
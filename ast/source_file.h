@@ -1,30 +1,40 @@
 #pragma once
 
 #include <string>
+#include <vector>
+
+#include "source_position.h"
 
 namespace nel
 {
-    class SourcePosition;
-    
+    class SourceBuffer;
+
     /**
      * Information about a file contained in the source.
      * This file was either the argument to the compiler, or an inclusion made within source code.
+     * Each one is an entry in its compilation's file table.
      */
     class SourceFile
     {
         private:
             std::string filename;
-            SourcePosition* includePoint;
+            SourcePosition includePoint;
+            // The text of the file, owned by the compilation.
+            SourceBuffer* buffer;
+            // The offset at which each line starts, indexed only as far as positions have needed.
+            std::vector<unsigned int> lineStarts;
+            unsigned int indexedLength;
+
+            // Indexes the lines that start at or before an offset.
+            void indexTo(unsigned int offset);
             
         public:
-            SourceFile(std::string filename, SourcePosition* includePoint = 0);
-            SourceFile(SourceFile* sourceFile);
-            ~SourceFile();
+            SourceFile(const std::string& filename, SourceBuffer* buffer, const SourcePosition& includePoint = SourcePosition());
             
             /**
              * Returns the filename of this source file.
              */
-            std::string getFilename()
+            const std::string& getFilename()
             {
                 return filename;
             }
@@ -34,7 +44,27 @@ namespace nel
              */
             SourcePosition* getIncludePoint()
             {
-                return includePoint;
+                return includePoint.isKnown() ? &includePoint : 0;
+            }
+
+            /**
+             * Returns the text of this file.
+             */
+            SourceBuffer* getBuffer()
+            {
+                return buffer;
             }
+
+            /**
+             * Finds the line and column of a byte offset into this file, both counting from 1.
+             */
+            void locate(unsigned int offset, unsigned int& line, unsigned int& column);
+
+            /**
+             * Indexes every line of the file now, rather than as positions need them.
+             * Afterwards, locating positions in this file only reads from it, so it can be
+             * done from other threads while the file is still being scanned.
+             */
+            void indexLines();
     };
-}
\ No newline at end of file
+}
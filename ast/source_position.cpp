@@ -1,33 +1,28 @@
 #include "source_file.h"
 #include "source_position.h"
+#include "compilation_context.h"
 
 namespace nel
 {
-    SourcePosition::SourcePosition(SourceFile* sourceFile)
-        : sourceFile(sourceFile), line(1), column(1)
+    void SourcePosition::print(CompilationContext& context, std::ostream& output, bool verbose)
     {
-    }
-    
-    SourcePosition::SourcePosition(SourcePosition* position)
-        : sourceFile(new SourceFile(position->sourceFile)), line(position->line), column(position->column)
-    {
-    }
-    
-    SourcePosition::~SourcePosition()
-    {
-        delete sourceFile;
-    }
+        SourceFile* sourceFile = context.getSourceFile(file);
+        if(!sourceFile)
+        {
+            output << "???";
+            return;
+        }
 
-    void SourcePosition::print(std::ostream& output, bool verbose)
-    {
         output << sourceFile->getFilename();
         if(verbose && sourceFile->getIncludePoint())
         {
             output << "(included by ";
             // Print the included file without any further verbosity.
-            sourceFile->getIncludePoint()->print(output, false);
+            sourceFile->getIncludePoint()->print(context, output, false);
             output << ")";
         }
+        unsigned int line, column;
+        sourceFile->locate(offset, line, column);
         output << ":" << line << "[" << column << "]";
     }
-}
\ No newline at end of file
+}
@@ -2,67 +2,80 @@
 
 #include <iostream>
 
-#include "source_file.h"
-
 namespace nel
 {
+    class CompilationContext;
+
     /**
      * The source position, used to give locational information to
      * abstract syntax nodes, like statements and expressions.
      * This is in turn useful for error reporting behaviour.
+     *
+     * Positions are small values, copied into every node that needs one.
+     * The file is kept as an index into the compilation's file table,
+     * which holds its name, its text and the point it was included from.
+     * Only the byte offset into the file is tracked; the line and column
+     * are worked out from the file's text when the position is printed.
      */
     class SourcePosition
     {
         private:
-            SourceFile* sourceFile;
-            unsigned int line;
-            unsigned int column;            
+            // The file's index in the compilation's file table, or 0 if the position is unknown.
+            unsigned int file;
+            unsigned int offset;
+
         public:
-            SourcePosition(SourceFile* sourceFile);
-            SourcePosition(SourcePosition* position);
-            ~SourcePosition();
-        
             /**
-             * Gets the source file that this position has.
+             * Creates an unknown position.
              */
-            SourceFile* getSourceFile()
+            SourcePosition()
+                : file(0), offset(0)
             {
-                return sourceFile;
             }
 
             /**
-             * Gets the line in the source file.
+             * Creates a position at the start of a file in the file table.
              */
-            unsigned int getLine()
+            SourcePosition(unsigned int file)
+                : file(file), offset(0)
             {
-                return line;
             }
 
             /**
-             * Increments the column position on the line.
+             * Returns whether this position refers to somewhere in a file.
              */
-            void incrementLine(unsigned int amount = 1)
+            bool isKnown()
             {
-                column = 1;
-                line += amount;
+                return file != 0;
             }
-            
+
             /**
-             * Gets the column in the line of the source.
+             * Gets the index of the source file in the compilation's file table.
              */
-            unsigned int getColumn()
+            unsigned int getFile()
             {
-                return column;
+                return file;
             }
-            
+
             /**
-             * Increments the column position on the line.
+             * Gets the byte offset into the source file.
              */
-            void incrementColumn(unsigned int amount = 1)
+            unsigned int getOffset()
             {
-                column += amount;
+                return offset;
+            }
+
+            /**
+             * Sets the byte offset into the source file.
+             */
+            void setOffset(unsigned int value)
+            {
+                offset = value;
             }
             
-            void print(std::ostream& output, bool verbose = false);
+            /**
+             * Prints the position, looking up its file in the given compilation.
+             */
+            void print(CompilationContext& context, std::ostream& output, bool verbose = false);
     };
 }
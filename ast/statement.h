@@ -1,6 +1,7 @@
 #pragma once
 
 #include "node.h"
+#include "compilation_context.h"
 
 namespace nel
 {
@@ -54,16 +55,29 @@ namespace nel
             /**
              * Gathers general program information and declarations.
              */
-            virtual void aggregate() = 0;
+            virtual void aggregate(CompilationContext& context) = 0;
+            
+            /**
+             * Binds the names used by the statement to the scope they appear in,
+             * once every declaration has been gathered.
+             */
+            virtual void resolve(CompilationContext& context) = 0;
             
             /**
              * Basic validation of statements and calculating operation sizes and label positions.
+             * Blocks and command statements do nothing here, since the first pass lowers them
+             * into a LoweredProgram, which sizes their commands itself.
              */
-            virtual void validate() = 0;
+            virtual void validate(CompilationContext& context)
+            {
+            }
             
             /**
-             * Final validation and code output.
+             * Final validation and code output. Likewise, blocks and command statements
+             * are written by the LoweredProgram, not here.
              */
-            virtual void generate() = 0;
+            virtual void generate(CompilationContext& context)
+            {
+            }
     };
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <chrono>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "json.h"
+#include "statistics.h"
+
+namespace nel
+{
+    thread_local Statistics* Statistics::current = 0;
+
+    static const char* const PHASE_NAMES[Statistics::PHASE_COUNT] = {
+        "parse",
+        "aggregate",
+        "resolve",
+        "validate",
+        "generate",
+        "output",
+    };
+
+    static const char* const COUNTER_NAMES[Statistics::COUNTER_COUNT] = {
+        "tokens_lexed",
+        "nodes_allocated",
+        "symbol_lookups",
+        "scope_hops",
+        "folds",
+        "fold_cache_hits",
+        "arena_bytes",
+        "requires_skipped",
+    };
+
+    static double getWallTime()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // CPU time of the calling thread, so that jobs running side by side don't count each other.
+    static double getCpuTime()
+    {
+        #ifdef _WIN32
+            FILETIME creation, exit, kernel, user;
+            GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+            unsigned long long ticks = ((unsigned long long) kernel.dwHighDateTime << 32 | kernel.dwLowDateTime)
+                + ((unsigned long long) user.dwHighDateTime << 32 | user.dwLowDateTime);
+            return ticks * 1e-7;
+        #else
+            timespec ts;
+            clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            return ts.tv_sec + ts.tv_nsec * 1e-9;
+        #endif
+    }
+
+    Statistics::PhaseTimer::PhaseTimer(Statistics* statistics, Phase phase)
+        : statistics(statistics), phase(phase), wallStart(0), cpuStart(0)
+    {
+        if(statistics)
+        {
+            wallStart = getWallTime();
+            cpuStart = getCpuTime();
+        }
+    }
+
+    Statistics::PhaseTimer::~PhaseTimer()
+    {
+        if(statistics)
+        {
+            statistics->addPhaseTime(phase, getWallTime() - wallStart, getCpuTime() - cpuStart);
+        }
+    }
+
+    Statistics::Statistics(const std::string& filename)
+        : filename(filename)
+    {
+        for(unsigned int i = 0; i < PHASE_COUNT; i++)
+        {
+            wallTime[i] = 0;
+            cpuTime[i] = 0;
+            phaseRun[i] = false;
+        }
+        for(unsigned int i = 0; i < COUNTER_COUNT; i++)
+        {
+            counters[i] = 0;
+        }
+    }
+
+    void Statistics::addCounters(const Statistics& other)
+    {
+        for(unsigned int i = 0; i < COUNTER_COUNT; i++)
+        {
+            counters[i] += other.counters[i];
+        }
+    }
+
+    void Statistics::addPhaseTime(Phase phase, double wall, double cpu)
+    {
+        wallTime[phase] += wall;
+        cpuTime[phase] += cpu;
+        phaseRun[phase] = true;
+    }
+
+    void Statistics::printText(std::ostream& os)
+    {
+        double totalWall = 0;
+        double totalCpu = 0;
+
+        os << "* time report for '" << filename << "'" << std::endl;
+        os << "  " << std::left << std::setw(20) << "phase" << std::right
+            << std::setw(12) << "wall (ms)" << std::setw(12) << "cpu (ms)" << std::endl;
+        os << std::fixed << std::setprecision(3);
+        for(unsigned int i = 0; i < PHASE_COUNT; i++)
+        {
+            if(phaseRun[i])
+            {
+                os << "  " << std::left << std::setw(20) << PHASE_NAMES[i] << std::right
+                    << std::setw(12) << wallTime[i] * 1000 << std::setw(12) << cpuTime[i] * 1000 << std::endl;
+                totalWall += wallTime[i];
+                totalCpu += cpuTime[i];
+            }
+        }
+        os << "  " << std::left << std::setw(20) << "total" << std::right
+            << std::setw(12) << totalWall * 1000 << std::setw(12) << totalCpu * 1000 << std::endl;
+        os.unsetf(std::ios::floatfield);
+
+        os << "  counters:" << std::endl;
+        for(unsigned int i = 0; i < COUNTER_COUNT; i++)
+        {
+            os << "  " << std::left << std::setw(20) << COUNTER_NAMES[i] << std::right
+                << std::setw(12) << counters[i] << std::endl;
+        }
+
+        if(!bankBytes.empty())
+        {
+            os << "  bytes written per bank:" << std::endl;
+            for(size_t i = 0; i < bankBytes.size(); i++)
+            {
+                os << "  " << std::left << std::setw(20) << i << std::right
+                    << std::setw(12) << bankBytes[i] << std::endl;
+            }
+        }
+    }
+
+    void Statistics::printJson(std::ostream& os)
+    {
+        os << "{\"file\":";
+        writeJsonString(os, filename);
+
+        os << ",\"phases\":{";
+        bool first = true;
+        for(unsigned int i = 0; i < PHASE_COUNT; i++)
+        {
+            if(phaseRun[i])
+            {
+                os << (first ? "" : ",") << "\"" << PHASE_NAMES[i] << "\":{\"wall_ms\":"
+                    << wallTime[i] * 1000 << ",\"cpu_ms\":" << cpuTime[i] * 1000 << "}";
+                first = false;
+            }
+        }
+
+        os << "},\"counters\":{";
+        for(unsigned int i = 0; i < COUNTER_COUNT; i++)
+        {
+            os << (i ? "," : "") << "\"" << COUNTER_NAMES[i] << "\":" << counters[i];
+        }
+
+        os << "},\"bank_bytes\":[";
+        for(size_t i = 0; i < bankBytes.size(); i++)
+        {
+            os << (i ? "," : "") << bankBytes[i];
+        }
+        os << "]}" << std::endl;
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace nel
+{
+    /**
+     * Timings and counters gathered over a single compilation,
+     * reported by --time-passes.
+     *
+     * Code deep inside the compiler counts events through count(),
+     * which goes to the statistics that the current thread is compiling for.
+     * When no statistics are being gathered, counting costs a single test.
+     */
+    class Statistics
+    {
+        public:
+            enum Phase
+            {
+                PARSE,
+                AGGREGATE,
+                RESOLVE,
+                VALIDATE,
+                GENERATE,
+                OUTPUT,
+                PHASE_COUNT
+            };
+
+            enum Counter
+            {
+                TOKENS_LEXED,
+                NODES_ALLOCATED,
+                SYMBOL_LOOKUPS,
+                SCOPE_HOPS,
+                FOLDS,
+                FOLD_CACHE_HITS,
+                ARENA_BYTES,
+                REQUIRES_SKIPPED,
+                COUNTER_COUNT
+            };
+
+            /**
+             * Measures the wall and CPU time of a phase, from construction until destruction.
+             * Does nothing when given no statistics.
+             */
+            class PhaseTimer
+            {
+                private:
+                    Statistics* statistics;
+                    Phase phase;
+                    double wallStart;
+                    double cpuStart;
+
+                public:
+                    PhaseTimer(Statistics* statistics, Phase phase);
+                    ~PhaseTimer();
+            };
+
+        private:
+            // The statistics gathered by the calling thread, or 0 if none are.
+            static thread_local Statistics* current;
+
+            // The name of the file this compilation started from.
+            std::string filename;
+            // Seconds spent in each phase, by the clock and by this thread's CPU time.
+            double wallTime[PHASE_COUNT];
+            double cpuTime[PHASE_COUNT];
+            // Whether each phase was reached at all.
+            bool phaseRun[PHASE_COUNT];
+            unsigned long counters[COUNTER_COUNT];
+            // Bytes written to each ROM bank, in bank order.
+            std::vector<unsigned int> bankBytes;
+
+        public:
+            Statistics(const std::string& filename);
+
+            /**
+             * Returns the statistics that the calling thread is gathering, or 0 if none.
+             */
+            static Statistics* getCurrent()
+            {
+                return current;
+            }
+
+            /**
+             * Sets the statistics that the calling thread gathers counts into.
+             */
+            static void setCurrent(Statistics* statistics)
+            {
+                current = statistics;
+            }
+
+            /**
+             * Counts an event towards the calling thread's statistics, if any.
+             */
+            static void count(Counter counter, unsigned long amount = 1)
+            {
+                if(current)
+                {
+                    current->counters[counter] += amount;
+                }
+            }
+
+            /**
+             * Returns the current value of a counter.
+             */
+            unsigned long getCounter(Counter counter)
+            {
+                return counters[counter];
+            }
+
+            /**
+             * Adds the counters gathered by other statistics, such as those of a thread helping with this compilation.
+             */
+            void addCounters(const Statistics& other);
+
+            /**
+             * Adds time spent on a phase.
+             */
+            void addPhaseTime(Phase phase, double wall, double cpu);
+
+            /**
+             * Records the number of bytes written to each bank of the ROM.
+             */
+            void setBankBytes(const std::vector<unsigned int>& value)
+            {
+                bankBytes = value;
+            }
+
+            /**
+             * Prints a human-readable report.
+             */
+            void printText(std::ostream& os);
+
+            /**
+             * Prints the report as a single-line JSON object.
+             */
+            void printJson(std::ostream& os);
+    };
+}
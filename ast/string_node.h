@@ -1,29 +1,54 @@
 #pragma once
 
 #include "node.h"
+#include "symbol_pool.h"
 
 namespace nel
 {
     /**
      * A node representing a string token of some kind, such as an identifier or string literal.
+     * Identifiers are interned, and keep only their SymbolId.
      */
     class StringNode : public Node
     {
         private:
+            // The text of a string literal. Unused by identifiers.
             std::string value;
+            // Whether symbol holds an interned id yet.
+            bool interned;
+            SymbolId symbol;
             
         public:
             StringNode(std::string value, SourcePosition* sourcePosition)
-                : Node(sourcePosition), value(value)
+                : Node(sourcePosition), value(value), interned(false), symbol(0)
+            {
+            }
+            
+            StringNode(SymbolId symbol, SourcePosition* sourcePosition)
+                : Node(sourcePosition), interned(true), symbol(symbol)
             {
             }
             
             /**
              * Returns the string value of this node.
              */
-            std::string getValue()
+            const std::string& getValue()
+            {
+                return interned ? SymbolPool::getName(symbol) : value;
+            }
+            
+            /**
+             * Returns the interned id of this node's value, interning it on first use.
+             */
+            SymbolId getSymbol()
             {
-                return value;
+                if(!interned)
+                {
+                    symbol = SymbolPool::intern(value);
+                    interned = true;
+                    value.clear();
+                }
+                return symbol;
             }
     };
-}
\ No newline at end of file
+}
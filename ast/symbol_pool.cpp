@@ -0,0 +1,50 @@
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "symbol_pool.h"
+
+namespace nel
+{
+    namespace
+    {
+        struct Pool
+        {
+            std::mutex mutex;
+            // Lookup from identifier to id.
+            std::unordered_map<std::string, SymbolId> ids;
+            // Identifiers indexed by id. A deque never moves its elements, so names can be handed out by reference.
+            std::deque<std::string> names;
+        };
+
+        Pool& getPool()
+        {
+            static Pool pool;
+            return pool;
+        }
+    }
+
+    SymbolId SymbolPool::intern(const std::string& name)
+    {
+        Pool& pool = getPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+
+        std::unordered_map<std::string, SymbolId>::iterator it = pool.ids.find(name);
+        if(it != pool.ids.end())
+        {
+            return it->second;
+        }
+
+        SymbolId symbol = pool.names.size();
+        pool.names.push_back(name);
+        pool.ids[name] = symbol;
+        return symbol;
+    }
+
+    const std::string& SymbolPool::getName(SymbolId symbol)
+    {
+        Pool& pool = getPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        return pool.names[symbol];
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+namespace nel
+{
+    /**
+     * A small integer standing in for an interned identifier.
+     * Two identifiers are equal exactly when their ids are.
+     */
+    typedef unsigned int SymbolId;
+
+    /**
+     * The pool of every identifier seen by the compiler, shared by all compilations.
+     * Each distinct identifier is stored once, and identified from then on by its SymbolId,
+     * so symbol tables can compare and hash integers instead of strings.
+     */
+    class SymbolPool
+    {
+        public:
+            /**
+             * Returns the id of the given identifier, adding it to the pool if it's new.
+             */
+            static SymbolId intern(const std::string& name);
+
+            /**
+             * Returns the identifier that an id was interned from.
+             * The reference stays valid for the life of the program.
+             */
+            static const std::string& getName(SymbolId symbol);
+    };
+}
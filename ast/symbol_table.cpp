@@ -1,60 +1,28 @@
 #include <sstream>
 
 #include "error.h"
+#include "statistics.h"
 #include "symbol_table.h"
 
 namespace nel
 {
-    SymbolTable* SymbolTable::activeScope = 0;
-    std::vector<SymbolTable*> SymbolTable::scopeStack;
-    SymbolTable* SymbolTable::builtins = 0;
-    
-    SymbolTable* SymbolTable::getBuiltins()
+    SymbolTable* SymbolTable::createBuiltins()
     {
-        // First time? init the builtins table.
-        if(!builtins)
-        {
-            builtins = new SymbolTable();
-            builtins->dict["a"] = new Definition(Definition::A, "a");
-            builtins->dict["x"] = new Definition(Definition::X, "x");
-            builtins->dict["y"] = new Definition(Definition::Y, "y");
-            builtins->dict["s"] = new Definition(Definition::S, "s");
-            builtins->dict["p"] = new Definition(Definition::P, "p");
-            builtins->dict["carry"] = new Definition(Definition::CARRY, "carry");
-            builtins->dict["interrupt"] = new Definition(Definition::INTERRUPT, "interrupt");
-            builtins->dict["decimal"] = new Definition(Definition::DECIMAL, "decimal");
-            builtins->dict["overflow"] = new Definition(Definition::OVERFLOW, "overflow");
-            builtins->dict["zero"] = new Definition(Definition::ZERO, "zero");
-            builtins->dict["negative"] = new Definition(Definition::NEGATIVE, "negative");
-        }
+        SymbolTable* builtins = new SymbolTable();
+        builtins->dict[SymbolPool::intern("a")] = new Definition(Definition::A, "a");
+        builtins->dict[SymbolPool::intern("x")] = new Definition(Definition::X, "x");
+        builtins->dict[SymbolPool::intern("y")] = new Definition(Definition::Y, "y");
+        builtins->dict[SymbolPool::intern("s")] = new Definition(Definition::S, "s");
+        builtins->dict[SymbolPool::intern("p")] = new Definition(Definition::P, "p");
+        builtins->dict[SymbolPool::intern("carry")] = new Definition(Definition::CARRY, "carry");
+        builtins->dict[SymbolPool::intern("interrupt")] = new Definition(Definition::INTERRUPT, "interrupt");
+        builtins->dict[SymbolPool::intern("decimal")] = new Definition(Definition::DECIMAL, "decimal");
+        builtins->dict[SymbolPool::intern("overflow")] = new Definition(Definition::OVERFLOW, "overflow");
+        builtins->dict[SymbolPool::intern("zero")] = new Definition(Definition::ZERO, "zero");
+        builtins->dict[SymbolPool::intern("negative")] = new Definition(Definition::NEGATIVE, "negative");
         return builtins;
     }
     
-    SymbolTable* SymbolTable::getActiveScope()
-    {
-        return activeScope;
-    }
-    
-    void SymbolTable::enterScope(SymbolTable* symbolTable)
-    {
-        scopeStack.push_back(symbolTable);
-        activeScope = symbolTable;
-    }
-    
-    void SymbolTable::exitScope()
-    {
-        scopeStack.pop_back();
-
-        if(scopeStack.size() > 0)
-        {
-            activeScope = scopeStack[scopeStack.size() - 1];
-        }
-        else
-        {
-            activeScope = 0;
-        }
-    }
-    
     SymbolTable::SymbolTable(SymbolTable* parent)
         : parent(parent)
     {
@@ -72,20 +40,15 @@ namespace nel
     
     SymbolTable::~SymbolTable()
     {
-        DictIterator it;
-        for(it = dict.begin(); it != dict.end(); ++it)
-        {
-            delete it->second;
-        }
-        dict.clear();
+        // The definitions belong to the compilation's arena.
     }
     
-    void SymbolTable::put(Definition* def, SourcePosition* sourcePosition)
+    void SymbolTable::put(CompilationContext& context, Definition* def, SourcePosition* sourcePosition)
     {
         // Perform search without inheritance to only whine if the symbol was already declared in this scope.
         // This way functions can have locals that use the same name as somewhere in the parent, without problems.
         // (get always looks at current scope and works up, there is no ambiguity)
-        Definition* match = tryGet(def->getName(), false);
+        Definition* match = tryGet(def->getSymbol(), false);
         
         if(match)
         {
@@ -95,46 +58,52 @@ namespace nel
             message << "redefinition of symbol `" << def->getName() << "`, previously defined at ";
             if(previousDecl)
             {
-                previousDecl->print(message);
+                previousDecl->print(context, message);
             }
             else
             {
                 message << "???";
             }
-            error(message.str(), sourcePosition);
+            error(context, message.str(), sourcePosition);
         }
         
-        def->setDeclarationPoint(new SourcePosition(sourcePosition));
-        dict[def->getName()] = def;
+        def->setDeclarationPoint(sourcePosition);
+        dict[def->getSymbol()] = def;
     }
     
-    Definition* SymbolTable::get(std::string name, SourcePosition* sourcePosition)
+    Definition* SymbolTable::get(CompilationContext& context, SymbolId symbol, SourcePosition* sourcePosition)
     {
-        Definition* def = tryGet(name, true);
+        Definition* def = tryGet(symbol, true);
         
         if(!def)
         {
             std::ostringstream message;
-            message << "reference to undefined symbol `" << name << "`";
-            error(message.str(), sourcePosition);
+            message << "reference to undefined symbol `" << SymbolPool::getName(symbol) << "`";
+            error(context, message.str(), sourcePosition);
             return 0;
         }
         return def;
     }
     
-    Definition* SymbolTable::tryGet(std::string name, bool useInheritance)
+    Definition* SymbolTable::tryGet(SymbolId symbol, bool useInheritance)
     {
-        DictIterator it = dict.find(name);
-        
-        if(it == dict.end())
+        Statistics::count(Statistics::SYMBOL_LOOKUPS);
+        SymbolTable* scope = this;
+        while(true)
         {
-            if(useInheritance && parent)
+            DictIterator it = scope->dict.find(symbol);
+            if(it != scope->dict.end())
             {
-                return parent->tryGet(name, useInheritance);
+                return it->second;
             }
-            return 0;
+            
+            if(!useInheritance || !scope->parent)
+            {
+                return 0;
+            }
+            Statistics::count(Statistics::SCOPE_HOPS);
+            scope = scope->parent;
         }
-        return it->second;
     }
 
     void SymbolTable::printFullyQualifiedName(std::ostream& stream)
@@ -1,7 +1,11 @@
+#pragma once
+
 #include <vector>
 
-#include "map.h"
+#include "flat_map.h"
+#include "compilation_context.h"
 #include "definition.h"
+#include "symbol_pool.h"
 #include "package_definition.h"
 
 namespace nel
@@ -13,39 +17,14 @@ namespace nel
 	class SymbolTable
 	{
         private:
-            typedef Map<std::string, Definition*>::Type Dictionary;
+            typedef LookupMap<SymbolId, Definition*>::Type Dictionary;
 			typedef Dictionary::iterator DictIterator;
-        
-            // Scope used for constants, variables and label declarations.
-            // The current top of the scopeStack.
-            static SymbolTable* activeScope;
-            // A stack of all depths of active scopes.
-            // Necessary for checking when a label is declared outside of the current scope
-            // (but contained by an outer scope the inner scope can reference).
-            static std::vector<SymbolTable*> scopeStack;
-            // Contains the builtins.
-            static SymbolTable* builtins;
             
 		public:
             /**
-             * Get the symbol table containing the built-in definitions.
-             */
-            static SymbolTable* getBuiltins();
-            
-            /**
-             * Get the active scope containing user-supplied definitions.
-             */
-            static SymbolTable* getActiveScope();
-            
-            /**
-             * Enters a new scope level, pushing it onto the scope stack.
-             */
-            static void enterScope(SymbolTable* symbolTable);
-            
-            /**
-             * Exits the current scope level, returning to its parent scope.
+             * Creates a new symbol table containing the built-in definitions.
              */
-            static void exitScope();
+            static SymbolTable* createBuiltins();
         
         private:
 			// The outer scope containing this, or 0 if it does not apply.
@@ -81,19 +60,19 @@ namespace nel
 			/**
              * Insert symbol into the local scope.
              */
-			void put(Definition* value, SourcePosition* sourcePosition);
+			void put(CompilationContext& context, Definition* value, SourcePosition* sourcePosition);
             
 			/**
              * Perform search with inheritance setting to see if this
              * binding exists at this or an earlier scope.
              */
-			Definition* get(std::string name, SourcePosition* sourcePosition);
+			Definition* get(CompilationContext& context, SymbolId symbol, SourcePosition* sourcePosition);
             
 			/**
              * Attempts to get a symbol (using inheritance setting provided).
              * Returns the symbol if found, and 0 otherwise.
              */
-            Definition* tryGet(std::string key, bool useInheritance = true);
+            Definition* tryGet(SymbolId symbol, bool useInheritance = true);
 
             /**
              * Outputs the fully qualified name of this package.
@@ -0,0 +1,109 @@
+#include <chrono>
+#include <sstream>
+
+#include "json.h"
+#include "trace_recorder.h"
+
+namespace nel
+{
+    static long long getTimestamp()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    TraceRecorder::Span::Span(TraceRecorder* recorder, const char* category, const char* name)
+        : recorder(recorder)
+    {
+        if(recorder)
+        {
+            recorder->begin(category, name);
+        }
+    }
+
+    TraceRecorder::Span::~Span()
+    {
+        if(recorder)
+        {
+            recorder->end(args);
+        }
+    }
+
+    void TraceRecorder::Span::addArgument(const char* key, const std::string& value)
+    {
+        if(recorder)
+        {
+            std::ostringstream os;
+            os << (args.empty() ? "" : ",");
+            writeJsonString(os, key);
+            os << ":";
+            writeJsonString(os, value);
+            args += os.str();
+        }
+    }
+
+    TraceRecorder::TraceRecorder(unsigned int threadId, const std::string& threadName)
+        : threadId(threadId), threadName(threadName), openSpans(0)
+    {
+    }
+
+    void TraceRecorder::begin(const char* category, const std::string& name)
+    {
+        Event event;
+        event.phase = 'B';
+        event.category = category;
+        event.name = name;
+        event.timestamp = getTimestamp();
+        events.push_back(event);
+        openSpans++;
+    }
+
+    void TraceRecorder::end(const std::string& args)
+    {
+        if(!openSpans)
+        {
+            return;
+        }
+
+        Event event;
+        event.phase = 'E';
+        event.category = "";
+        event.args = args;
+        event.timestamp = getTimestamp();
+        events.push_back(event);
+        openSpans--;
+    }
+
+    void TraceRecorder::endAll()
+    {
+        while(openSpans)
+        {
+            end();
+        }
+    }
+
+    void TraceRecorder::writeEvents(std::ostream& os, bool& first)
+    {
+        os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":";
+        writeJsonString(os, threadName);
+        os << "}}";
+        first = false;
+
+        for(size_t i = 0; i < events.size(); i++)
+        {
+            Event& event = events[i];
+            os << ",\n{\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << threadId << ",\"ts\":" << event.timestamp;
+            if(event.phase == 'B')
+            {
+                os << ",\"cat\":";
+                writeJsonString(os, event.category);
+                os << ",\"name\":";
+                writeJsonString(os, event.name);
+            }
+            if(!event.args.empty())
+            {
+                os << ",\"args\":{" << event.args << "}";
+            }
+            os << "}";
+        }
+    }
+}
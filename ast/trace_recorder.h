@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace nel
+{
+    /**
+     * Records spans of time spent on a compilation, written out by --trace
+     * in the Chrome trace-event format.
+     *
+     * A compilation that isn't being traced has no recorder, and every
+     * span taken against a null recorder does nothing, so spans can stay
+     * in place without costing anything beyond a test.
+     */
+    class TraceRecorder
+    {
+        public:
+            /**
+             * A span that begins on construction and ends on destruction,
+             * including when a fatal error unwinds past it.
+             */
+            class Span
+            {
+                private:
+                    TraceRecorder* recorder;
+                    // Arguments attached to the span, as the inside of a JSON object.
+                    std::string args;
+
+                public:
+                    Span(TraceRecorder* recorder, const char* category, const char* name);
+                    ~Span();
+
+                    /**
+                     * Returns whether this span is being recorded, so callers can skip
+                     * describing it otherwise.
+                     */
+                    bool isEnabled()
+                    {
+                        return recorder != 0;
+                    }
+
+                    /**
+                     * Attaches an argument to this span.
+                     */
+                    void addArgument(const char* key, const std::string& value);
+            };
+
+        private:
+            struct Event
+            {
+                // 'B' to begin a span or 'E' to end one.
+                char phase;
+                const char* category;
+                std::string name;
+                std::string args;
+                // Microseconds on a clock shared by every recorder.
+                long long timestamp;
+            };
+
+            // Which row of the trace these events belong on.
+            unsigned int threadId;
+            // The name given to that row.
+            std::string threadName;
+            std::vector<Event> events;
+            // Spans begun but not yet ended.
+            unsigned int openSpans;
+
+        public:
+            TraceRecorder(unsigned int threadId, const std::string& threadName);
+
+            /**
+             * Begins a span. Spans must end in the reverse order they began.
+             */
+            void begin(const char* category, const std::string& name);
+
+            /**
+             * Ends the most recently begun span, attaching the given arguments to it,
+             * written as the inside of a JSON object.
+             */
+            void end(const std::string& args = "");
+
+            /**
+             * Ends any spans left open, such as those abandoned by a fatal error.
+             */
+            void endAll();
+
+            /**
+             * Writes the recorded events as comma-separated JSON objects, for inclusion
+             * in the traceEvents array of a trace file. first says whether these
+             * are the first events in the array, and is cleared once anything is written.
+             */
+            void writeEvents(std::ostream& os, bool& first);
+    };
+}
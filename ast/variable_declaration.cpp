@@ -16,28 +16,22 @@ namespace nel
     {
     }
 
-    VariableDeclaration::~VariableDeclaration()
-    {
-        delete names;
-        delete arraySizeExpression;
-    }
-
-    void VariableDeclaration::aggregate()
+    void VariableDeclaration::aggregate(CompilationContext& context)
     {
         unsigned int size = variableType == WORD ? 2 : 1;
         
         if(arraySizeExpression)
         {
-            if(!arraySizeExpression->fold(true, false))
+            if(!arraySizeExpression->fold(context, true, false))
             {
-                error("could not resolve the array size provided to this variable declaration", getSourcePosition());
+                error(context, "could not resolve the array size provided to this variable declaration", getSourcePosition());
                 return;
             }
             else
             {
                 if(arraySizeExpression->getFoldedValue() == 0)
                 {
-                    error(
+                    error(context, 
                         "an array size of 0 is invalid. why ask for a variable that can hold nothing?",
                         getSourcePosition()
                     );
@@ -54,32 +48,40 @@ namespace nel
         
         ListNode<StringNode*>::ListType& list = names->getList();
         
-        if(!romGenerator->isRamCounterSet())
+        if(!context.getRomGenerator()->isRamCounterSet())
         {
-            error("variable declaration was found before the ram location was set.", getSourcePosition(), true);
+            error(context, "variable declaration was found before the ram location was set.", getSourcePosition(), true);
         }
         
         for(size_t i = 0; i < list.size(); i++)
         {
             StringNode* name = list[i];
             // Insert symbol, using current RAM counter value as var offset.
-            SymbolTable::getActiveScope()->put(new VariableDefinition(
+            context.getActiveScope()->put(context, new VariableDefinition(
                     name->getValue(),
                     this,
-                    romGenerator->getRamCounter()
+                    context.getRomGenerator()->getRamCounter()
                 ), name->getSourcePosition()
             );
             
             // Reserve size bytes in RAM counter to advance it forward.
-            romGenerator->expandRam(size, getSourcePosition());
+            context.getRomGenerator()->expandRam(size, getSourcePosition());
+        }
+    }
+
+    void VariableDeclaration::resolve(CompilationContext& context)
+    {
+        if(arraySizeExpression)
+        {
+            arraySizeExpression->resolve(context);
         }
     }
 
-    void VariableDeclaration::validate()
+    void VariableDeclaration::validate(CompilationContext& context)
     {
     }
     
-    void VariableDeclaration::generate()
+    void VariableDeclaration::generate(CompilationContext& context)
     {
     }
 }
\ No newline at end of file
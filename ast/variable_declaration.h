@@ -31,7 +31,6 @@ namespace nel
         public:    
             VariableDeclaration(VariableType variableType, ListNode<StringNode*>* names, SourcePosition* sourcePosition);
             VariableDeclaration(VariableType variableType, ListNode<StringNode*>* names, Expression* arraySizeExpression, SourcePosition* sourcePosition);
-            ~VariableDeclaration();
             
             /**
              * Gets the base type of the variable being declared.
@@ -58,8 +57,9 @@ namespace nel
                 return arraySizeExpression;
             }
 
-            void aggregate();
-            void validate();
-            void generate();
+            void aggregate(CompilationContext& context);
+            void resolve(CompilationContext& context);
+            void validate(CompilationContext& context);
+            void generate(CompilationContext& context);
     };
 }
\ No newline at end of file
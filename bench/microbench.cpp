@@ -0,0 +1,503 @@
+// Microbenchmarks for the compiler's hot functions.
+// Each one reports the time and heap allocations per operation,
+// so a change to one of these functions can be measured on its own.
+//
+// Built by `make microbench`, with the parser compiled without its main().
+// Takes the minimum time to measure each benchmark for, and optionally
+// some text that the names of the benchmarks to run must contain.
+// `make scanner-bench` compares the two scanners this way.
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <map>
+#include <unordered_map>
+
+#include "common.h"
+#include "y.tab.hpp"
+
+#include "../ast/flat_map.h"
+#include "../ast/symbol_table.h"
+#include "../ast/constant_definition.h"
+#include "../ast/package_definition.h"
+#include "../ast/operation.h"
+
+// Every heap allocation in the process goes through here, so they can be counted.
+static unsigned long allocationCount = 0;
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    if(void* p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+/**
+ * Measures the region between start() and stop(), which a benchmark body
+ * may enter several times, leaving out any setup that shouldn't count.
+ */
+class Stopwatch
+{
+    private:
+        std::chrono::steady_clock::time_point startTime;
+        unsigned long startAllocations;
+
+    public:
+        double seconds;
+        unsigned long allocations;
+
+        Stopwatch()
+            : startAllocations(0), seconds(0), allocations(0)
+        {
+        }
+
+        void start()
+        {
+            startAllocations = allocationCount;
+            startTime = std::chrono::steady_clock::now();
+        }
+
+        void stop()
+        {
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            allocations += allocationCount - startAllocations;
+        }
+};
+
+// Minimum time to measure for each benchmark, in seconds.
+static double minimumTime = 0.25;
+// Only benchmarks whose names contain this are run.
+static std::string nameFilter;
+
+/**
+ * Runs a benchmark body until enough time has been measured, and prints the results.
+ * The body times its own work with the stopwatch, and returns the number of operations done.
+ */
+template <typename Body>
+void run(const std::string& name, Body body)
+{
+    if(name.find(nameFilter) == std::string::npos)
+    {
+        return;
+    }
+
+    Stopwatch stopwatch;
+    unsigned long operations = 0;
+    while(stopwatch.seconds < minimumTime)
+    {
+        operations += body(stopwatch);
+    }
+
+    std::cout << std::left << std::setw(46) << name << std::right << std::fixed
+        << std::setw(12) << std::setprecision(1) << stopwatch.seconds * 1e9 / operations << " ns/op"
+        << std::setw(10) << std::setprecision(2) << (double) stopwatch.allocations / operations << " allocs/op"
+        << std::endl;
+}
+
+static nel::SourcePosition* makePosition()
+{
+    // Nodes and definitions copy their position, so they can all share an unknown one.
+    static nel::SourcePosition position;
+    return &position;
+}
+
+static nel::Expression* makeNumber(unsigned int value)
+{
+    return new nel::Expression(new nel::NumberNode(value, makePosition()), makePosition());
+}
+
+// Typical code, for measuring the cost of each token.
+static std::string makeCodeInput()
+{
+    std::ostringstream os;
+    for(unsigned int i = 0; i < 2000; i++)
+    {
+        os << "    def label_" << i << ": // comment" << std::endl;
+        os << "        a: get #0x" << std::hex << i << std::dec << ", put @sprites[x], add #" << i % 256 << std::endl;
+        os << "        goto label_" << i << " when not zero" << std::endl;
+        os << "    byte: 1, 2, 3, 'text', 0b1010" << std::endl;
+    }
+    return os.str();
+}
+
+// Mostly comments and indentation, for measuring how fast text is skipped.
+static std::string makeCommentInput()
+{
+    std::ostringstream os;
+    for(unsigned int i = 0; i < 2000; i++)
+    {
+        os << "    /*" << std::endl;
+        os << "     * Explains the routine below at some length, as well-commented code does." << std::endl;
+        os << "     */" << std::endl;
+        os << "                    nop // and a note about this line in particular" << std::endl;
+        os << std::endl;
+    }
+    return os.str();
+}
+
+static std::string writeScannerInput(const std::string& text)
+{
+    const char* const FILENAME = "microbench_input.nel";
+    FILE* f = fopen(FILENAME, "wb");
+    if(!f)
+    {
+        std::cerr << "could not write " << FILENAME << std::endl;
+        exit(1);
+    }
+    fputs(text.c_str(), f);
+    fclose(f);
+    return FILENAME;
+}
+
+/**
+ * Scans the given text, counting either tokens or kilobytes as operations.
+ */
+static void benchmarkScanner(const std::string& description, const std::string& text, bool perKilobyte)
+{
+    std::string filename = writeScannerInput(text);
+    std::string name = std::string("scanner, ") + SCANNER_NAME + " (" + description + (perKilobyte ? ", per KB)" : ", per token)");
+
+    run(name, [&](Stopwatch& stopwatch)
+    {
+        nel::CompilationContext compilation;
+        nel::Arena* previous = nel::Arena::getCurrent();
+        nel::Arena::setCurrent(&compilation.getArena());
+        nel::ParserContext parser(compilation);
+        createLexer(parser);
+
+        unsigned long tokens = 0;
+        YYSTYPE value;
+        stopwatch.start();
+        pushInputFile(parser, filename.c_str());
+        while(yylex(&value, parser.getScanner()))
+        {
+            tokens++;
+        }
+        stopwatch.stop();
+
+        destroyLexer(parser);
+        nel::Arena::setCurrent(previous);
+        return perKilobyte ? text.size() / 1024 : tokens;
+    });
+
+    remove(filename.c_str());
+}
+
+static void benchmarkTryGet(unsigned int depth)
+{
+    nel::CompilationContext compilation;
+    nel::SourcePosition* position = makePosition();
+
+    // The symbol being looked up lives at the root, among plenty of others.
+    std::vector<nel::SymbolTable*> scopes;
+    scopes.push_back(new nel::SymbolTable());
+    for(unsigned int i = 0; i < 64; i++)
+    {
+        std::ostringstream os;
+        os << "root_" << i;
+        scopes[0]->put(compilation, new nel::ConstantDefinition(os.str(), 0), position);
+    }
+    for(unsigned int d = 1; d < depth; d++)
+    {
+        nel::SymbolTable* scope = new nel::SymbolTable(scopes.back());
+        for(unsigned int i = 0; i < 8; i++)
+        {
+            std::ostringstream os;
+            os << "local_" << d << "_" << i;
+            scope->put(compilation, new nel::ConstantDefinition(os.str(), 0), position);
+        }
+        scopes.push_back(scope);
+    }
+
+    std::ostringstream name;
+    name << "SymbolTable::tryGet (depth " << depth << ")";
+    nel::SymbolTable* leaf = scopes.back();
+    nel::SymbolId symbol = nel::SymbolPool::intern("root_42");
+    run(name.str(), [&](Stopwatch& stopwatch)
+    {
+        const unsigned int COUNT = 10000;
+        unsigned long found = 0;
+        stopwatch.start();
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            found += leaf->tryGet(symbol) != 0;
+        }
+        stopwatch.stop();
+        return found;
+    });
+
+    for(size_t i = scopes.size(); i > 0; i--)
+    {
+        delete scopes[i - 1];
+    }
+}
+
+/**
+ * Looks up every key of a table of the given size, half of them present,
+ * in one of the map types that a symbol table could use.
+ */
+template <typename Table, typename Key>
+static void benchmarkLookup(const std::string& description, const std::vector<Key>& keys)
+{
+    Table table;
+    for(size_t i = 0; i < keys.size(); i += 2)
+    {
+        table[keys[i]] = 0;
+    }
+
+    std::ostringstream name;
+    name << "lookup " << description << " (" << keys.size() / 2 << " keys)";
+    run(name.str(), [&](Stopwatch& stopwatch)
+    {
+        const unsigned int ROUNDS = 1000 / keys.size() + 1;
+        unsigned long found = 0;
+        stopwatch.start();
+        for(unsigned int r = 0; r < ROUNDS; r++)
+        {
+            for(size_t i = 0; i < keys.size(); i++)
+            {
+                found += table.find(keys[i]) != table.end();
+            }
+        }
+        stopwatch.stop();
+        return found ? ROUNDS * keys.size() : 0;
+    });
+}
+
+static void benchmarkLookups(unsigned int size)
+{
+    std::vector<nel::SymbolId> symbols;
+    std::vector<std::string> strings;
+    for(unsigned int i = 0; i < size * 2; i++)
+    {
+        std::ostringstream os;
+        os << "symbol_" << i;
+        symbols.push_back(nel::SymbolPool::intern(os.str()));
+        strings.push_back(os.str());
+    }
+
+    benchmarkLookup<nel::FlatMap<nel::SymbolId, nel::Definition*> >("FlatMap<id>", symbols);
+    benchmarkLookup<std::map<nel::SymbolId, nel::Definition*> >("std::map<id>", symbols);
+    benchmarkLookup<std::unordered_map<nel::SymbolId, nel::Definition*> >("unordered_map<id>", symbols);
+    benchmarkLookup<nel::FlatMap<std::string, nel::Definition*> >("FlatMap<string>", strings);
+    benchmarkLookup<std::map<std::string, nel::Definition*> >("std::map<string>", strings);
+    benchmarkLookup<std::unordered_map<std::string, nel::Definition*> >("unordered_map<string>", strings);
+}
+
+static void benchmarkFindDefinition(unsigned int depth)
+{
+    nel::CompilationContext compilation;
+    nel::SourcePosition* position = makePosition();
+
+    // Packages P0.P1...Pn, with a constant c in the innermost one.
+    nel::SymbolTable* root = new nel::SymbolTable();
+    nel::SymbolTable* scope = root;
+    nel::ListNode<nel::StringNode*>* pieces = new nel::ListNode<nel::StringNode*>(makePosition());
+    for(unsigned int d = 0; d < depth; d++)
+    {
+        std::ostringstream os;
+        os << "P" << d;
+        nel::SymbolTable* inner = new nel::SymbolTable(scope);
+        nel::PackageDefinition* package = new nel::PackageDefinition(os.str(), inner);
+        scope->put(compilation, package, position);
+        inner->setPackage(package);
+        scope = inner;
+        pieces->getList().push_back(new nel::StringNode(nel::SymbolPool::intern(os.str()), makePosition()));
+    }
+    scope->put(compilation, new nel::ConstantDefinition("c", 0), position);
+    pieces->getList().push_back(new nel::StringNode(nel::SymbolPool::intern("c"), makePosition()));
+
+    nel::Attribute attribute(pieces, makePosition());
+    compilation.enterScope(root);
+
+    // Lookups that allow undefined symbols search every time, while the rest are bound after the first.
+    for(int forbidUndefined = 0; forbidUndefined < 2; forbidUndefined++)
+    {
+        std::ostringstream name;
+        name << "Attribute::findDefinition (" << depth + 1 << " parts, " << (forbidUndefined ? "bound" : "unbound") << ")";
+        run(name.str(), [&](Stopwatch& stopwatch)
+        {
+            const unsigned int COUNT = 10000;
+            unsigned long found = 0;
+            stopwatch.start();
+            for(unsigned int i = 0; i < COUNT; i++)
+            {
+                found += attribute.findDefinition(compilation, forbidUndefined != 0) != 0;
+            }
+            stopwatch.stop();
+            return found;
+        });
+    }
+
+    compilation.exitScope();
+}
+
+static void benchmarkFold(unsigned int depth)
+{
+    nel::CompilationContext compilation;
+
+    std::ostringstream name;
+    name << "Expression::fold (" << depth << " operations)";
+    run(name.str(), [&](Stopwatch& stopwatch)
+    {
+        // Folding caches its result, so every fold needs a fresh tree.
+        const unsigned int COUNT = 1000;
+        nel::Arena arena;
+        nel::Arena* previous = nel::Arena::getCurrent();
+        nel::Arena::setCurrent(&arena);
+        std::vector<nel::Expression*> trees;
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            nel::Expression* tree = makeNumber(1);
+            for(unsigned int d = 0; d < depth; d++)
+            {
+                nel::Operation* operation = new nel::Operation(nel::Operation::ADD, tree, makeNumber(d & 0xF), makePosition());
+                tree = new nel::Expression(operation, makePosition());
+            }
+            trees.push_back(tree);
+        }
+
+        stopwatch.start();
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            trees[i]->fold(compilation, true, true);
+        }
+        stopwatch.stop();
+
+        nel::Arena::setCurrent(previous);
+        return COUNT;
+    });
+}
+
+static void benchmarkCommand(const std::string& description, nel::Argument* receiver, nel::Command* command)
+{
+    nel::CompilationContext compilation;
+    nel::RomBank bank(compilation);
+    bank.org(0x8000, 0);
+    bank.expand(8192, 0);
+
+    command->setReceiver(receiver);
+    command->calculateSize(compilation);
+
+    run("Command::calculateSize (" + description + ")", [&](Stopwatch& stopwatch)
+    {
+        const unsigned int COUNT = 10000;
+        unsigned long size = 0;
+        stopwatch.start();
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            size += command->calculateSize(compilation);
+        }
+        stopwatch.stop();
+        return size ? COUNT : 0;
+    });
+
+    run("Command::write (" + description + ")", [&](Stopwatch& stopwatch)
+    {
+        const unsigned int COUNT = 2000;
+        bank.resetPosition();
+        stopwatch.start();
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            command->write(compilation, &bank);
+        }
+        stopwatch.stop();
+        return COUNT;
+    });
+
+    delete command;
+    delete receiver;
+}
+
+static void benchmarkWriteByte()
+{
+    nel::CompilationContext compilation;
+    nel::RomBank bank(compilation);
+    bank.org(0x8000, 0);
+    bank.expand(8192, 0);
+    nel::SourcePosition* position = makePosition();
+
+    run("RomBank::writeByte", [&](Stopwatch& stopwatch)
+    {
+        const unsigned int COUNT = 8192;
+        bank.resetPosition();
+        stopwatch.start();
+        for(unsigned int i = 0; i < COUNT; i++)
+        {
+            bank.writeByte(i & 0xFF, position);
+        }
+        stopwatch.stop();
+        return COUNT;
+    });
+
+}
+
+int main(int argc, char** argv)
+{
+    if(argc > 1)
+    {
+        minimumTime = atof(argv[1]);
+    }
+    if(argc > 2)
+    {
+        nameFilter = argv[2];
+    }
+
+    // Holds the nodes and definitions that the benchmarks set up.
+    nel::Arena arena;
+    nel::Arena::setCurrent(&arena);
+
+    benchmarkScanner("code", makeCodeInput(), false);
+    benchmarkScanner("comments", makeCommentInput(), true);
+    benchmarkTryGet(1);
+    benchmarkTryGet(8);
+    benchmarkTryGet(32);
+    benchmarkLookups(4);
+    benchmarkLookups(64);
+    benchmarkLookups(1024);
+    benchmarkFindDefinition(1);
+    benchmarkFindDefinition(8);
+    benchmarkFold(8);
+    benchmarkFold(64);
+    benchmarkCommand("a: get #imm",
+        new nel::Argument(nel::Argument::A, makePosition()),
+        new nel::Command(nel::Command::GET, new nel::Argument(nel::Argument::IMMEDIATE, makeNumber(5), makePosition()), makePosition()));
+    benchmarkCommand("a: put @abs",
+        new nel::Argument(nel::Argument::A, makePosition()),
+        new nel::Command(nel::Command::PUT, new nel::Argument(nel::Argument::DIRECT, makeNumber(0x300), makePosition()), makePosition()));
+    benchmarkWriteByte();
+    return 0;
+}
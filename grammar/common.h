@@ -12,57 +12,27 @@
 #include "../ast/rom_generator.h"
 #include "../ast/ast.h"
 #include "../ast/path.h"
+#include "../ast/parser_context.h"
 
 /**
  * The type returned by each terminal and rule.
  */
 #define YYSTYPE nel::Node*
 
-/**
- * yyin is the file stream which yacc and lex use.
- */
-extern FILE* yyin;
-
-/**
- * The current position in source. Used by lex and yacc.
- */
-extern nel::SourcePosition* currentPosition;
-
-/**
- * The stack of all included files.
- */
-extern std::vector<nel::SourcePosition*> includeStack;
-const unsigned int INCLUDE_STACK_MAX = 15; // Used by above as hard-coded upper limit in file include depth.
-
-/**
- * The start node of the program. Set on a successful parse.
- */
-extern nel::BlockStatement* startNode;
-
-/**
- * Contains the content of a string literal being parsed.
- * Used by lex.
- */
-extern std::string stringContent;
-
-/**
- * The character used to terminate an active string literal.
- * Used by lex.
- */
-extern char stringTerminator;
+const unsigned int INCLUDE_STACK_MAX = 15; // Used as hard-coded upper limit in file include depth.
 
 extern "C"
 {
     /**
-     * Lexically scans yyin.
+     * Lexically scans the current input of a lexer from createLexer(), storing the token's value in value.
      * Provided here so that yacc has this prototype handy.
      */
-    int yylex();
+    int yylex(YYSTYPE* value, void* scanner);
     
     /**
      * lex and yacc use this for error reporting.
      */
-    void yyerror(const char*);
+    void yyerror(nel::ParserContext* parser, const char*);
 }
 
 /**
@@ -70,19 +40,20 @@ extern "C"
  * In debug mode this is an error-checked cast.
  * In release builds this may later be replaced with an unchecked C-style cast.
  */
-#define NEL_CAST(T, x)          NEL__cast<T>(x, __FILE__, __LINE__)
+#define NEL_CAST(T, x)          NEL__cast<T>(*parser, x, __FILE__, __LINE__)
 
 /**
- * Returns a copy of the current source position.
+ * Returns the current source position. Nodes keep a copy of it.
+ * Like NEL_CAST, this expects the parse to be in a variable named parser.
  */
-#define NEL_GET_SOURCE_POS      new nel::SourcePosition(currentPosition)
+#define NEL_GET_SOURCE_POS      parser->getCurrentPosition()
 
 /**
  * A function that converts a node into another type, and errors noisily if the cast fails.
  * Null values are simply passed through.
  */
 template <typename T>
-T NEL__cast(nel::Node* node, const char* file, int line)
+T NEL__cast(nel::ParserContext& parser, nel::Node* node, const char* file, int line)
 {
     if(node == 0) return 0;
     else
@@ -91,10 +62,10 @@ T NEL__cast(nel::Node* node, const char* file, int line)
         if(!result)
         {
             char message[4096];
-            sprintf(message, "Failed to cast '%s' node to '%s' in %s at line %d (%s:%d).",
-                typeid(*node).name(), typeid(T).name(), file, line,
-                currentPosition->getSourceFile()->getFilename().c_str(),
-                currentPosition->getLine()
+            std::ostringstream position;
+            parser.getCurrentPosition()->print(parser.getContext(), position);
+            sprintf(message, "Failed to cast '%s' node to '%s' in %s at line %d (%s).",
+                typeid(*node).name(), typeid(T).name(), file, line, position.str().c_str()
             );
             throw std::runtime_error(message); 
         }
@@ -105,26 +76,72 @@ T NEL__cast(nel::Node* node, const char* file, int line)
     }
 }
 
+/**
+ * Reports a number whose digits are given by text, which is too large for a word.
+ */
+inline void numberOutOfRange(nel::ParserContext& parser, const std::string& text)
+{
+    std::ostringstream os;
+    os << "Value " << text << " outside of representable range of 0..65535.";
+    parser.error(os.str(), parser.getCurrentPosition());
+}
+
 /**
  * Converts a string value with a given radix into an unsigned integer.
  * Errors if this exceeds the maximum word value.
  */
-inline unsigned int stringToNumber(const char* text, unsigned int radix)
+inline unsigned int stringToNumber(nel::ParserContext& parser, const char* text, unsigned int radix)
 {
     long value = strtol(text, 0, radix);
     
     if(errno == ERANGE || (unsigned long) value > nel::Expression::MAX_VALUE)
     {
-        std::ostringstream os;
-        os << "Value " << text << " outside of representable range of 0..65535.";
-        error(os.str(), currentPosition);
+        numberOutOfRange(parser, text);
         return 0;
     }
     return (unsigned int) value;
 }
 
-bool pushInputFile(const char* filename);
-bool popInputFile();
+bool pushInputFile(nel::ParserContext& parser, const char* filename);
+bool popInputFile(nel::ParserContext& parser);
+
+/**
+ * Splices a required file's statements onto the end of a list, with its name relative to the file being parsed.
+ * Its errors are reported as if its text were written there. A file required once is only spliced in
+ * once the whole program is parsed, and only if nothing before the require also required it.
+ */
+void requireFile(nel::ParserContext& parser, nel::ListNode<nel::Statement*>* list, const std::string& name, bool once);
+
+/**
+ * Makes the lexer scan a buffer in place, until it's done and returns to the current input.
+ * The buffer may be modified while it's scanned. Its size doesn't count the
+ * SourceBuffer::PADDING zero bytes, which must follow it.
+ */
+void pushLexerBuffer(nel::ParserContext& parser, char* data, size_t size);
+
+/**
+ * The name of the scanner that was built in: "flex" for the one generated from nel.l,
+ * or "fast" for the hand-written one in scanner.cpp.
+ */
+extern const char* const SCANNER_NAME;
+
+/**
+ * Creates a lexer for a parse, with no input, and stores it in the parser context.
+ */
+void createLexer(nel::ParserContext& parser);
+
+/**
+ * Destroys a parse's lexer, discarding any input left over in it.
+ */
+void destroyLexer(nel::ParserContext& parser);
+
+/**
+ * Parses and compiles the given source file, leaving the result in the context.
+ * Returns true if the compilation succeeded, and false if any errors occurred.
+ * Errors (fatal or otherwise) are reported to the context, and never end the process.
+ * A package to precompile needs no ines header, and is only compiled as far as binding its names.
+ */
+bool compileFile(nel::CompilationContext& context, const char* filename, bool package = false);
 
 #ifdef _MSC_VER
 #define YY_NO_UNISTD_H 1
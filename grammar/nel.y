@@ -2,8 +2,27 @@
 
 #include "common.h"
 #include "y.tab.hpp"
-#include "lex.yy.h"
 #include <fstream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+
+#include "../ast/source_buffer.h"
+#include "../ast/source_file.h"
+#include "../ast/required_file.h"
+#include "../ast/require_queue.h"
+#include "../ast/precompiled_package.h"
+#include "../ast/build_cache.h"
+#include "../ast/file_cache.h"
+#include "../ast/compile_server.h"
+#include "../ast/file_watcher.h"
+#include "../ast/lowered_program.h"
+#include "../ast/statistics.h"
+#include "../ast/trace_recorder.h"
 
 #ifdef _MSC_VER
 // bison generates a switch statement which only has
@@ -11,11 +30,24 @@
 #pragma warning(disable:4065)
 #endif
 
+// The parser fetches tokens through here, so they can be counted.
+static int countTokensAndLex(YYSTYPE* value, nel::ParserContext* parser)
+{
+    nel::Statistics::count(nel::Statistics::TOKENS_LEXED);
+    return yylex(value, parser->getScanner());
+}
+#define yylex countTokensAndLex
+
 %}
 
 /* Give verbose error messages */
 %error-verbose
 
+/* Keep all state in the parser context, so that several parses can run at once */
+%define api.pure
+%parse-param {nel::ParserContext* parser}
+%lex-param {nel::ParserContext* parser}
+
 %token IDENTIFIER "identifier"
 %token NUMBER "number"
 %token STRING "string literal"
@@ -105,26 +137,10 @@
 %token INVALID_CHAR "invalid character"
 %token UNTERMINATED_STRING "unterminated string literal"
 
-/* 
-    Destructor rules.
-    WHY WHY WHY DO I HAVE TO DEFINE EVERY NODE OH GOD
-    
-    I recommend doing a Find All for ":" and then writing each nonterminal entry that way,
-    better than actually scrolling around. Still godawful.
+/*
+    There are no %destructor rules. Symbols thrown away by error recovery
+    belong to the compilation's arena, and are freed along with it.
  */
-%destructor {
-                // Only do cleanup here if we didn't successfully parse. Otherwise, let me do the cleanup.
-                if(!startNode)
-                {
-                    // delete $$;
-                }
-            }
-            // TODO: majorly fix memory cleanup problems.
-            program statement_list statement label_declaration constant_declaration var_declaration
-            opt_size goto_statement goto_term relocate_statement data_statement data_list data_term command_statement
-            when_condition condition command_list command
-            argument numeric_term expr opt_register_indexing
-            IDENTIFIER NUMBER STRING
 
 /* Start node */
 %start program
@@ -134,8 +150,9 @@
 program:
     statement_list
         {
-            startNode = new nel::BlockStatement(nel::BlockStatement::MAIN, NEL_CAST(nel::ListNode<nel::Statement*>*, $1), NEL_GET_SOURCE_POS);
-            $$ = startNode;
+            // Required files are programs too, so whoever asked for the parse decides what to do with these.
+            parser->setStatements(NEL_CAST(nel::ListNode<nel::Statement*>*, $1));
+            $$ = $1;
             YYACCEPT;
         }
     ;
@@ -151,6 +168,21 @@ statement_list:
             }
             $$ = $1;
         }
+    | statement_list require_statement
+        {
+            // The required file's statements go where the require was, as if its text were written there.
+            requireFile(*parser, NEL_CAST(nel::ListNode<nel::Statement*>*, $1), NEL_CAST(nel::StringNode*, $2)->getValue(), false);
+            $$ = $1;
+        }
+    | statement_list require_once_statement
+        {
+            // Likewise, unless the file was already required somewhere earlier in the program.
+            if($2)
+            {
+                requireFile(*parser, NEL_CAST(nel::ListNode<nel::Statement*>*, $1), NEL_CAST(nel::StringNode*, $2)->getValue(), true);
+            }
+            $$ = $1;
+        }
     | /* empty */
         {
             $$ = new nel::ListNode<nel::Statement*>(NEL_GET_SOURCE_POS);
@@ -162,10 +194,6 @@ statement:
         {
             $$ = $1;
         }
-    | require_statement
-        {
-            $$ = $1;
-        }
     | embed_statement
         {
             $$ = $1;
@@ -228,9 +256,26 @@ block_statement:
 require_statement:
     KW_REQUIRE STRING
         {
-            $$ = 0;
-            // Lookup the relative path to the required input file based on the current source, and add it to the input stack.
-            pushInputFile(std::string(nel::getDirectory(currentPosition->getSourceFile()->getFilename()) + NEL_CAST(nel::StringNode*, $2)->getValue()).c_str());
+            $$ = $2;
+        }
+    ;
+
+require_once_statement:
+    KW_REQUIRE IDENTIFIER STRING
+        {
+            // once isn't a keyword, so it can still name things everywhere else.
+            nel::StringNode* modifier = NEL_CAST(nel::StringNode*, $2);
+            if(modifier->getValue() != "once")
+            {
+                std::ostringstream os;
+                os << "expected `once` or a filename after require, not `" << modifier->getValue() << "`.";
+                parser->error(os.str(), parser->getCurrentPosition());
+                $$ = 0;
+            }
+            else
+            {
+                $$ = $3;
+            }
         }
     ;
 
@@ -429,12 +474,12 @@ condition:
     IDENTIFIER
         {
             nel::StringNode* id = NEL_CAST(nel::StringNode*, $1);
-            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(id->getValue());
+            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(parser->getContext(), id->getSymbol());
             if(argType == nel::Argument::INVALID)
             {
                 std::ostringstream os;
                 os << "expected a p-flag, not `" << id->getValue() << "`.";
-                nel::error(os.str(), currentPosition);
+                parser->error(os.str(), parser->getCurrentPosition());
             }
             nel::Argument* arg = new nel::Argument(argType, NEL_GET_SOURCE_POS);
             $$ = new nel::BranchCondition(nel::BranchCondition::CONDITION_SET, arg, NEL_GET_SOURCE_POS);
@@ -442,12 +487,12 @@ condition:
     | KW_NOT IDENTIFIER
         {
             nel::StringNode* id = NEL_CAST(nel::StringNode*, $2);
-            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(id->getValue());
+            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(parser->getContext(), id->getSymbol());
             if(argType == nel::Argument::INVALID)
             {
                 std::ostringstream os;
                 os << "expected a p-flag, not `" << id->getValue() << "`.";
-                nel::error(os.str(), currentPosition);
+                parser->error(os.str(), parser->getCurrentPosition());
             }
             nel::Argument* arg = new nel::Argument(argType, NEL_GET_SOURCE_POS);
             $$ = new nel::BranchCondition(nel::BranchCondition::CONDITION_UNSET, arg, NEL_GET_SOURCE_POS);
@@ -510,7 +555,7 @@ command:
             
             $$ = new nel::Command(nel::Command::INVALID, NEL_GET_SOURCE_POS);
             
-            nel::error(os.str(), currentPosition);
+            parser->error(os.str(), parser->getCurrentPosition());
         }
     ;
     
@@ -519,12 +564,12 @@ argument:
     IDENTIFIER
         {
             nel::StringNode* id = NEL_CAST(nel::StringNode*, $1);
-            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(id->getValue());
+            nel::Argument::ArgumentType argType = nel::Argument::resolveUnprefixedBuiltinType(parser->getContext(), id->getSymbol());
             if(argType == nel::Argument::INVALID)
             {
                 std::ostringstream os;
                 os << "expected a register or p-flag, not `" << id->getValue() << "`. Did you forget an @ or # sign?";
-                nel::error(os.str(), currentPosition);
+                parser->error(os.str(), parser->getCurrentPosition());
             }
             $$ = new nel::Argument(argType, NEL_GET_SOURCE_POS);
         }
@@ -539,12 +584,12 @@ argument:
             if($3)
             {
                 nel::StringNode* index = NEL_CAST(nel::StringNode*, $3);
-                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(index->getValue());
+                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(parser->getContext(), index->getSymbol());
                 if(indexType == nel::Argument::INVALID)
                 {
                     std::ostringstream os;
                     os << "term may only be indexed by x or y, not `" << index->getValue() << "`.";
-                    nel::error(os.str(), currentPosition);
+                    parser->error(os.str(), parser->getCurrentPosition());
                 }
                 $$ = new nel::Argument(indexType, NEL_CAST(nel::Expression*, $2), NEL_GET_SOURCE_POS);
             }
@@ -558,18 +603,18 @@ argument:
         {
             if($4 && $6)
             {
-                nel::error("an indirected term cannot be indexed both before and after indirection.", currentPosition);
+                parser->error("an indirected term cannot be indexed both before and after indirection.", parser->getCurrentPosition());
                 $$ = 0;
             }
             else if(!$4 && !$6)
             {
-                nel::error("an indirected term must be indexed in some manner, either before indirection by x or after indirection by y.", currentPosition);
+                parser->error("an indirected term must be indexed in some manner, either before indirection by x or after indirection by y.", parser->getCurrentPosition());
                 $$ = 0;
             }
             else if($4)
             {
                 nel::StringNode* preIndex = NEL_CAST(nel::StringNode*, $4);
-                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(preIndex->getValue());
+                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(parser->getContext(), preIndex->getSymbol());
                 
                 if(indexType == nel::Argument::INDEXED_BY_X)
                 {
@@ -579,14 +624,14 @@ argument:
                 {
                     std::ostringstream os;
                     os << "an indirected term may only be indexed by x before indirection, not by `" << preIndex->getValue() << "`.";
-                    nel::error(os.str(), currentPosition);
+                    parser->error(os.str(), parser->getCurrentPosition());
                     $$ = 0;
                 }
             }
             else if($6)
             {
                 nel::StringNode* postIndex = NEL_CAST(nel::StringNode*, $6);
-                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(postIndex->getValue());
+                nel::Argument::ArgumentType indexType = nel::Argument::resolveIndexedType(parser->getContext(), postIndex->getSymbol());
                 
                 if(indexType == nel::Argument::INDEXED_BY_Y)
                 {
@@ -596,7 +641,7 @@ argument:
                 {
                     std::ostringstream os;
                     os << "an indirected term may only be indexed by y after indirection, not by `" << postIndex->getValue() << "`.";
-                    nel::error(os.str(), currentPosition);
+                    parser->error(os.str(), parser->getCurrentPosition());
                     $$ = 0;
                 }
             }
@@ -686,66 +731,156 @@ opt_register_indexing:
 
 %%
 
-nel::SourcePosition* currentPosition = 0;
-std::vector<nel::SourcePosition*> includeStack;
-nel::BlockStatement* startNode = 0;
-std::string stringContent;
-char stringTerminator;
+/**
+ * Creates a lexer for a parse, which is destroyed along with this.
+ */
+struct ScopedLexer
+{
+    nel::ParserContext& parser;
 
-void yyerror(const char* message)
+    ScopedLexer(nel::ParserContext& parser)
+        : parser(parser)
+    {
+        createLexer(parser);
+    }
+
+    ~ScopedLexer()
+    {
+        destroyLexer(parser);
+    }
+};
+
+void yyerror(nel::ParserContext* parser, const char* message)
 {
-    nel::error(message, currentPosition);
+    parser->error(message, parser->getCurrentPosition());
 }
 
-bool aggregate()
+bool aggregate(nel::CompilationContext& context)
 {
-    std::cerr << "- first pass (aggregation)..." << std::endl;
-    startNode->aggregate();
-    return !nel::errorCount;
+    context.getLog() << "- first pass (aggregation)..." << std::endl;
+    nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::AGGREGATE);
+    nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "aggregate");
+    context.getStartNode()->aggregate(context);
+    return !context.getErrorCount();
 }
 
-bool validate()
+// Binds names to their scopes once everything is declared. Part of the first pass, as far as the log is concerned.
+// Flattens the program for the later passes along the way, if it's going to be generated.
+bool resolve(nel::CompilationContext& context, bool lower)
 {
-    std::cerr << "- second pass (validation)..." << std::endl;
-    startNode->validate();
-    return !nel::errorCount;
+    nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::RESOLVE);
+    nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "resolve");
+    if(lower)
+    {
+        context.setLoweredProgram(new nel::LoweredProgram());
+    }
+    context.getStartNode()->resolve(context);
+    return !context.getErrorCount();
 }
 
-bool generate()
+bool validate(nel::CompilationContext& context)
 {
-    std::cerr << "- third pass (generation)..." << std::endl;
-    nel::romGenerator->resetRomPosition();
-    startNode->generate();
-    return !nel::errorCount;
+    context.getLog() << "- second pass (validation)..." << std::endl;
+    nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::VALIDATE);
+    nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "validate");
+    context.getLoweredProgram()->validate(context);
+    return !context.getErrorCount();
 }
 
-void printUsage(const char* msg = 0)
+bool generate(nel::CompilationContext& context)
+{
+    context.getLog() << "- third pass (generation)..." << std::endl;
+    nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::GENERATE);
+    nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "generate");
+    context.getRomGenerator()->resetRomPosition();
+    context.getLoweredProgram()->generate(context);
+
+    if(nel::Statistics* statistics = context.getStatistics())
+    {
+        nel::RomGenerator* romGenerator = context.getRomGenerator();
+        std::vector<unsigned int> bankBytes;
+        for(unsigned int i = 0; i < romGenerator->getBankCount(); i++)
+        {
+            bankBytes.push_back(romGenerator->getBank(i)->getBytesWritten());
+        }
+        statistics->setBankBytes(bankBytes);
+    }
+    return !context.getErrorCount();
+}
+
+void printUsage(std::ostream& err, const char* msg = 0)
 {
     if(msg)
     {
-        std::cerr << "* " << nel::PROGRAM_NAME << ": " << msg << std::endl << std::endl;
+        err << "* " << nel::PROGRAM_NAME << ": " << msg << std::endl << std::endl;
     }
 
-    std::cerr << "usage: " << nel::PROGRAM_NAME << " filename" << std::endl;
-    std::cerr << "  where `filename` is a nel source file to compile." << std::endl;
+    err << "usage: " << nel::PROGRAM_NAME << " [--connect socket] [--jobs N] filename [-o output] [filename [-o output] ...]" << std::endl;
+    err << "       " << nel::PROGRAM_NAME << " --serve socket" << std::endl;
+    err << "  where each `filename` is a nel source file to compile." << std::endl;
+    err << "options:" << std::endl;
+    err << "  -o output     write the ROM for the preceding filename to `output`." << std::endl;
+    err << "                defaults to `out.nes` for a single file, or the filename" << std::endl;
+    err << "                with its extension replaced by `.nes` for several." << std::endl;
+    err << "  -j, --jobs N  compile up to N files at once. defaults to the number of cores." << std::endl;
+    err << "  -MD           write a makefile rule listing every file that went into each output," << std::endl;
+    err << "                to the output's filename with its extension replaced by `.d`." << std::endl;
+    err << "  -MF file      write the rule for the preceding filename to `file`, instead." << std::endl;
+    err << "  --parse-jobs N" << std::endl;
+    err << "                parse up to N required files at once for each file compiled." << std::endl;
+    err << "                defaults to the number of cores, or 1 when several files are compiled at once." << std::endl;
+    err << "  --time-passes[=text|json]" << std::endl;
+    err << "                report the time spent in each phase and some counters for each file." << std::endl;
+    err << "                text reports are logged; json reports go to stdout, one line per file." << std::endl;
+    err << "  --trace file  write a Chrome trace-event file of the compilation to `file`." << std::endl;
+    err << "  --no-mmap     read source files through stdio, instead of mapping them into memory." << std::endl;
+    err << "                always the case with --watch and --serve." << std::endl;
+    err << "  --precompile  compile each file of constants and packages into a precompiled package," << std::endl;
+    err << "                which is loaded in place of the file when it's required." << std::endl;
+    err << "                defaults to writing the filename with its extension replaced by `.nelpkg`," << std::endl;
+    err << "                which is where requires look for it." << std::endl;
+    err << "  --cache dir   keep finished builds in `dir`, and copy out the ROM instead of" << std::endl;
+    err << "                compiling when none of the files that went into it have changed." << std::endl;
+    err << "                required files of constants and packages are kept precompiled there too." << std::endl;
+    err << "  --serve socket" << std::endl;
+    err << "                run as a compile server listening on the Unix domain socket `socket`," << std::endl;
+    err << "                which keeps finished builds, precompiled packages and embedded files" << std::endl;
+    err << "                in memory for as long as it runs, unless --cache says otherwise." << std::endl;
+    err << "  --connect socket" << std::endl;
+    err << "                send the rest of the command line to the compile server on `socket`," << std::endl;
+    err << "                or compile here if there isn't one." << std::endl;
+    err << "  --watch       after compiling, keep watching every file that went into each ROM," << std::endl;
+    err << "                and compile the ROMs that use a file again whenever it changes." << std::endl;
 }
 
-bool pushInputFile(const char* filename)
+bool pushInputFile(nel::ParserContext& parser, const char* filename)
 {
-    FILE* f = fopen(filename, "rb");
+    nel::CompilationContext& context = parser.getContext();
+
+    // Files that can't be mapped, like pipes, are read through stdio instead.
+    nel::SourceBuffer* buffer = context.getMapSourceFiles() ? nel::SourceBuffer::map(filename) : 0;
+    if(!buffer)
+    {
+        if(FILE* f = fopen(filename, "rb"))
+        {
+            buffer = nel::SourceBuffer::read(f);
+            fclose(f);
+        }
+    }
     
-    nel::SourcePosition* includePoint = currentPosition;
+    nel::SourcePosition includePoint = *parser.getCurrentPosition();
+    std::vector<nel::SourcePosition>& includeStack = parser.getIncludeStack();
     
-    if(f)
+    if(buffer)
     {   
         // Modify the source position info.
-        if(includePoint)
+        if(includePoint.isKnown())
         {
             // Save position on stack
             includeStack.push_back(includePoint);
-            
+
             // Set up new position in included file.
-            currentPosition = new nel::SourcePosition(new nel::SourceFile(filename, new nel::SourcePosition(includePoint)));
+            parser.setCurrentPosition(context.addSourceFile(filename, buffer, includePoint));
             
             // Too many includes? error.
             if(includeStack.size() > INCLUDE_STACK_MAX)
@@ -755,120 +890,1115 @@ bool pushInputFile(const char* filename)
                     INCLUDE_STACK_MAX << "). are there mutually-dependent source files?";
                 for(size_t i = 0; i < includeStack.size(); i++)
                 {
-                    nel::SourcePosition* entry = includeStack[i];
                     os << std::endl << "    at "; 
-                    entry->print(os, true);
+                    includeStack[i].print(context, os, true);
                 }
                 {
-                    nel::SourcePosition* entry = currentPosition;
                     os << std::endl << "    at "; 
-                    entry->print(os, true);
+                    parser.getCurrentPosition()->print(context, os, true);
                 }
-                nel::error(os.str(), includePoint, true);
+                parser.error(os.str(), &includePoint, true);
             }
         }
         else
         {
             // First file, probably.
-            currentPosition = new nel::SourcePosition(new nel::SourceFile(filename));
+            parser.setCurrentPosition(context.addSourceFile(filename, buffer));
         }
         
-        // Switch the input stream for the lexer.
-        yyin = f;
-        yypush_buffer_state(yy_create_buffer(yyin, YY_BUF_SIZE));
+        // Switch the lexer over to the new file's text, which it scans in place.
+        pushLexerBuffer(parser, buffer->getData(), buffer->getSize());
         
         return true;
     }
     else
     {
         // If there is at least one file opened, we should use typical error reporting.
-        // Otherwise, the main program should use the return value to determine the outcome.
-        if(currentPosition)
+        // Otherwise, the caller should use the return value to determine the outcome.
+        if(includePoint.isKnown())
         {
             std::ostringstream os;
             os << "could not open file '" << filename << "' which was included here.";
-            nel::error(os.str(), currentPosition);
+            parser.error(os.str(), &includePoint);
         }
         return false;
     }
 }
 
-bool popInputFile()
+bool popInputFile(nel::ParserContext& parser)
 {
+    std::vector<nel::SourcePosition>& includeStack = parser.getIncludeStack();
+
     // No source information left to pop.
-    if(!currentPosition || includeStack.empty())
+    if(includeStack.empty())
     {
         return false;
     }
     else
     {
-        // Delete current source position from stack.
-        delete currentPosition;
-        
         // Pop back to previous position.
-        currentPosition = includeStack.back();
+        parser.setCurrentPosition(includeStack.back());
         includeStack.pop_back();
         
         return true;
     }
 }
 
-int main(int argc, char** argv)
+/**
+ * Finds the requires in a file that a parse is about to start on, and queues up the files they name,
+ * so that they're parsed on other threads by the time the parse reaches them.
+ */
+static void prescanRequires(nel::ParserContext& parser)
 {
-    if(argc < 2)
+    nel::RequireQueue* queue = parser.getRequireQueue();
+    if(!queue->isParallel())
     {
-        printUsage("insufficient arguments");
-        return 1;
+        return;
     }
-    
-    std::cerr << "* " << nel::PROGRAM_NAME << ": compiling..." << std::endl;
-    if(!pushInputFile(argv[1]))
+
+    nel::CompilationContext& context = parser.getContext();
+    nel::SourcePosition start = *parser.getCurrentPosition();
+    nel::SourceFile* sourceFile = context.getSourceFile(start.getFile());
+    nel::SourceBuffer* buffer = sourceFile->getBuffer();
+
+    // Most files don't require anything, which is quicker to see from their text than by scanning them.
+    static const char keyword[] = "require";
+    const char* end = buffer->getData() + buffer->getSize();
+    if(std::search((const char*) buffer->getData(), end, keyword, keyword + sizeof(keyword) - 1) == end)
     {
-        std::cerr << "* " << nel::PROGRAM_NAME << ": fatal: could not open file '" << argv[1] << "' which was provided on command line." << std::endl;
-        return 1;
+        return;
+    }
+
+    // Files required from this one may report errors that print positions in it, while it's still being
+    // scanned. Once it's indexed, doing so only reads from it, so that has to happen before any are queued.
+    sourceFile->indexLines();
+
+    // The scan has a lexer of its own. The nodes it makes are thrown away with its arena,
+    // and its errors with its context, since the parse will find them again.
+    nel::Arena scratch;
+    nel::Arena* arena = nel::Arena::getCurrent();
+    nel::Statistics* statistics = nel::Statistics::getCurrent();
+    nel::Arena::setCurrent(&scratch);
+    nel::Statistics::setCurrent(0);
+    try
+    {
+        nel::ParserContext scan(context, true);
+        scan.setCurrentPosition(start);
+        ScopedLexer lexer(scan);
+        pushLexerBuffer(scan, buffer->getData(), buffer->getSize());
+
+        std::string directory = nel::getDirectory(sourceFile->getFilename());
+        YYSTYPE value = 0;
+        bool afterRequire = false;
+        bool once = false;
+        while(int token = yylex(&value, &scan))
+        {
+            if(afterRequire && token == STRING)
+            {
+                std::string filename = directory + static_cast<nel::StringNode*>(value)->getValue();
+                parser.addRequire(queue->add(filename, *scan.getCurrentPosition(), parser.getIncludeStack(), once));
+            }
+            else if(afterRequire && !once && token == IDENTIFIER && static_cast<nel::StringNode*>(value)->getValue() == "once")
+            {
+                once = true;
+                continue;
+            }
+            afterRequire = token == KW_REQUIRE;
+            once = false;
+        }
+    }
+    catch(...)
+    {
+        // The scan is only a head start. Anything that went wrong here is left for the parse to find.
+    }
+    nel::Arena::setCurrent(arena);
+    nel::Statistics::setCurrent(statistics);
+}
+
+/**
+ * Parses a required file for a RequireQueue, on whichever thread got to it.
+ * Its errors are kept to be reported where it was required, so that they come out
+ * in the same order as they would if its text were written there.
+ */
+static void parseRequiredFile(nel::RequireQueue& queue, nel::RequiredFile& file)
+{
+    nel::ParserContext parser(queue.getContext(), true);
+    parser.setRequireQueue(&queue);
+    parser.getIncludeStack() = file.getIncludeStack();
+    parser.setCurrentPosition(file.getIncludePoint());
+    try
+    {
+        ScopedLexer lexer(parser);
+        if(pushInputFile(parser, file.getFilename().c_str()))
+        {
+            nel::CompilationContext& context = parser.getContext();
+            unsigned int sourceFile = parser.getCurrentPosition()->getFile();
+            file.setIdentity(context.getSourceFile(sourceFile)->getBuffer()->getIdentity());
+
+            // A precompiled package of the file stands in for parsing it, as long as it was made from the same text.
+            // One next to the file comes first, then one from an earlier build.
+            std::string packageFilename = nel::PrecompiledPackage::getFilename(file.getFilename());
+            nel::ListNode<nel::Statement*>* statements = nel::PrecompiledPackage::load(packageFilename, file.getIdentity(), sourceFile,
+                context.getMapSourceFiles());
+            if(!statements && context.getBuildCache())
+            {
+                statements = context.getBuildCache()->loadPackage(file.getIdentity(), sourceFile);
+            }
+            if(statements)
+            {
+                file.setStatements(statements);
+            }
+            else
+            {
+                prescanRequires(parser);
+                if(!yyparse(&parser))
+                {
+                    file.setStatements(parser.getStatements());
+                }
+            }
+        }
+    }
+    catch(const nel::FatalError&)
+    {
+        // Already kept with the rest of the errors.
+    }
+    catch(...)
+    {
+        file.setException(std::current_exception());
+    }
+    file.getDiagnostics().swap(parser.getDiagnostics());
+    file.getInclusions().swap(parser.getInclusions());
+}
+
+void requireFile(nel::ParserContext& parser, nel::ListNode<nel::Statement*>* list, const std::string& name, bool once)
+{
+    nel::RequireQueue* queue = parser.getRequireQueue();
+    nel::SourcePosition includePoint = *parser.getCurrentPosition();
+    // Lookup the relative path to the required input file based on the current source.
+    std::string filename = nel::getDirectory(parser.getContext().getSourceFile(includePoint.getFile())->getFilename()) + name;
+
+    // The prescan usually queued the file already, and it may well be parsed by now.
+    // If the prescan missed it somehow, it's parsed now instead.
+    nel::RequiredFile* file = parser.findRequire(filename, includePoint);
+    if(!file)
+    {
+        file = queue->add(filename, includePoint, parser.getIncludeStack(), once);
+    }
+
+    nel::ParserContext::Inclusion inclusion = {file, once, list, list->getList().size()};
+    parser.addInclusion(inclusion);
+    if(once)
+    {
+        // Whether it goes here depends on everything required before it, which isn't known until the whole program is parsed.
+        return;
+    }
+
+    {
+        nel::TraceRecorder::Span span(parser.getTraceRecorder(), "require", filename.c_str());
+        queue->finish(*file);
+    }
+    parser.report(file->getDiagnostics());
+    if(file->getException())
+    {
+        std::rethrow_exception(file->getException());
+    }
+
+    if(nel::ListNode<nel::Statement*>* statements = file->getStatements())
+    {
+        nel::ListNode<nel::Statement*>::ListType& target = list->getList();
+        size_t index = target.size();
+        target.insert(target.end(), statements->getList().begin(), statements->getList().end());
+
+        // The files it required once now go in this list, wherever its statements went.
+        std::vector<nel::ParserContext::Inclusion>& inclusions = file->getInclusions();
+        for(size_t i = 0; i < inclusions.size(); i++)
+        {
+            nel::ParserContext::Inclusion nested = inclusions[i];
+            if(nested.list == statements)
+            {
+                nested.list = list;
+                nested.index += index;
+            }
+            parser.addInclusion(nested);
+        }
+    }
+}
+
+/**
+ * Splices in the files that were required once, in the order they're required in the program,
+ * skipping any that match a file required before them. Their errors are reported as they go in.
+ */
+static void spliceOnceRequires(nel::ParserContext& parser, std::vector<nel::ParserContext::Inclusion>& inclusions,
+    std::vector<nel::FileIdentity>& required, std::map<nel::ListNode<nel::Statement*>*, size_t>& shifts)
+{
+    for(size_t i = 0; i < inclusions.size(); i++)
+    {
+        nel::ParserContext::Inclusion& inclusion = inclusions[i];
+        nel::RequiredFile* file = inclusion.file;
+        if(!inclusion.once)
+        {
+            // Already spliced in, with its own requires following it here.
+            required.push_back(file->getIdentity());
+            continue;
+        }
+
+        parser.getRequireQueue()->finish(*file);
+        bool duplicate = false;
+        for(size_t j = 0; j < required.size() && !duplicate; j++)
+        {
+            duplicate = required[j].matches(file->getIdentity());
+        }
+        if(duplicate)
+        {
+            nel::Statistics::count(nel::Statistics::REQUIRES_SKIPPED);
+            continue;
+        }
+        required.push_back(file->getIdentity());
+
+        parser.report(file->getDiagnostics());
+        if(file->getException())
+        {
+            std::rethrow_exception(file->getException());
+        }
+
+        // Its own requires go in first, so it's whole by the time it's spliced in.
+        spliceOnceRequires(parser, file->getInclusions(), required, shifts);
+        if(nel::ListNode<nel::Statement*>* statements = file->getStatements())
+        {
+            // Earlier files spliced into the same list moved everything after them along.
+            nel::ListNode<nel::Statement*>::ListType& target = inclusion.list->getList();
+            size_t& shift = shifts[inclusion.list];
+            target.insert(target.begin() + inclusion.index + shift, statements->getList().begin(), statements->getList().end());
+            shift += statements->getList().size();
+        }
     }
+}
 
-    nel::errorCount = 0;
-    currentPosition = new nel::SourcePosition(new nel::SourceFile(argv[1]));
-    stringContent = "";
-    stringTerminator = 0;
-    startNode = 0;
+bool compileFile(nel::CompilationContext& context, const char* filename, bool package)
+{
+    std::ostream& log = context.getLog();
+    log << "* " << nel::PROGRAM_NAME << ": compiling..." << std::endl;
 
+    // Counters deep in the compiler go to this compilation's statistics while it runs on this thread.
+    struct CurrentStatistics
+    {
+        CurrentStatistics(nel::Statistics* statistics)
+        {
+            nel::Statistics::setCurrent(statistics);
+        }
+        ~CurrentStatistics()
+        {
+            nel::Statistics::setCurrent(0);
+        }
+    } currentStatistics(context.getStatistics());
+
+    // Likewise, the AST and definitions are allocated from this compilation's arena.
+    struct CurrentArena
+    {
+        CurrentArena(nel::Arena* arena)
+        {
+            nel::Arena::setCurrent(arena);
+        }
+        ~CurrentArena()
+        {
+            nel::Arena::setCurrent(0);
+        }
+    } currentArena(&context.getArena());
+
+    // The parse keeps all of its state to itself, including its lexer, so any number may run at once.
+    // Required files are parsed on their own, by threads working ahead of it.
+    {
+        unsigned int parseJobs = context.getParseJobs();
+        nel::RequireQueue requires(context, parseRequiredFile, parseJobs ? parseJobs : std::max(1u, std::thread::hardware_concurrency()));
+        nel::ParserContext parser(context);
+        parser.setRequireQueue(&requires);
+        ScopedLexer lexer(parser);
+
+        bool parsed = false;
+        if(!pushInputFile(parser, filename))
+        {
+            log << "* " << nel::PROGRAM_NAME << ": fatal: could not open file '" << filename << "' which was provided on command line." << std::endl;
+        }
+        else
+        {
+            try
+            {
+                nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::PARSE);
+                nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "parse");
+                prescanRequires(parser);
+                if(!yyparse(&parser))
+                {
+                    nel::SourceFile* sourceFile = context.getSourceFile(parser.getCurrentPosition()->getFile());
+                    std::vector<nel::FileIdentity> required(1, sourceFile->getBuffer()->getIdentity());
+                    std::map<nel::ListNode<nel::Statement*>*, size_t> shifts;
+                    // Splicing grows lists that live in the arenas of the threads that parsed them,
+                    // so every file has to be parsed, and those threads done with their arenas, first.
+                    requires.finishAll();
+                    spliceOnceRequires(parser, parser.getInclusions(), required, shifts);
+                    parsed = !context.getErrorCount();
+                }
+                if(parsed)
+                {
+                    // A package has no header of its own, and only ever goes inside another program's block.
+                    nel::BlockStatement::BlockType blockType = package ? nel::BlockStatement::SCOPE : nel::BlockStatement::MAIN;
+                    context.setStartNode(new nel::BlockStatement(blockType, parser.getStatements(), parser.getCurrentPosition()));
+                }
+                else
+                {
+                    log << "* " << nel::PROGRAM_NAME << ": failed compilation with " << context.getErrorCount() << " error(s)." << std::endl;
+                }
+            }
+            catch(const nel::FatalError&)
+            {
+                // Already reported, just throw away whatever the lexer was in the middle of.
+                if(nel::TraceRecorder* recorder = context.getTraceRecorder())
+                {
+                    recorder->endAll();
+                }
+            }
+        }
+
+        if(!parsed)
+        {
+            return false;
+        }
+    }
+
+    try
+    {
+        // A package's constants only need to be declared and bound before they're folded as it's written.
+        if(!(aggregate(context) && resolve(context, !package) && (package || (validate(context) && generate(context)))))
+        {
+            nel::failCompilation(context);
+        }
+    }
+    catch(const nel::FatalError&)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool writeRom(nel::CompilationContext& context, const std::string& filename)
+{
+    std::ostream& log = context.getLog();
+
+    log << "* saving ROM..." << std::endl;
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+    if(file.is_open())
+    {
+        {
+            nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::OUTPUT);
+            nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "output");
+            context.getRomGenerator()->outputToStream(file);
+            file.flush();
+        }
+        log << "* " << nel::PROGRAM_NAME << ": wrote to '" << filename << "'." << std::endl;
+        file.close();
+    }
+    else
+    {
+        log << "* " << nel::PROGRAM_NAME << ": failed to open '" << filename << "' for writing." << std::endl;
+        return false;
+    }
     
-    int result = yyparse();
-    if(result || nel::errorCount)
+    log << "* " << nel::PROGRAM_NAME << ": compilation complete." << std::endl;
+    return true;
+}
+
+bool writePackage(nel::CompilationContext& context, const std::string& filename)
+{
+    std::ostream& log = context.getLog();
+
+    log << "* saving package..." << std::endl;
+    try
+    {
+        nel::Statistics::PhaseTimer timer(context.getStatistics(), nel::Statistics::OUTPUT);
+        nel::TraceRecorder::Span span(context.getTraceRecorder(), "phase", "output");
+        nel::BlockStatement* block = context.getStartNode();
+        nel::SourceFile* source = context.getSourceFile(block->getSourcePosition()->getFile());
+        if(!nel::PrecompiledPackage::write(context, block, source->getBuffer()->getIdentity(), filename))
+        {
+            if(context.getErrorCount())
+            {
+                nel::failCompilation(context);
+            }
+            return false;
+        }
+    }
+    catch(const nel::FatalError&)
+    {
+        return false;
+    }
+    log << "* " << nel::PROGRAM_NAME << ": wrote to '" << filename << "'." << std::endl;
+    log << "* " << nel::PROGRAM_NAME << ": compilation complete." << std::endl;
+    return true;
+}
+
+/**
+ * Keeps a finished build in the cache, along with a precompiled package of every
+ * required file that can be one, so later builds that change something else can load them.
+ */
+void cacheBuild(nel::CompilationContext& context, const std::string& input, const std::string& output)
+{
+    nel::BuildCache* buildCache = context.getBuildCache();
+    buildCache->storeRom(context, input, output);
+
+    nel::SourceFile* sourceFile;
+    for(unsigned int i = 2; (sourceFile = context.getSourceFile(i)) != 0; i++)
+    {
+        const nel::FileIdentity& identity = sourceFile->getBuffer()->getIdentity();
+        if(buildCache->hasPackage(identity))
+        {
+            continue;
+        }
+
+        // Each file is compiled on its own, quietly, since most won't be packages.
+        std::ostringstream discard;
+        nel::CompilationContext package(discard);
+        package.setBuildCache(buildCache);
+        package.setMapSourceFiles(context.getMapSourceFiles());
+        package.setParseJobs(context.getParseJobs());
+        bool stored = false;
+        try
+        {
+            stored = compileFile(package, sourceFile->getFilename().c_str(), true)
+                && package.getSourceFile(1)->getBuffer()->getIdentity().matches(identity)
+                && buildCache->storePackage(package, identity);
+        }
+        catch(const nel::FatalError&)
+        {
+        }
+        if(!stored)
+        {
+            buildCache->storeNonPackage(identity);
+        }
+    }
+}
+
+/**
+ * How --time-passes reports are written, if at all.
+ */
+enum ReportFormat
+{
+    REPORT_NONE,
+    REPORT_TEXT,
+    REPORT_JSON
+};
+
+/**
+ * The settings from a command line that apply to every file it compiles.
+ */
+struct JobSettings
+{
+    // Whether files are compiled into precompiled packages, rather than ROMs.
+    bool precompilePackages;
+    // Whether source files are mapped into memory, rather than read through stdio.
+    bool mapSourceFiles;
+    // How many threads each compilation may parse its required files with, or 0 for one per core.
+    unsigned int parseJobs;
+    // Where finished builds are kept, or 0 if they aren't.
+    nel::BuildCache* buildCache;
+    // What files other than the source are read through, or 0 if they're read every time.
+    nel::FileCache* fileCache;
+
+    JobSettings()
+        : precompilePackages(false), mapSourceFiles(true), parseJobs(0), buildCache(0), fileCache(0)
+    {
+    }
+};
+
+/**
+ * What a compiler keeps in memory from one compilation to the next,
+ * for as long as it runs as a compile server or watches files.
+ */
+struct WarmCaches
+{
+    nel::FileCache files;
+    nel::BuildCache builds;
+
+    WarmCaches()
+        : builds("", &files)
+    {
+    }
+};
+
+/**
+ * A source file to compile, and where its ROM should go.
+ */
+struct Job
+{
+    std::string input;
+    std::string output;
+    // Only used when several jobs run at once, so their messages don't interleave.
+    std::ostringstream buffer;
+    // A JSON time report, if one was asked for.
+    std::ostringstream report;
+    // Trace events, if a trace was asked for.
+    std::ostringstream trace;
+    bool success;
+    unsigned int errorCount;
+    // Every file that went into the last compilation, so that --watch knows when to compile again.
+    std::vector<std::string> dependencies;
+    // Where to write those files as a makefile rule, or "" if nowhere.
+    std::string dependencyFile;
+
+    Job(const std::string& input)
+        : input(input), success(false), errorCount(0)
+    {
+    }
+
+    /**
+     * Forgets how the last compilation went, before compiling again.
+     */
+    void reset()
     {
-        std::cerr << "* " << nel::PROGRAM_NAME << ": failed compilation with " << nel::errorCount << " error(s)." << std::endl;
+        buffer.str("");
+        report.str("");
+        trace.str("");
+        success = false;
+        errorCount = 0;
+    }
+};
+
+// Escapes a filename for a makefile rule.
+static std::string escapeMakeFilename(const std::string& filename)
+{
+    std::string escaped;
+    for(size_t i = 0; i < filename.size(); i++)
+    {
+        switch(filename[i])
+        {
+            case ' ': case '\t': case '#': case ':':
+                escaped += '\\';
+                escaped += filename[i];
+                break;
+            case '$':
+                escaped += "$$";
+                break;
+            default:
+                escaped += filename[i];
+                break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Writes the files that went into a job's output as a makefile rule, like a C compiler's -MD -MP,
+ * with an empty rule for each so that make doesn't stop when one is deleted.
+ */
+bool writeDependencyFile(Job& job, std::ostream& log)
+{
+    std::vector<std::string> dependencies;
+    std::set<std::string> seen;
+    for(size_t i = 0; i < job.dependencies.size(); i++)
+    {
+        if(seen.insert(job.dependencies[i]).second)
+        {
+            dependencies.push_back(job.dependencies[i]);
+        }
+    }
+
+    std::ostringstream rule;
+    rule << escapeMakeFilename(job.output) << ":";
+    for(size_t i = 0; i < dependencies.size(); i++)
+    {
+        rule << " \\\n  " << escapeMakeFilename(dependencies[i]);
+    }
+    rule << "\n";
+    // The main file is the output's own prerequisite, so it doesn't get an empty rule.
+    for(size_t i = 0; i < dependencies.size(); i++)
+    {
+        if(dependencies[i] != job.input)
+        {
+            rule << "\n" << escapeMakeFilename(dependencies[i]) << ":\n";
+        }
+    }
+
+    std::ofstream file(job.dependencyFile.c_str(), std::ios::out | std::ios::binary);
+    if(!file.is_open())
+    {
+        log << "* " << nel::PROGRAM_NAME << ": failed to open '" << job.dependencyFile << "' for writing." << std::endl;
+        return false;
+    }
+    file << rule.str();
+    file.close();
+    log << "* " << nel::PROGRAM_NAME << ": wrote dependencies to '" << job.dependencyFile << "'." << std::endl;
+    return true;
+}
+
+void runJob(Job& job, unsigned int index, const JobSettings& settings, std::ostream& log, ReportFormat reportFormat, bool tracing)
+{
+    nel::CompilationContext context(log);
+    context.setFileCache(settings.fileCache);
+    context.setBuildCache(settings.buildCache);
+    context.setMapSourceFiles(settings.mapSourceFiles);
+    context.setParseJobs(settings.parseJobs);
+    if(reportFormat != REPORT_NONE)
+    {
+        context.setStatistics(new nel::Statistics(job.input));
+    }
+    if(tracing)
+    {
+        context.setTraceRecorder(new nel::TraceRecorder(index + 1, job.input));
+    }
+
+    // Every file that goes into the ROM, whether it's compiled or comes from the build cache.
+    std::vector<std::string> dependencies;
+    nel::BuildCache* buildCache = settings.buildCache;
+    if(settings.precompilePackages)
+    {
+        job.success = compileFile(context, job.input.c_str(), true) && writePackage(context, job.output);
+    }
+    else if(buildCache && buildCache->fetchRom(job.input, job.output, &dependencies))
+    {
+        log << "* " << nel::PROGRAM_NAME << ": found '" << job.input << "' in the cache." << std::endl;
+        log << "* " << nel::PROGRAM_NAME << ": wrote to '" << job.output << "'." << std::endl;
+        log << "* " << nel::PROGRAM_NAME << ": compilation complete." << std::endl;
+        job.success = true;
     }
     else
     {
-        bool success = aggregate() && validate() && generate();
-        if(success)
+        job.success = compileFile(context, job.input.c_str()) && writeRom(context, job.output);
+        if(job.success && buildCache)
         {
-            const char* const FILENAME = "out.nes";
-        
-            std::cerr << "* saving ROM..." << std::endl;
-            std::ofstream file(FILENAME, std::ios::out | std::ios::binary);
-            if(file.is_open())
+            cacheBuild(context, job.input, job.output);
+        }
+    }
+    job.errorCount = context.getErrorCount();
+
+    nel::SourceFile* sourceFile;
+    for(unsigned int i = 1; (sourceFile = context.getSourceFile(i)) != 0; i++)
+    {
+        dependencies.push_back(sourceFile->getFilename());
+    }
+    const std::vector<std::string>& embeddedFiles = context.getEmbeddedFiles();
+    dependencies.insert(dependencies.end(), embeddedFiles.begin(), embeddedFiles.end());
+    // A failed compilation may have stopped before reading everything that the last one did,
+    // like a required file that's gone missing, so those files are kept too.
+    if(!job.success)
+    {
+        dependencies.insert(dependencies.end(), job.dependencies.begin(), job.dependencies.end());
+    }
+    job.dependencies.swap(dependencies);
+
+    if(job.success && !job.dependencyFile.empty() && !writeDependencyFile(job, log))
+    {
+        job.success = false;
+    }
+
+    switch(reportFormat)
+    {
+        case REPORT_TEXT:
+            context.getStatistics()->printText(log);
+            break;
+        case REPORT_JSON:
+            context.getStatistics()->printJson(job.report);
+            break;
+    }
+
+    if(tracing)
+    {
+        bool first = true;
+        context.getTraceRecorder()->writeEvents(job.trace, first);
+    }
+}
+
+bool writeTrace(const std::vector<Job*>& jobs, const std::string& filename, std::ostream& err)
+{
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+    if(!file.is_open())
+    {
+        err << "* " << nel::PROGRAM_NAME << ": failed to open '" << filename << "' for writing." << std::endl;
+        return false;
+    }
+
+    file << "{\"traceEvents\":[" << std::endl;
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        file << (i ? ",\n" : "") << jobs[i]->trace.str();
+    }
+    file << std::endl << "]}" << std::endl;
+    file.close();
+
+    err << "* " << nel::PROGRAM_NAME << ": wrote trace to '" << filename << "'." << std::endl;
+    return true;
+}
+
+/**
+ * Compiles some jobs, and returns whether they all succeeded.
+ */
+bool runJobs(const std::vector<Job*>& jobs, unsigned int jobLimit, const JobSettings& settings, ReportFormat reportFormat,
+    const std::string& traceFilename, std::ostream& err, std::ostream& out)
+{
+    // A lone file reports as it goes.
+    if(jobs.size() == 1)
+    {
+        Job* job = jobs[0];
+        runJob(*job, 0, settings, err, reportFormat, !traceFilename.empty());
+        out << job->report.str();
+
+        bool success = job->success;
+        if(!traceFilename.empty() && !writeTrace(jobs, traceFilename, err))
+        {
+            success = false;
+        }
+        return success;
+    }
+
+    if(!jobLimit)
+    {
+        jobLimit = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobLimit = std::min<size_t>(jobLimit, jobs.size());
+
+    // Workers take the next job in line until none are left,
+    // and print each job's messages in one piece once it's done.
+    std::atomic<size_t> nextJob(0);
+    std::mutex printMutex;
+    std::vector<std::thread> workers;
+    for(unsigned int i = 0; i < jobLimit; i++)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            size_t index;
+            while((index = nextJob++) < jobs.size())
             {
-                nel::romGenerator->outputToStream(file);
-                std::cerr << "* " << nel::PROGRAM_NAME << ": wrote to '" << FILENAME << "'." << std::endl;
-                file.close();
+                Job& job = *jobs[index];
+                runJob(job, index, settings, job.buffer, reportFormat, !traceFilename.empty());
+
+                std::lock_guard<std::mutex> lock(printMutex);
+                err << "* " << nel::PROGRAM_NAME << ": [" << job.input << "]" << std::endl;
+                err << job.buffer.str();
+                out << job.report.str();
             }
-            else
+        }));
+    }
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+
+    size_t succeeded = 0;
+    err << "* " << nel::PROGRAM_NAME << ": summary" << std::endl;
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        Job* job = jobs[i];
+        if(job->success)
+        {
+            succeeded++;
+            err << "  ok:     " << job->input << " -> " << job->output << std::endl;
+        }
+        else
+        {
+            err << "  failed: " << job->input << " (" << job->errorCount << " error(s))" << std::endl;
+        }
+    }
+    err << "* " << nel::PROGRAM_NAME << ": " << succeeded << " of " << jobs.size() << " file(s) compiled"
+        << " using " << jobLimit << " job(s)." << std::endl;
+
+    bool success = succeeded == jobs.size();
+    if(!traceFilename.empty() && !writeTrace(jobs, traceFilename, err))
+    {
+        success = false;
+    }
+    return success;
+}
+
+/**
+ * Compiles jobs again whenever a file that went into them changes, for --watch.
+ * Unchanged embedded files and precompiled packages of unchanged required files
+ * stay in memory between compilations. Only returns if the files can't be watched.
+ */
+void watchJobs(const std::vector<Job*>& jobs, unsigned int jobLimit, const JobSettings& settings, ReportFormat reportFormat,
+    const std::string& traceFilename, std::ostream& err, std::ostream& out)
+{
+    nel::FileWatcher watcher;
+    for(;;)
+    {
+        // A source file that couldn't be opened is watched for, so that creating it is noticed.
+        std::set<std::string> files;
+        for(size_t i = 0; i < jobs.size(); i++)
+        {
+            files.insert(jobs[i]->input);
+            files.insert(jobs[i]->dependencies.begin(), jobs[i]->dependencies.end());
+        }
+        if(!watcher.watch(std::vector<std::string>(files.begin(), files.end())))
+        {
+            err << "* " << nel::PROGRAM_NAME << ": failed to watch for changes." << std::endl;
+            return;
+        }
+        err << "* " << nel::PROGRAM_NAME << ": watching " << files.size() << " file(s) for changes." << std::endl;
+
+        std::vector<std::string> changed = watcher.wait();
+        if(changed.empty())
+        {
+            err << "* " << nel::PROGRAM_NAME << ": failed to watch for changes." << std::endl;
+            return;
+        }
+        std::set<std::string> changedFiles(changed.begin(), changed.end());
+        for(size_t i = 0; i < changed.size(); i++)
+        {
+            err << "* " << nel::PROGRAM_NAME << ": '" << changed[i] << "' changed." << std::endl;
+        }
+
+        // Only the jobs that the changes went into are compiled again.
+        std::vector<Job*> affected;
+        for(size_t i = 0; i < jobs.size(); i++)
+        {
+            bool uses = changedFiles.count(jobs[i]->input) != 0;
+            for(size_t j = 0; j < jobs[i]->dependencies.size() && !uses; j++)
             {
-                std::cerr << "* " << nel::PROGRAM_NAME << ": failed to open '" << FILENAME << "' for writing." << std::endl;
-                exit(1);
+                uses = changedFiles.count(jobs[i]->dependencies[j]) != 0;
+            }
+            if(uses)
+            {
+                jobs[i]->reset();
+                affected.push_back(jobs[i]);
             }
-            
-            std::cerr << "* " << nel::PROGRAM_NAME << ": compilation complete." << std::endl;
+        }
+        runJobs(affected, jobLimit, settings, reportFormat, traceFilename, err, out);
+        out.flush();
+    }
+}
+
+/**
+ * Compiles the files named on a command line, writing messages to err and reports to out,
+ * and returns the exit status. A compile server runs this for each command line it's sent,
+ * with the caches it keeps for as long as it runs.
+ */
+int compileCommandLine(const std::vector<std::string>& args, std::ostream& err, std::ostream& out, WarmCaches* serverCaches = 0)
+{
+    std::vector<Job*> jobs;
+    unsigned int jobLimit = 0;
+    JobSettings settings;
+    ReportFormat reportFormat = REPORT_NONE;
+    std::string traceFilename;
+    std::string cacheDirectory;
+    bool watch = false;
+    bool writeDependencyFiles = false;
+
+    for(size_t i = 0; i < args.size(); i++)
+    {
+        const std::string& arg = args[i];
+        if(arg == "-j" || arg == "--jobs")
+        {
+            if(i + 1 >= args.size() || atoi(args[i + 1].c_str()) < 1)
+            {
+                printUsage(err, "expected a positive number of jobs after --jobs");
+                return 1;
+            }
+            jobLimit = atoi(args[++i].c_str());
+        }
+        else if(arg == "-o")
+        {
+            if(i + 1 >= args.size())
+            {
+                printUsage(err, "expected an output filename after -o");
+                return 1;
+            }
+            if(jobs.empty() || !jobs.back()->output.empty())
+            {
+                printUsage(err, "-o must follow the filename it names the output for");
+                return 1;
+            }
+            jobs.back()->output = args[++i];
+        }
+        else if(arg == "-MD")
+        {
+            writeDependencyFiles = true;
+        }
+        else if(arg == "-MF")
+        {
+            if(i + 1 >= args.size())
+            {
+                printUsage(err, "expected a dependency filename after -MF");
+                return 1;
+            }
+            if(jobs.empty() || !jobs.back()->dependencyFile.empty())
+            {
+                printUsage(err, "-MF must follow the filename it names the dependency file for");
+                return 1;
+            }
+            jobs.back()->dependencyFile = args[++i];
+        }
+        else if(arg == "--time-passes" || arg == "--time-passes=text")
+        {
+            reportFormat = REPORT_TEXT;
+        }
+        else if(arg == "--time-passes=json")
+        {
+            reportFormat = REPORT_JSON;
+        }
+        else if(arg == "--trace")
+        {
+            if(i + 1 >= args.size())
+            {
+                printUsage(err, "expected an output filename after --trace");
+                return 1;
+            }
+            traceFilename = args[++i];
+        }
+        else if(arg == "--parse-jobs")
+        {
+            if(i + 1 >= args.size() || atoi(args[i + 1].c_str()) < 1)
+            {
+                printUsage(err, "expected a positive number of jobs after --parse-jobs");
+                return 1;
+            }
+            settings.parseJobs = atoi(args[++i].c_str());
+        }
+        else if(arg == "--no-mmap")
+        {
+            settings.mapSourceFiles = false;
+        }
+        else if(arg == "--precompile")
+        {
+            settings.precompilePackages = true;
+        }
+        else if(arg == "--cache")
+        {
+            if(i + 1 >= args.size())
+            {
+                printUsage(err, "expected a directory after --cache");
+                return 1;
+            }
+            cacheDirectory = args[++i];
+        }
+        else if(arg == "--watch")
+        {
+            if(serverCaches)
+            {
+                printUsage(err, "a compile server can't watch files");
+                return 1;
+            }
+            watch = true;
+        }
+        else if(arg == "--serve" || arg == "--connect")
+        {
+            printUsage(err, std::string("`" + arg + "` must come before everything else").c_str());
+            return 1;
+        }
+        else if(arg.size() > 1 && arg[0] == '-')
+        {
+            printUsage(err, std::string("unrecognized option `" + arg + "`").c_str());
+            return 1;
         }
         else
         {
-            nel::failAndExit();
+            jobs.push_back(new Job(arg));
+        }
+    }
+
+    if(jobs.empty())
+    {
+        printUsage(err, "insufficient arguments");
+        return 1;
+    }
+
+    // Compilations running side by side would each parse with a thread per core,
+    // so they keep to one each unless told otherwise, and share the cores between them.
+    if(!settings.parseJobs && jobs.size() > 1 && jobLimit != 1)
+    {
+        settings.parseJobs = 1;
+    }
+
+    // Watching keeps what it can in memory between compilations, like a server does.
+    std::unique_ptr<WarmCaches> watchCaches(watch ? new WarmCaches() : 0);
+    WarmCaches* warmCaches = serverCaches ? serverCaches : watchCaches.get();
+    // Files are read rather than mapped by anything long-running, since one truncated by
+    // an editor while it's mapped would take the whole process down with SIGBUS.
+    if(warmCaches)
+    {
+        settings.mapSourceFiles = false;
+    }
+
+    // Builds are kept in the directory given, if any. Otherwise, a server or --watch keeps them in memory.
+    settings.fileCache = warmCaches ? &warmCaches->files : 0;
+    std::unique_ptr<nel::BuildCache> directoryCache(cacheDirectory.empty() ? 0 : new nel::BuildCache(cacheDirectory, settings.fileCache));
+    settings.buildCache = directoryCache ? directoryCache.get() : warmCaches ? &warmCaches->builds : 0;
+
+    // Packages are found next to their source, so that's where they go unless told otherwise.
+    if(settings.precompilePackages)
+    {
+        for(size_t i = 0; i < jobs.size(); i++)
+        {
+            if(jobs[i]->output.empty())
+            {
+                jobs[i]->output = nel::PrecompiledPackage::getFilename(jobs[i]->input);
+            }
+        }
+    }
+
+    // A lone file keeps the traditional output name. Several are named after their source.
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        if(jobs[i]->output.empty())
+        {
+            jobs[i]->output = jobs.size() == 1 ? "out.nes" : nel::replaceExtension(jobs[i]->input, ".nes");
+        }
+        // Like a C compiler's, dependency files go next to the output unless told otherwise.
+        if(writeDependencyFiles && jobs[i]->dependencyFile.empty())
+        {
+            jobs[i]->dependencyFile = nel::replaceExtension(jobs[i]->output, ".d");
         }
     }
 
-    return 0;
+    bool success = runJobs(jobs, jobLimit, settings, reportFormat, traceFilename, err, out);
+    if(watch)
+    {
+        // Only returns if the files can't be watched.
+        watchJobs(jobs, jobLimit, settings, reportFormat, traceFilename, err, out);
+        success = false;
+    }
+
+    for(size_t i = 0; i < jobs.size(); i++)
+    {
+        delete jobs[i];
+    }
+    return success ? 0 : 1;
 }
 
+// Programs that link in the compiler for their own purposes, like the microbenchmarks, supply their own main().
+#ifndef NEL_NO_MAIN
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if(!args.empty() && args[0] == "--serve")
+    {
+        if(args.size() != 2)
+        {
+            printUsage(std::cerr, "expected only a socket after --serve");
+            return 1;
+        }
+
+        // Everything the server keeps between command lines lives as long as it does.
+        WarmCaches caches;
+        nel::CompileServer::Handler handler = [&](const std::vector<std::string>& args, std::ostream& err, std::ostream& out)
+        {
+            return compileCommandLine(args, err, out, &caches);
+        };
+        return nel::CompileServer::serve(args[1], handler, std::cerr) ? 0 : 1;
+    }
+    if(!args.empty() && args[0] == "--connect")
+    {
+        if(args.size() < 2)
+        {
+            printUsage(std::cerr, "expected a socket after --connect");
+            return 1;
+        }
+
+        // Watching has to happen here, since the server only takes one command line at a time.
+        std::vector<std::string> forwarded(args.begin() + 2, args.end());
+        bool watching = std::find(forwarded.begin(), forwarded.end(), "--watch") != forwarded.end();
+        int status;
+        if(!watching && nel::CompileServer::forward(args[1], forwarded, std::cerr, std::cout, status))
+        {
+            return status;
+        }
+        return compileCommandLine(forwarded, std::cerr, std::cout);
+    }
+    return compileCommandLine(args, std::cerr, std::cout);
+}
+#endif
@@ -0,0 +1,678 @@
+// A hand-written scanner, built in place of the flex one with `make SCANNER=fast`.
+// It produces exactly the tokens that nel.l does, through the same yylex(),
+// but does less work for each one:
+// - identifiers are matched with a table of character classes, and keywords
+//   are picked out of them with a minimal perfect hash (see tools/keyhash.py).
+// - numbers are converted without strtol, by a loop with no branches but its own.
+// - whitespace and comments are skipped eight bytes at a time.
+// Source text is scanned where it lies, and never written to.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "y.tab.hpp"
+#include "../ast/source_buffer.h"
+
+const char* const SCANNER_NAME = "fast";
+
+/**
+ * Kinds of character, as bits in a character's class.
+ */
+enum CharacterClass
+{
+    IDENTIFIER_START = 1,   /**< Starts an identifier or keyword. */
+    IDENTIFIER_PART = 2,    /**< Continues an identifier or keyword. */
+    DECIMAL_DIGIT = 4,
+    HEX_DIGIT = 8,
+    BINARY_DIGIT = 16,
+    STRING_SPECIAL = 32,    /**< Interrupts a run of string literal content. */
+};
+
+/**
+ * The class of every character, along with the value of every digit.
+ */
+struct CharacterTable
+{
+    unsigned char classes[256];
+    unsigned char digitValues[256];
+
+    CharacterTable()
+    {
+        memset(classes, 0, sizeof(classes));
+        memset(digitValues, 0, sizeof(digitValues));
+        for(unsigned int c = 'a'; c <= 'z'; c++)
+        {
+            classes[c] |= IDENTIFIER_START | IDENTIFIER_PART;
+            classes[c - 'a' + 'A'] |= IDENTIFIER_START | IDENTIFIER_PART;
+        }
+        classes['_'] |= IDENTIFIER_START | IDENTIFIER_PART;
+        for(unsigned int c = '0'; c <= '9'; c++)
+        {
+            classes[c] |= IDENTIFIER_PART | DECIMAL_DIGIT | HEX_DIGIT;
+            digitValues[c] = c - '0';
+        }
+        for(unsigned int c = 'a'; c <= 'f'; c++)
+        {
+            classes[c] |= HEX_DIGIT;
+            classes[c - 'a' + 'A'] |= HEX_DIGIT;
+            digitValues[c] = digitValues[c - 'a' + 'A'] = c - 'a' + 10;
+        }
+        classes['0'] |= BINARY_DIGIT;
+        classes['1'] |= BINARY_DIGIT;
+
+        // The end of the buffer is a zero byte, so it interrupts strings too.
+        classes['\n'] |= STRING_SPECIAL;
+        classes['\''] |= STRING_SPECIAL;
+        classes['\"'] |= STRING_SPECIAL;
+        classes['\\'] |= STRING_SPECIAL;
+        classes[0] |= STRING_SPECIAL;
+    }
+};
+
+static const CharacterTable characters;
+
+/**
+ * A keyword, and the token it's scanned as.
+ */
+struct Keyword
+{
+    const char* text;
+    unsigned int length;
+    int token;
+};
+
+// Generated by tools/keyhash.py from the keywords in nel.l.
+static const unsigned int KEYWORD_COUNT = 46;
+static const unsigned int KEYWORD_BUCKET_BITS = 4;
+static const unsigned short keywordSeeds[1 << KEYWORD_BUCKET_BITS] = {
+    28, 24, 24, 14, 8, 12, 0, 3,
+    52, 299, 7, 5, 3, 6, 3, 597,
+};
+static const Keyword keywords[KEYWORD_COUNT] = {
+    {"set", 3, KW_SET},
+    {"get", 3, KW_GET},
+    {"def", 3, KW_DEF},
+    {"not", 3, KW_NOT},
+    {"is", 2, KW_IS},
+    {"rom", 3, KW_ROM},
+    {"signed", 6, KW_SIGNED},
+    {"inc", 3, KW_INC},
+    {"embed", 5, KW_EMBED},
+    {"word", 4, KW_WORD},
+    {"package", 7, KW_PACKAGE},
+    {"shl", 3, KW_SHL},
+    {"return", 6, KW_RETURN},
+    {"addc", 4, KW_ADDC},
+    {"begin", 5, KW_BEGIN},
+    {"ram", 3, KW_RAM},
+    {"nop", 3, KW_NOP},
+    {"unsigned", 8, KW_UNSIGNED},
+    {"dec", 3, KW_DEC},
+    {"bank", 4, KW_BANK},
+    {"neg", 3, KW_NEG},
+    {"bit", 3, KW_BIT},
+    {"unset", 5, KW_UNSET},
+    {"and", 3, KW_AND},
+    {"sub", 3, KW_SUB},
+    {"rol", 3, KW_ROL},
+    {"goto", 4, KW_GOTO},
+    {"rti", 3, KW_RTI},
+    {"require", 7, KW_REQUIRE},
+    {"pull", 4, KW_PULL},
+    {"subc", 4, KW_SUBC},
+    {"shr", 3, KW_SHR},
+    {"add", 3, KW_ADD},
+    {"var", 3, KW_VAR},
+    {"end", 3, KW_END},
+    {"call", 4, KW_CALL},
+    {"xor", 3, KW_XOR},
+    {"ines", 4, KW_INES},
+    {"put", 3, KW_PUT},
+    {"push", 4, KW_PUSH},
+    {"let", 3, KW_LET},
+    {"byte", 4, KW_BYTE},
+    {"or", 2, KW_OR},
+    {"when", 4, KW_WHEN},
+    {"compare", 7, KW_COMPARE},
+    {"ror", 3, KW_ROR},
+};
+
+// Keywords are between these lengths, so no other word needs hashing.
+static const unsigned int KEYWORD_MIN_LENGTH = 2;
+static const unsigned int KEYWORD_MAX_LENGTH = 8;
+
+/**
+ * Packs the parts of a word that tell the keywords apart: its length, first two letters and last letter.
+ */
+static inline unsigned int keywordKey(const char* text, unsigned int length)
+{
+    const unsigned char* p = (const unsigned char*) text;
+    return length << 24 | p[0] << 16 | p[1] << 8 | p[length - 1];
+}
+
+static inline unsigned int keywordMix(unsigned int key)
+{
+    key ^= key >> 16;
+    return key * 0x9E3779B1u;
+}
+
+/**
+ * Returns the token for a keyword, or 0 if the word isn't one.
+ */
+static inline int findKeyword(const char* text, unsigned int length)
+{
+    if(length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH)
+    {
+        return 0;
+    }
+
+    unsigned int key = keywordKey(text, length);
+    unsigned int seed = keywordSeeds[keywordMix(key) >> (32 - KEYWORD_BUCKET_BITS)];
+    const Keyword& keyword = keywords[((unsigned long long) keywordMix(key ^ seed) * KEYWORD_COUNT) >> 32];
+    return keyword.length == length && !memcmp(keyword.text, text, length) ? keyword.token : 0;
+}
+
+// Whitespace and comments are skipped a word at a time where the byte order allows it.
+// The buffer's padding makes it safe to read a word starting anywhere up to its end.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define NEL_SCANNER_SWAR
+#endif
+
+#ifdef NEL_SCANNER_SWAR
+typedef unsigned long long Word;
+
+static const Word LOW_BYTES = 0x0101010101010101ull;
+static const Word HIGH_BITS = 0x8080808080808080ull;
+static const Word LOW_BITS = 0x7F7F7F7F7F7F7F7Full;
+
+static_assert(nel::SourceBuffer::PADDING >= sizeof(Word), "the padding must hold a word read from the end of the text");
+
+static inline Word loadWord(const char* p)
+{
+    Word word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/**
+ * Returns a word with the high bit set in each byte where the given word has a zero byte, and nothing else.
+ */
+static inline Word zeroBytes(Word word)
+{
+    return ~(((word & LOW_BITS) + LOW_BITS) | word | LOW_BITS);
+}
+
+/**
+ * Returns a word with the high bit set in each byte where the given word has the given character, and nothing else.
+ */
+static inline Word matchBytes(Word word, unsigned char c)
+{
+    return zeroBytes(word ^ (LOW_BYTES * c));
+}
+
+/**
+ * Returns the position of the first byte flagged by a word from matchBytes().
+ */
+static inline const char* firstMatch(const char* p, Word matches)
+{
+    return p + (__builtin_ctzll(matches) >> 3);
+}
+#endif
+
+/**
+ * Returns the first character at or after p that isn't whitespace.
+ */
+static inline const char* skipWhitespace(const char* p)
+{
+#ifdef NEL_SCANNER_SWAR
+    for(;; p += sizeof(Word))
+    {
+        Word word = loadWord(p);
+        Word others = ~(matchBytes(word, ' ') | matchBytes(word, '\t') | matchBytes(word, '\n') | matchBytes(word, '\r')) & HIGH_BITS;
+        if(others)
+        {
+            return firstMatch(p, others);
+        }
+    }
+#else
+    while(*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+    {
+        p++;
+    }
+    return p;
+#endif
+}
+
+/**
+ * Returns the first occurrence of c or a zero byte at or after p.
+ */
+static inline const char* findCharacter(const char* p, char c)
+{
+#ifdef NEL_SCANNER_SWAR
+    for(;; p += sizeof(Word))
+    {
+        Word word = loadWord(p);
+        Word matches = matchBytes(word, c) | zeroBytes(word);
+        if(matches)
+        {
+            return firstMatch(p, matches);
+        }
+    }
+#else
+    while(*p != c && *p)
+    {
+        p++;
+    }
+    return p;
+#endif
+}
+
+/**
+ * Converts a run of digits into a number, reporting it if it's too large for a word.
+ * The loop doesn't branch on anything but its end; overflow is collected and checked afterwards.
+ */
+static unsigned int convertNumber(nel::ParserContext& parser, const char* start, const char* end, unsigned int radix)
+{
+    unsigned int value = 0;
+    unsigned int overflow = 0;
+    for(const char* p = start; p != end; p++)
+    {
+        value = value * radix + characters.digitValues[(unsigned char) *p];
+        overflow |= value >> 16;
+        value &= nel::Expression::MAX_VALUE;
+    }
+
+    if(overflow)
+    {
+        numberOutOfRange(parser, std::string(start, end - start));
+        return 0;
+    }
+    return value;
+}
+
+/**
+ * The start conditions that nel.l uses, each scanned by a function of its own.
+ */
+enum ScannerState
+{
+    STATE_INITIAL,
+    STATE_MULTI_COMMENT,
+    STATE_STRING_LITERAL,
+};
+
+/**
+ * Some text being scanned, along with how far the scanner has gotten.
+ */
+struct ScannerBuffer
+{
+    const char* start;
+    const char* cursor;
+    const char* end;
+};
+
+/**
+ * The state of a lexer made by createLexer(). Everything else about the parse is in its context.
+ */
+struct Scanner
+{
+    nel::ParserContext* parser;
+    // The text of every file being scanned, with the innermost require on top.
+    std::vector<ScannerBuffer> buffers;
+    ScannerState state;
+};
+
+/**
+ * Moves the buffer on to p, and sets the current position there.
+ * Like flex's YY_USER_ACTION in nel.l, positions are where the last token ended.
+ */
+static inline void advance(Scanner& scanner, ScannerBuffer& buffer, const char* p)
+{
+    buffer.cursor = p;
+    scanner.parser->getCurrentPosition()->setOffset((unsigned int) (p - buffer.start));
+}
+
+/**
+ * Scans a token outside of comments and strings.
+ * Returns 0 if the buffer ran out, or the scanner entered another state.
+ */
+static int scanToken(Scanner& scanner, ScannerBuffer& buffer, YYSTYPE* value)
+{
+    nel::ParserContext* parser = scanner.parser;
+    const char* p = buffer.cursor;
+    for(;;)
+    {
+        p = skipWhitespace(p);
+
+        unsigned char c = *p;
+        unsigned char classes = characters.classes[c];
+        if(classes & IDENTIFIER_START)
+        {
+            const char* q = p + 1;
+            while(characters.classes[(unsigned char) *q] & IDENTIFIER_PART)
+            {
+                q++;
+            }
+            advance(scanner, buffer, q);
+
+            if(int token = findKeyword(p, (unsigned int) (q - p)))
+            {
+                return token;
+            }
+            *value = new nel::StringNode(nel::SymbolPool::intern(std::string(p, q - p)), NEL_GET_SOURCE_POS);
+            return IDENTIFIER;
+        }
+        if(classes & DECIMAL_DIGIT)
+        {
+            // Same as nel.l: 0x and 0b only count as prefixes when a digit follows.
+            unsigned int radix = 10;
+            const char* digits = p;
+            unsigned char digitClass = DECIMAL_DIGIT;
+            if(c == '0' && p[1] == 'x' && (characters.classes[(unsigned char) p[2]] & HEX_DIGIT))
+            {
+                radix = 16;
+                digits = p + 2;
+                digitClass = HEX_DIGIT;
+            }
+            else if(c == '0' && p[1] == 'b' && (characters.classes[(unsigned char) p[2]] & BINARY_DIGIT))
+            {
+                radix = 2;
+                digits = p + 2;
+                digitClass = BINARY_DIGIT;
+            }
+
+            const char* q = digits;
+            while(characters.classes[(unsigned char) *q] & digitClass)
+            {
+                q++;
+            }
+            advance(scanner, buffer, q);
+            *value = new nel::NumberNode(convertNumber(*parser, digits, q, radix), NEL_GET_SOURCE_POS);
+            return NUMBER;
+        }
+
+        const char* next = p + 1;
+        int token = INVALID_CHAR;
+        switch(c)
+        {
+            case 0:
+                if(p == buffer.end)
+                {
+                    advance(scanner, buffer, p);
+                    return 0;
+                }
+                break;
+            case '/':
+                if(p[1] == '/')
+                {
+                    // Comments run to the end of the line, past any zero bytes that aren't the end of the buffer.
+                    p = findCharacter(p + 2, '\n');
+                    while(!*p && p != buffer.end)
+                    {
+                        p = findCharacter(p + 1, '\n');
+                    }
+                    continue;
+                }
+                if(p[1] == '*')
+                {
+                    advance(scanner, buffer, p + 2);
+                    scanner.state = STATE_MULTI_COMMENT;
+                    return 0;
+                }
+                token = OP_DIV;
+                break;
+            case '\'':
+            case '\"':
+                advance(scanner, buffer, next);
+                parser->getStringTerminator() = c;
+                parser->getStringContent() = "";
+                scanner.state = STATE_STRING_LITERAL;
+                return 0;
+            case '=':
+                if(p[1] == '=')
+                {
+                    next++;
+                    token = PUNC_EQ;
+                }
+                else
+                {
+                    token = PUNC_SET;
+                }
+                break;
+            case '!':
+                if(p[1] == '=')
+                {
+                    next++;
+                    token = PUNC_NEQ;
+                }
+                else
+                {
+                    token = PUNC_EXCLAIM;
+                }
+                break;
+            case '<':
+                if(p[1] == '<')
+                {
+                    next++;
+                    token = OP_SHL;
+                }
+                else if(p[1] == '=')
+                {
+                    next++;
+                    token = PUNC_LE;
+                }
+                else
+                {
+                    token = PUNC_LT;
+                }
+                break;
+            case '>':
+                if(p[1] == '>')
+                {
+                    next++;
+                    token = OP_SHR;
+                }
+                else if(p[1] == '=')
+                {
+                    next++;
+                    token = PUNC_GE;
+                }
+                else
+                {
+                    token = PUNC_GT;
+                }
+                break;
+            case ':': token = PUNC_COLON; break;
+            case ',': token = PUNC_COMMA; break;
+            case '.': token = PUNC_DOT; break;
+            case ';': token = PUNC_SEMI; break;
+            case '#': token = PUNC_HASH; break;
+            case '@': token = PUNC_AT; break;
+            case '[': token = PUNC_LBRACKET; break;
+            case ']': token = PUNC_RBRACKET; break;
+            case '(': token = PUNC_LPAREN; break;
+            case ')': token = PUNC_RPAREN; break;
+            case '{': token = PUNC_LBRACE; break;
+            case '}': token = PUNC_RBRACE; break;
+            case '+': token = OP_ADD; break;
+            case '-': token = OP_SUB; break;
+            case '*': token = OP_MUL; break;
+            case '%': token = OP_MOD; break;
+            case '&': token = OP_AND; break;
+            case '^': token = OP_XOR; break;
+            case '|': token = OP_OR; break;
+        }
+        advance(scanner, buffer, next);
+        return token;
+    }
+}
+
+/**
+ * Skips the rest of a multi-line comment, or as much of it as the buffer holds.
+ */
+static void scanComment(Scanner& scanner, ScannerBuffer& buffer)
+{
+    const char* p = buffer.cursor;
+    for(;;)
+    {
+        p = findCharacter(p, '*');
+        if(*p == '*')
+        {
+            if(p[1] == '/')
+            {
+                advance(scanner, buffer, p + 2);
+                scanner.state = STATE_INITIAL;
+                return;
+            }
+        }
+        else if(p == buffer.end)
+        {
+            advance(scanner, buffer, p);
+            return;
+        }
+        p++;
+    }
+}
+
+/**
+ * Scans the rest of a string literal, collecting its content in the parser context.
+ * Returns 0 if the buffer ran out first.
+ */
+static int scanString(Scanner& scanner, ScannerBuffer& buffer, YYSTYPE* value)
+{
+    nel::ParserContext* parser = scanner.parser;
+    std::string& content = parser->getStringContent();
+    const char* p = buffer.cursor;
+    for(;;)
+    {
+        const char* run = p;
+        while(!(characters.classes[(unsigned char) *p] & STRING_SPECIAL))
+        {
+            p++;
+        }
+        content.append(run, p - run);
+
+        switch(*p)
+        {
+            case 0:
+                if(p == buffer.end)
+                {
+                    advance(scanner, buffer, p);
+                    return 0;
+                }
+                content += *p++;
+                break;
+            case '\n':
+                // The literal stays open, just as it does in nel.l.
+                advance(scanner, buffer, p + 1);
+                return UNTERMINATED_STRING;
+            case '\'':
+            case '\"':
+                if(*p != parser->getStringTerminator())
+                {
+                    content += *p++;
+                    break;
+                }
+
+                advance(scanner, buffer, p + 1);
+                scanner.state = STATE_INITIAL;
+                if(content.size() == 1)
+                {
+                    *value = new nel::NumberNode((unsigned int) content[0], NEL_GET_SOURCE_POS);
+                    return NUMBER;
+                }
+                *value = new nel::StringNode(content, NEL_GET_SOURCE_POS);
+                return STRING;
+            case '\\':
+                if(p[1] == '\n' || p + 1 == buffer.end)
+                {
+                    // Nothing in nel.l matches a backslash here, so it's skipped.
+                    p++;
+                    break;
+                }
+
+                p += 2;
+                switch(p[-1])
+                {
+                    case 'n': content += '\n'; break;
+                    case 'r': content += '\r'; break;
+                    case '0': content += '\0'; break;
+                    case 't': content += '\t'; break;
+                    case 'b': content += '\b'; break;
+                    case 'f': content += '\f'; break;
+                    case 'v': content += '\v'; break;
+                    case 'a': content += '\a'; break;
+                    case '\\': content += '\\'; break;
+                    case '\"': content += '\"'; break;
+                    case '\'': content += '\''; break;
+                    default:
+                        advance(scanner, buffer, p);
+                        yyerror(parser, "Invalid escape sequence in string.");
+                        break;
+                }
+                break;
+        }
+    }
+}
+
+extern "C" int yylex(YYSTYPE* value, void* handle)
+{
+    Scanner& scanner = *(Scanner*) handle;
+    std::vector<ScannerBuffer>& buffers = scanner.buffers;
+    while(!buffers.empty())
+    {
+        ScannerBuffer& buffer = buffers.back();
+        int token = 0;
+        switch(scanner.state)
+        {
+            case STATE_INITIAL:
+                token = scanToken(scanner, buffer, value);
+                break;
+            case STATE_MULTI_COMMENT:
+                scanComment(scanner, buffer);
+                break;
+            case STATE_STRING_LITERAL:
+                token = scanString(scanner, buffer, value);
+                break;
+        }
+        if(token)
+        {
+            return token;
+        }
+
+        if(buffer.cursor == buffer.end)
+        {
+            // Like nel.l's <<EOF>> rule, which leaves the state as it was.
+            buffers.pop_back();
+            if(!buffers.empty() && !popInputFile(*scanner.parser))
+            {
+                yyerror(scanner.parser, "internal: include stack underflow");
+            }
+        }
+    }
+    return 0;
+}
+
+void pushLexerBuffer(nel::ParserContext& parser, char* data, size_t size)
+{
+    ScannerBuffer buffer;
+    buffer.start = data;
+    buffer.cursor = data;
+    buffer.end = data + size;
+    ((Scanner*) parser.getScanner())->buffers.push_back(buffer);
+}
+
+void createLexer(nel::ParserContext& parser)
+{
+    Scanner* scanner = new Scanner();
+    scanner->parser = &parser;
+    scanner->state = STATE_INITIAL;
+    parser.setScanner(scanner);
+}
+
+void destroyLexer(nel::ParserContext& parser)
+{
+    delete (Scanner*) parser.getScanner();
+    parser.setScanner(0);
+}
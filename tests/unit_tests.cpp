@@ -0,0 +1,182 @@
+// Unit tests for the parts of the compiler that are hard to reach from a program.
+// Each test reports what it expected when it fails, and the process fails
+// if any of them did.
+//
+// Built by `make unit-test`, with the parser compiled without its main(),
+// and run as part of `make test`. Optionally takes some text that the names
+// of the tests to run must contain.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <set>
+#include <utility>
+
+#include "../ast/file_identity.h"
+#include "../ast/lru_map.h"
+
+namespace
+{
+    unsigned int failures = 0;
+
+    void check(bool condition, const char* test, const std::string& message)
+    {
+        if(!condition)
+        {
+            failures++;
+            std::printf("FAILED: %s\n  %s\n", test, message.c_str());
+        }
+    }
+
+    std::string toHex(const nel::FileIdentity::Hash& hash)
+    {
+        char buffer[33];
+        std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", hash.high, hash.low);
+        return buffer;
+    }
+
+    // The hash is SipHash-2-4 with 128 bits of output under the key 00 01 .. 0F,
+    // so it has to agree with the reference test vectors, whose message is 00 01 02 ...
+    void testHashMatchesReferenceVectors()
+    {
+        const char* test = "hash matches reference vectors";
+        char message[64];
+        for(unsigned int i = 0; i < sizeof(message); i++)
+        {
+            message[i] = (char) i;
+        }
+
+        struct Vector
+        {
+            size_t size;
+            const char* expected;
+        };
+        // The expected bytes, written as the high half then the low half of the hash.
+        const Vector vectors[] = {
+            {0, "930255c71472f66de6a825ba047f81a3"},
+            {1, "45fc229b1159763444af996bd8c187da"},
+        };
+        for(unsigned int i = 0; i < sizeof(vectors) / sizeof(*vectors); i++)
+        {
+            std::string actual = toHex(nel::FileIdentity::hashText(message, vectors[i].size));
+            check(actual == vectors[i].expected, test,
+                "the hash of " + std::to_string(vectors[i].size) + " byte(s) was " + actual + ", not " + vectors[i].expected);
+        }
+    }
+
+    // Every byte has to reach every bit of the hash, whatever its offset in a word.
+    // Changing three bytes the same distance from the start of a word, to every combination
+    // of sixteen values each, has to give a different hash every time.
+    void testHashChangesWithEveryByte()
+    {
+        const char* test = "hash changes with every byte";
+        std::string base;
+        // Not a whole number of words, so the last one is partial.
+        for(unsigned int i = 0; i < 61; i++)
+        {
+            base += (char) ('a' + i % 26);
+        }
+
+        for(unsigned int offset = 0; offset < 8; offset++)
+        {
+            std::set<std::pair<unsigned long long, unsigned long long> > hashes;
+            std::string text = base;
+            for(unsigned int a = 0; a < 16; a++)
+            {
+                for(unsigned int b = 0; b < 16; b++)
+                {
+                    for(unsigned int c = 0; c < 16; c++)
+                    {
+                        text[offset] = (char) (a * 17);
+                        text[offset + 8] = (char) (b * 17);
+                        text[offset + 16] = (char) (c * 17);
+                        nel::FileIdentity::Hash hash = nel::FileIdentity::hashText(text.data(), text.size());
+                        hashes.insert(std::make_pair(hash.low, hash.high));
+                    }
+                }
+            }
+            check(hashes.size() == 16 * 16 * 16, test,
+                "changing bytes " + std::to_string(offset) + ", " + std::to_string(offset + 8) + " and " + std::to_string(offset + 16)
+                + " gave " + std::to_string(hashes.size()) + " different hashes of 4096");
+
+            // A single byte, at every offset into the trailing partial word too.
+            for(unsigned int position = offset; position < text.size(); position += 8)
+            {
+                std::string changed = base;
+                changed[position] ^= 1;
+                check(nel::FileIdentity::hashText(changed.data(), changed.size())
+                    != nel::FileIdentity::hashText(base.data(), base.size()), test,
+                    "flipping a bit of byte " + std::to_string(position) + " didn't change the hash");
+            }
+        }
+    }
+
+    void testIdentityMatchesByText()
+    {
+        const char* test = "identity matches by text";
+        nel::FileIdentity first, second, third;
+        first.setText("byte: 1\n", 8);
+        second.setText("byte: 1\n", 8);
+        third.setText("byte: 2\n", 8);
+        check(first.matches(second), test, "two files with the same text should match");
+        check(!first.matches(third), test, "two files of the same size with different text shouldn't match");
+        check(!nel::FileIdentity().matches(nel::FileIdentity()), test, "an identity without a file or text shouldn't match anything");
+    }
+
+    void testLruMapDropsTheLeastRecentlyUsed()
+    {
+        const char* test = "lru map drops the least recently used";
+        nel::LruMap<int> map(10);
+        map.put("a", 1, 4);
+        map.put("b", 2, 4);
+        check(map.find("a") && *map.find("a") == 1, test, "a should be found");
+        // b is the least recently used now, so it goes to make room.
+        map.put("c", 3, 4);
+        check(!map.find("b"), test, "b should have been dropped");
+        check(map.find("a") && map.find("c"), test, "a and c should be kept");
+        check(map.getTotal() == 8, test, "8 bytes should be held, not " + std::to_string(map.getTotal()));
+
+        // Putting a name again replaces its value and cost.
+        map.put("a", 4, 2);
+        check(*map.find("a") == 4 && map.size() == 2 && map.getTotal() == 6, test, "a should be replaced");
+
+        // Something bigger than the limit is still kept, on its own.
+        map.put("d", 5, 20);
+        check(map.size() == 1 && map.find("d"), test, "only d should be kept");
+    }
+
+    struct Test
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    const Test tests[] = {
+        {"hash matches reference vectors", testHashMatchesReferenceVectors},
+        {"hash changes with every byte", testHashChangesWithEveryByte},
+        {"identity matches by text", testIdentityMatchesByText},
+        {"lru map drops the least recently used", testLruMapDropsTheLeastRecentlyUsed},
+    };
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < sizeof(tests) / sizeof(*tests); i++)
+    {
+        if(std::strstr(tests[i].name, filter))
+        {
+            unsigned int before = failures;
+            tests[i].run();
+            if(failures == before)
+            {
+                std::printf("ok:     %s\n", tests[i].name);
+            }
+            count++;
+        }
+    }
+
+    std::printf("%u test(s) run, %u failure(s)\n", count, failures);
+    return failures ? 1 : 0;
+}
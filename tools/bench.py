@@ -0,0 +1,103 @@
+#!/bin/env python
+
+# Runs the compiler over synthetic programs of increasing size (see gennel.py),
+# and reports the time spent in each phase along with peak memory use.
+#
+# Usage: bench.py [--nel path/to/nel] [--work directory] [--output results.json] [--quick]
+#
+# Each scenario scales a single feature of the program, so nonlinear growth
+# in any one phase shows up as its time outpacing the size column.
+
+import os
+import sys
+import json
+import time
+import subprocess
+import optparse
+
+import gennel
+
+SCENARIOS = [
+    ('labels', 'labels', [1000, 10000, 100000], {}),
+    ('packages', 'package_depth', [10, 25, 50], {}),
+    ('constant chains', 'chains', [100, 1000, 10000], {}),
+    ('byte data (KB)', 'data_kb', [64, 512, 2048], {}),
+    ('requires', 'requires', [10, 100, 1000], {'labels': 20}),
+]
+
+PHASES = ['parse', 'aggregate', 'resolve', 'validate', 'generate', 'output']
+
+class Options:
+    def __init__(self, **settings):
+        self.labels = 0
+        self.package_depth = 0
+        self.chains = 0
+        self.chain_depth = 15
+        self.data_kb = 0
+        self.requires = 0
+        for key, value in settings.items():
+            setattr(self, key, value)
+
+def run(nel, directory):
+    # Run the compiler on its own, so its resource usage can be told apart from ours.
+    output = os.path.join(directory, 'out.nes')
+    command = [nel, '--time-passes=json', os.path.join(directory, 'main.nel'), '-o', output]
+    start = time.time()
+    process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    stdout = process.stdout.read()
+    stderr = process.stderr.read()
+    pid, status, usage = os.wait4(process.pid, 0)
+    elapsed = time.time() - start
+
+    if status != 0:
+        sys.stderr.write(stderr.decode('utf-8', 'replace'))
+        sys.exit('benchmark failed: ' + ' '.join(command))
+
+    report = json.loads(stdout.decode('utf-8').strip().splitlines()[-1])
+    # ru_maxrss is in kilobytes on Linux, but bytes on macOS.
+    peak = usage.ru_maxrss * (1 if sys.platform == 'darwin' else 1024)
+    return report, elapsed, peak
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = optparse.OptionParser(usage='usage: %prog [options]')
+    parser.add_option('--nel', default=os.path.join(here, '..', 'nel'), help='compiler to benchmark')
+    parser.add_option('--work', default='bench_work', help='directory for generated programs')
+    parser.add_option('--output', help='also write the results to this JSON file')
+    parser.add_option('--quick', action='store_true', help='only run the smallest size of each scenario')
+    options, args = parser.parse_args()
+
+    results = []
+    header = '%-16s %8s' % ('scenario', 'size') + ''.join('%11s' % phase for phase in PHASES) + '%11s %10s' % ('total', 'peak MB')
+    print(header)
+    print('-' * len(header))
+
+    for title, setting, sizes, extra in SCENARIOS:
+        for size in (sizes[:1] if options.quick else sizes):
+            settings = dict(extra)
+            for key in settings:
+                settings[key] *= size
+            settings[setting] = size
+
+            directory = os.path.join(options.work, '%s_%d' % (setting, size))
+            gennel.generate(Options(**settings), directory)
+            report, elapsed, peak = run(options.nel, directory)
+
+            times = [report['phases'].get(phase, {}).get('wall_ms', 0) for phase in PHASES]
+            print('%-16s %8d' % (title, size) + ''.join('%11.1f' % t for t in times) + '%11.1f %10.1f' % (sum(times), peak / 1048576.0))
+            sys.stdout.flush()
+
+            results.append({
+                'scenario': setting,
+                'size': size,
+                'elapsed_ms': elapsed * 1000,
+                'peak_rss_bytes': peak,
+                'report': report,
+            })
+
+    if options.output:
+        with open(options.output, 'w') as f:
+            json.dump(results, f, indent=2)
+
+if __name__ == '__main__':
+    main()
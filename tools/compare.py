@@ -0,0 +1,85 @@
+#!/bin/env python
+
+# Compiles the same programs with two builds of the compiler, and checks that
+# they agree: the same exit status, the same messages, and the same ROM byte for byte.
+# `make scanner-check` uses this to compare a build of each scanner.
+#
+# Usage: compare.py [--work directory] first/nel second/nel [program.nel ...]
+#
+# Compares the demo and package test programs, and a generated program using
+# every feature of gennel.py, along with any programs given.
+
+import os
+import sys
+import shutil
+import subprocess
+import optparse
+
+import gennel
+
+class Options:
+    def __init__(self, **settings):
+        self.labels = 0
+        self.package_depth = 0
+        self.chains = 0
+        self.chain_depth = 15
+        self.data_kb = 0
+        self.requires = 0
+        for key, value in settings.items():
+            setattr(self, key, value)
+
+def run(nel, program, output):
+    # Both compilers write to the same output, so their messages name the same file.
+    if os.path.exists(output):
+        os.remove(output)
+    process = subprocess.Popen([nel, program, '-o', output], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    stdout, stderr = process.communicate()
+    rom = None
+    if os.path.exists(output):
+        with open(output, 'rb') as f:
+            rom = f.read()
+    return process.returncode, stderr + stdout, rom
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = optparse.OptionParser(usage='usage: %prog [options] first/nel second/nel [program.nel ...]')
+    parser.add_option('--work', default='compare_work', help='directory for generated programs and output')
+    options, args = parser.parse_args()
+    if len(args) < 2:
+        parser.error('expected two compilers to compare')
+
+    if os.path.exists(options.work):
+        shutil.rmtree(options.work)
+    generated = os.path.join(options.work, 'generated')
+    gennel.generate(Options(labels=2000, package_depth=10, chains=200, data_kb=16, requires=8), generated)
+
+    programs = [
+        os.path.join(here, '..', 'tests', 'demo', 'test.nel'),
+        os.path.join(here, '..', 'tests', 'package', 'package.nel'),
+        os.path.join(generated, 'main.nel'),
+    ] + args[2:]
+    output = os.path.join(options.work, 'out.nes')
+
+    failures = 0
+    for program in programs:
+        first = run(args[0], program, output)
+        second = run(args[1], program, output)
+        problems = []
+        if first[0] != second[0]:
+            problems.append('exit status %d vs %d' % (first[0], second[0]))
+        if first[1] != second[1]:
+            problems.append('different messages')
+        if first[2] != second[2]:
+            problems.append('different ROMs')
+
+        if problems:
+            failures += 1
+            print('differ: %s (%s)' % (program, ', '.join(problems)))
+        else:
+            print('same:   %s (exit status %d, %d byte ROM)' % (program, first[0], len(first[2] or b'')))
+
+    if failures:
+        sys.exit('%d of %d program(s) differ' % (failures, len(programs)))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,147 @@
+#!/bin/env python
+
+# Generates synthetic nel programs for benchmarking the compiler at scale.
+#
+# Each feature can be scaled on its own:
+#   --labels N          N labels, each followed by a nop, with gotos back to earlier ones.
+#   --package-depth N   packages nested N deep, referenced by fully-qualified names.
+#   --chains N          N chains of constants, each defined in terms of the one before.
+#   --chain-depth N     length of each constant chain (at most 15, the compiler's expansion limit).
+#   --data-kb N         N kilobytes of `byte:` data.
+#   --requires N        spread the labels and constants over N required files.
+#
+# Writes main.nel (and any required files) into the output directory.
+# The generated program always compiles without errors.
+
+import os
+import sys
+import optparse
+
+BANK_SIZE = 8192
+# Leave room in each bank for the odd goto.
+BANK_BUDGET = BANK_SIZE - 256
+
+class Writer:
+    def __init__(self, directory):
+        self.directory = directory
+        self.bank = -1
+        self.used = BANK_BUDGET
+        self.files = []
+
+    def open(self, name):
+        f = open(os.path.join(self.directory, name), 'w')
+        self.files.append(f)
+        return f
+
+    def reserve(self, f, size):
+        # Move on to the next bank when the current one fills up.
+        if self.used + size > BANK_BUDGET:
+            self.bank += 1
+            self.used = 0
+            f.write('rom bank %d, 0x8000:\n' % self.bank)
+        self.used += size
+
+    def close(self):
+        for f in self.files:
+            f.close()
+
+def write_labels(writer, f, prefix, count):
+    for i in range(count):
+        writer.reserve(f, 4)
+        f.write('    def %s_%d:\n' % (prefix, i))
+        f.write('        nop\n')
+        if i % 16 == 15:
+            f.write('        goto %s_%d\n' % (prefix, i - 15))
+
+def write_chains(writer, f, prefix, count, depth):
+    for c in range(count):
+        f.write('    let %s_%d_0 = %d\n' % (prefix, c, c & 0xFF))
+        for d in range(1, depth):
+            f.write('    let %s_%d_%d = %s_%d_%d + 1\n' % (prefix, c, d, prefix, c, d - 1))
+    # Use the end of every chain, so each one is folded all the way down.
+    for c in range(count):
+        writer.reserve(f, 2)
+        f.write('    a: get #%s_%d_%d & 0xFF\n' % (prefix, c, depth - 1))
+
+def write_packages(writer, f, depth):
+    if depth <= 0:
+        return
+    for d in range(depth):
+        f.write('    ' * (d + 1) + 'package P%d\n' % d)
+        f.write('    ' * (d + 2) + 'let c = %d\n' % d)
+    for d in reversed(range(depth)):
+        f.write('    ' * (d + 1) + 'end\n')
+    for d in range(depth):
+        writer.reserve(f, 2)
+        path = '.'.join('P%d' % i for i in range(d + 1))
+        f.write('    a: get #%s.c\n' % path)
+
+def write_data(writer, f, kilobytes):
+    PER_LINE = 16
+    remaining = kilobytes * 1024
+    value = 0
+    while remaining > 0:
+        count = min(PER_LINE, remaining)
+        writer.reserve(f, count)
+        values = []
+        for i in range(count):
+            values.append(str(value & 0xFF))
+            value += 1
+        f.write('    byte: ' + ', '.join(values) + '\n')
+        remaining -= count
+
+def estimate_banks(options):
+    size = options.labels * 4 + (options.labels // 16) * 3
+    size += options.chains * 2 + options.package_depth * 2 + options.data_kb * 1024
+    return size // BANK_BUDGET + options.requires + 2
+
+def generate(options, directory):
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+
+    writer = Writer(directory)
+    main = writer.open('main.nel')
+
+    # Each 16K prg unit holds two 8K banks.
+    prg = min(255, (estimate_banks(options) + 1) // 2)
+    main.write('// Generated by tools/gennel.py\n')
+    main.write('ines:\n    mapper = 4,\n    prg = %d,\n    chr = 1\n\n' % prg)
+    main.write('ram 0x00:\n    var scratch : byte\n\n')
+
+    parts = max(1, options.requires)
+    for part in range(parts):
+        if options.requires:
+            name = 'req_%d.nel' % part
+            f = writer.open(name)
+            # The required file carries on in whichever bank is active, and switches banks itself.
+            main.write('require \'%s\'\n' % name)
+        else:
+            f = main
+        write_labels(writer, f, 'l%d' % part, options.labels // parts)
+        write_chains(writer, f, 'k%d' % part, options.chains // parts, options.chain_depth)
+
+    write_packages(writer, main, options.package_depth)
+    write_data(writer, main, options.data_kb)
+
+    if writer.bank < 0:
+        writer.reserve(main, 0)
+    writer.close()
+
+    if writer.bank + 1 > prg * 2:
+        sys.exit('generated program needs %d banks, more than the %d estimated.' % (writer.bank + 1, prg * 2))
+
+if __name__ == '__main__':
+    parser = optparse.OptionParser(usage='usage: %prog [options] output_directory')
+    parser.add_option('--labels', type='int', default=0)
+    parser.add_option('--package-depth', type='int', default=0)
+    parser.add_option('--chains', type='int', default=0)
+    parser.add_option('--chain-depth', type='int', default=15)
+    parser.add_option('--data-kb', type='int', default=0)
+    parser.add_option('--requires', type='int', default=0)
+    options, args = parser.parse_args()
+
+    if len(args) != 1:
+        parser.error('expected an output directory')
+    if options.chain_depth < 1 or options.chain_depth > 15:
+        parser.error('--chain-depth must be in 1..15')
+    generate(options, args[0])
@@ -0,0 +1,79 @@
+#!/bin/env python
+
+# Generates the minimal perfect hash that grammar/scanner.cpp uses to recognize keywords.
+#
+# Reads the keyword rules from grammar/nel.l, so both scanners know the same keywords,
+# and prints the C++ tables to paste between the markers in scanner.cpp.
+#
+# Each word is reduced to a key made of its length, first two letters and last letter.
+# The key picks one of a few buckets, and each bucket has a seed, chosen here, which
+# sends the keys in that bucket to distinct slots not taken by any other bucket.
+# The hash functions must match keywordKey(), keywordMix() and findKeyword() in scanner.cpp.
+
+import os
+import re
+import sys
+
+BUCKET_BITS = 4
+
+def key(word):
+    return (len(word) << 24) | (ord(word[0]) << 16) | (ord(word[1]) << 8) | ord(word[-1])
+
+def mix(x):
+    x = (x ^ (x >> 16)) & 0xFFFFFFFF
+    return (x * 0x9E3779B1) & 0xFFFFFFFF
+
+def slot(x, count):
+    return (mix(x) * count) >> 32
+
+def read_keywords(filename):
+    with open(filename) as f:
+        return re.findall(r'^"([a-z_]+)"\s+return\s+(KW_\w+);', f.read(), re.M)
+
+def generate(keywords):
+    count = len(keywords)
+    keys = [key(word) for word, token in keywords]
+    if len(set(keys)) != count:
+        sys.exit('two keywords share a key, so the hash needs to look at more of each word.')
+
+    buckets = [[] for i in range(1 << BUCKET_BITS)]
+    for keyword in keywords:
+        buckets[mix(key(keyword[0])) >> (32 - BUCKET_BITS)].append(keyword)
+
+    # Place the fullest buckets first, while there's the most room.
+    slots = [None] * count
+    seeds = [0] * len(buckets)
+    for bucket in sorted(range(len(buckets)), key=lambda b: -len(buckets[b])):
+        seed = 0
+        while True:
+            taken = [slot(key(word) ^ seed, count) for word, token in buckets[bucket]]
+            if len(set(taken)) == len(taken) and all(slots[s] is None for s in taken):
+                break
+            seed += 1
+        seeds[bucket] = seed
+        for s, keyword in zip(taken, buckets[bucket]):
+            slots[s] = keyword
+
+    if max(seeds) > 0xFFFF:
+        sys.exit('a seed doesn\'t fit in 16 bits, so try more buckets.')
+    return seeds, slots
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    keywords = read_keywords(os.path.join(here, '..', 'grammar', 'nel.l'))
+    seeds, slots = generate(keywords)
+
+    print('// Generated by tools/keyhash.py from the keywords in nel.l.')
+    print('static const unsigned int KEYWORD_COUNT = %d;' % len(slots))
+    print('static const unsigned int KEYWORD_BUCKET_BITS = %d;' % BUCKET_BITS)
+    print('static const unsigned short keywordSeeds[1 << KEYWORD_BUCKET_BITS] = {')
+    for i in range(0, len(seeds), 8):
+        print('    ' + ', '.join('%d' % seed for seed in seeds[i:i + 8]) + ',')
+    print('};')
+    print('static const Keyword keywords[KEYWORD_COUNT] = {')
+    for word, token in slots:
+        print('    {"%s", %d, %s},' % (word, len(word), token))
+    print('};')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,451 @@
+#!/bin/env python
+
+# End-to-end tests of the compiler. Each test writes a small program into a
+# directory of its own, compiles it, and checks the ROM and messages it gets.
+#
+# Usage: test.py [--nel path/to/nel] [--work directory] [name ...]
+#
+# Runs every test, or only those whose names contain one of the names given.
+# The directories are kept in the work directory, so failures can be inspected.
+
+import os
+import sys
+import json
+import time
+import socket
+import shutil
+import subprocess
+import optparse
+
+# Every ROM starts with a 16-byte iNES header, then its first bank.
+HEADER_SIZE = 16
+# What the unused space in a bank is filled with.
+FILL = 0xFF
+
+HEADER = '''ines:
+    mapper = 0,
+    prg = 1,
+    chr = 1
+
+'''
+
+class TestFailure(Exception):
+    pass
+
+class Test:
+    '''The directory a test works in, and the compiler it runs.'''
+
+    def __init__(self, nel, directory):
+        self.nel = nel
+        self.directory = directory
+
+    def path(self, name):
+        return os.path.join(self.directory, name)
+
+    def write(self, name, text):
+        filename = self.path(name)
+        if not os.path.isdir(os.path.dirname(filename)):
+            os.makedirs(os.path.dirname(filename))
+        with open(filename, 'w') as f:
+            f.write(text)
+
+    def read(self, name):
+        with open(self.path(name), 'rb') as f:
+            return f.read()
+
+    def compile(self, *args):
+        '''Runs the compiler in the test's directory, and returns its exit status and messages.'''
+        process = subprocess.Popen([self.nel] + list(args), cwd=self.directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        output = process.communicate()[0].decode('utf-8', 'replace')
+        return process.returncode, output
+
+    def compile_ok(self, *args):
+        status, output = self.compile(*args)
+        if status != 0:
+            raise TestFailure('expected %s to compile, but it failed:\n%s' % (' '.join(args), output))
+        return output
+
+    def rom_bytes(self, name, count):
+        '''Returns the first bytes of a ROM's first bank.'''
+        return bytearray(self.read(name)[HEADER_SIZE:HEADER_SIZE + count])
+
+def check(condition, message):
+    if not condition:
+        raise TestFailure(message)
+
+def check_bytes(actual, expected, what):
+    check(actual == bytearray(expected), '%s: expected %s, got %s' % (what,
+        ' '.join('%02X' % b for b in expected), ' '.join('%02X' % b for b in actual)))
+
+# code generation
+
+def test_commands_need_a_bank(t):
+    t.write('main.nel', HEADER + 'a: get #1\n')
+    status, output = t.compile('main.nel')
+    check(status != 0, 'expected commands outside of a bank not to compile')
+    check('command statement found, but a rom bank hasn\'t been selected yet' in output, 'expected an error about the bank:\n%s' % output)
+
+def test_commands_go_in_the_bank_selected_before_them(t):
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    a: get #1, put @0x10\n'
+        '    x: inc\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 6), [0xA9, 0x01, 0x85, 0x10, 0xE8, FILL], 'the commands')
+
+# require once
+
+def test_require_once_skips_the_same_path(t):
+    t.write('lib/shared.nel', '    byte: 0x42, 0x43\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    byte: 0x44\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 4), [0x42, 0x43, 0x44, FILL], 'the shared file should go in once')
+
+def test_require_once_skips_another_path_to_the_same_file(t):
+    t.write('lib/shared.nel', '    byte: 0x42, 0x43\n')
+    t.write('other/nested.nel', '    require once \'../lib/shared.nel\'\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    require once \'other/../lib/shared.nel\'\n'
+        '    require once \'./lib/shared.nel\'\n'
+        '    require \'other/nested.nel\'\n'
+        '    byte: 0x44\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 4), [0x42, 0x43, 0x44, FILL], 'the shared file should go in once')
+
+def test_require_once_skips_a_symlink_to_the_same_file(t):
+    if not hasattr(os, 'symlink'):
+        return
+    t.write('lib/shared.nel', '    byte: 0x42, 0x43\n')
+    os.symlink(os.path.join('lib', 'shared.nel'), t.path('link.nel'))
+    os.symlink('lib', t.path('linked_lib'))
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'link.nel\'\n'
+        '    require once \'linked_lib/shared.nel\'\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    byte: 0x44\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 4), [0x42, 0x43, 0x44, FILL], 'the shared file should go in once')
+
+def test_require_once_skips_a_copy_with_the_same_text(t):
+    t.write('lib/shared.nel', '    byte: 0x42, 0x43\n')
+    t.write('vendor/shared.nel', '    byte: 0x42, 0x43\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    require once \'vendor/shared.nel\'\n'
+        '    byte: 0x44\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 4), [0x42, 0x43, 0x44, FILL], 'the copy should be skipped')
+
+def test_require_once_keeps_a_different_file(t):
+    t.write('lib/shared.nel', '    byte: 0x42, 0x43\n')
+    t.write('lib/almost.nel', '    byte: 0x42, 0x45\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    require once \'lib/almost.nel\'\n'
+        '    byte: 0x44\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 6), [0x42, 0x43, 0x42, 0x45, 0x44, FILL], 'both files should go in')
+
+def test_require_without_once_always_splices(t):
+    t.write('lib/shared.nel', '    byte: 0x42\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'lib/shared.nel\'\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    require \'lib/shared.nel\'\n')
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 3), [0x42, 0x42, FILL], 'only the require once should be skipped')
+
+# parallel parsing
+
+# Two jobs has one thread parse every required file in turn, into the same arena, while four spread them out.
+# Either way they're parsed ahead of the program, however many cores there are.
+PARSE_JOBS = ['2', '4']
+
+def check_same_with_one_parse_job(t, *args):
+    '''Compiles main.nel with one parse job and then more, and checks that the ROMs and messages are always the same.
+    Returns the exit status, messages and ROM of the compile with one job.'''
+    results = []
+    for jobs in ['1'] + PARSE_JOBS:
+        if os.path.exists(t.path('out.nes')):
+            os.remove(t.path('out.nes'))
+        status, output = t.compile('main.nel', '--parse-jobs', jobs, *args)
+        rom = t.read('out.nes') if os.path.exists(t.path('out.nes')) else None
+        results.append((jobs, status, output, rom))
+
+    one = results[0]
+    for jobs, status, output, rom in results[1:]:
+        check(status == one[1], 'expected the same exit status, got %d with one job and %d with %s' % (one[1], status, jobs))
+        check(output == one[2], 'expected the same messages, got:\n%s\nwith one job, and:\n%s\nwith %s' % (one[2], output, jobs))
+        check(rom == one[3], 'expected the same ROM with %s jobs as with one' % jobs)
+    return one[1:]
+
+def test_parse_jobs_splice_nested_require_once_chains(t):
+    # The big file keeps a thread busy parsing while the chain before it is spliced together.
+    t.write('y.nel', '    require once \'z.nel\'\n    byte: 0x42\n')
+    t.write('z.nel', '    byte: 0x41\n')
+    t.write('q.nel', ''.join('    let q%d = %d\n' % (i, i % 256) for i in range(30000)) + '    byte: 0x43\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require once \'y.nel\'\n'
+        '    require once \'q.nel\'\n'
+        '    byte: q29999\n')
+    status, output, rom = check_same_with_one_parse_job(t)
+    check(status == 0, 'expected the program to compile:\n%s' % output)
+    check_bytes(bytearray(rom[HEADER_SIZE:HEADER_SIZE + 5]), [0x41, 0x42, 0x43, 29999 % 256, FILL], 'the chain and the big file')
+
+def test_parse_jobs_splice_several_requires(t):
+    t.write('a.nel', '    byte: 0x41\n    require \'lib/b.nel\'\n    byte: 0x43\n')
+    t.write('lib/b.nel', '    byte: 0x42\n    require once \'c.nel\'\n')
+    t.write('lib/c.nel', '    byte: 0x44\n')
+    t.write('d.nel', '    require once \'lib/c.nel\'\n    byte: 0x45\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'a.nel\'\n'
+        '    require once \'d.nel\'\n'
+        '    require \'a.nel\'\n'
+        '    byte: 0x46\n')
+    status, output, rom = check_same_with_one_parse_job(t)
+    check(status == 0, 'expected the program to compile:\n%s' % output)
+    check_bytes(bytearray(rom[HEADER_SIZE:HEADER_SIZE + 10]), [0x41, 0x42, 0x44, 0x43, 0x45, 0x41, 0x42, 0x43, 0x46, FILL],
+        'every file, with the one required once only the first time')
+
+def test_parse_jobs_look_up_builtins_in_required_files(t):
+    # Each file is parsed on a thread of its own, and they all look up a and x as they go.
+    for name in ['a.nel', 'b.nel', 'c.nel']:
+        t.write(name, '    x: get a, inc\n' * 1000)
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'a.nel\'\n'
+        '    require \'b.nel\'\n'
+        '    require \'c.nel\'\n')
+    status, output, rom = check_same_with_one_parse_job(t)
+    check(status == 0, 'expected the program to compile:\n%s' % output)
+    check_bytes(bytearray(rom[HEADER_SIZE:HEADER_SIZE + 5]), [0xAA, 0xE8, 0xAA, 0xE8, 0xAA], 'the first commands')
+    check_bytes(bytearray(rom[HEADER_SIZE + 6000:HEADER_SIZE + 6001]), [FILL], 'the end of the commands')
+
+def test_parse_jobs_report_errors_in_required_files_in_order(t):
+    t.write('a.nel', '    byte: 0x41\n    byte: )\n')
+    t.write('lib/b.nel', '    require once \'c.nel\'\n    byte: 0x42 +\n')
+    t.write('lib/c.nel', '    byte: (\n')
+    t.write('d.nel', '    require \'missing.nel\'\n    x: get undefined\n')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'a.nel\'\n'
+        '    require once \'lib/b.nel\'\n'
+        '    require \'d.nel\'\n'
+        '    byte: ]\n')
+    status, output, rom = check_same_with_one_parse_job(t)
+    check(status != 0, 'expected the program not to compile')
+    for name in ['a.nel', 'b.nel', 'c.nel', 'd.nel', 'main.nel']:
+        check(name in output, 'expected an error in %s:\n%s' % (name, output))
+
+# precompiled packages
+
+CONSTANTS = 'package Colors\n    let red = 0x16\nend\nlet count = 3\n'
+USES_CONSTANTS = HEADER + 'rom bank 0, 0xC000:\n    require \'consts.nel\'\n    byte: Colors.red, count\n'
+
+def tokens_lexed(output):
+    '''Returns how many tokens --time-passes=json says were lexed.'''
+    for line in output.splitlines():
+        if line.startswith('{'):
+            return json.loads(line)['counters']['tokens_lexed']
+    raise TestFailure('expected a json report of the passes:\n%s' % output)
+
+def test_precompiled_package_builds_the_same_rom(t):
+    t.write('consts.nel', CONSTANTS)
+    t.write('main.nel', USES_CONSTANTS)
+    parsed = tokens_lexed(t.compile_ok('main.nel', '--time-passes=json'))
+    rom = t.read('out.nes')
+
+    t.compile_ok('--precompile', 'consts.nel')
+    check(os.path.exists(t.path('consts.nelpkg')), 'expected consts.nelpkg to be written')
+    loaded = tokens_lexed(t.compile_ok('main.nel', '--time-passes=json'))
+    check(loaded < parsed, 'expected the package to be loaded rather than consts.nel parsed (%d vs %d tokens)' % (loaded, parsed))
+    check(t.read('out.nes') == rom, 'expected the same ROM with the package as without it')
+
+def test_precompiled_package_is_ignored_once_its_source_changes(t):
+    t.write('consts.nel', CONSTANTS)
+    t.write('main.nel', USES_CONSTANTS)
+    t.compile_ok('--precompile', 'consts.nel')
+
+    # The same size, so only the text tells them apart.
+    t.write('consts.nel', CONSTANTS.replace('0x16', '0x17'))
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 2), [0x17, 0x03], 'a package of the old text should be ignored')
+
+    t.write('consts.nel', CONSTANTS.replace('0x16', '0x1234 & 0xFF'))
+    t.compile_ok('main.nel')
+    check_bytes(t.rom_bytes('out.nes', 2), [0x34, 0x03], 'a package of the old text should be ignored')
+
+# build cache
+
+def found_in_cache(output):
+    return 'in the cache' in output
+
+def test_build_cache_hits_when_nothing_changed(t):
+    t.write('consts.nel', CONSTANTS)
+    t.write('main.nel', USES_CONSTANTS)
+    check(not found_in_cache(t.compile_ok('main.nel', '--cache', 'cache')), 'expected the first build to miss the cache')
+    rom = t.read('out.nes')
+    os.remove(t.path('out.nes'))
+    check(found_in_cache(t.compile_ok('main.nel', '--cache', 'cache')), 'expected the second build to hit the cache')
+    check(t.read('out.nes') == rom, 'expected the ROM from the cache to be the same')
+
+def test_build_cache_misses_when_a_file_changes(t):
+    t.write('consts.nel', CONSTANTS)
+    t.write('main.nel', USES_CONSTANTS)
+    t.compile_ok('main.nel', '--cache', 'cache')
+
+    # The same size, so only the text tells them apart.
+    for name, old, new, expected in [
+            ('consts.nel', '0x16', '0x17', [0x17, 0x03]),
+            ('consts.nel', '= 3', '= 4', [0x17, 0x04]),
+            ('main.nel', 'Colors.red, count', 'count, Colors.red', [0x04, 0x17])]:
+        t.write(name, t.read(name).decode('utf-8').replace(old, new))
+        check(not found_in_cache(t.compile_ok('main.nel', '--cache', 'cache')), 'expected a build after changing %s to miss the cache' % name)
+        check_bytes(t.rom_bytes('out.nes', 2), expected, 'the ROM after changing %s' % name)
+
+def test_build_cache_misses_when_an_embedded_file_changes(t):
+    t.write('data.bin', 'AB')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n    embed \'data.bin\'\n')
+    t.compile_ok('main.nel', '--cache', 'cache')
+    t.write('data.bin', 'AC')
+    check(not found_in_cache(t.compile_ok('main.nel', '--cache', 'cache')), 'expected a build after changing data.bin to miss the cache')
+    check_bytes(t.rom_bytes('out.nes', 3), [0x41, 0x43, FILL], 'the ROM after changing data.bin')
+
+def start_server(t):
+    '''Starts a compile server listening on server.sock in the test's directory.'''
+    server = subprocess.Popen([t.nel, '--serve', 'server.sock'], cwd=t.directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    for i in range(100):
+        if os.path.exists(t.path('server.sock')):
+            break
+        time.sleep(0.05)
+    return server
+
+def test_compile_server_sees_an_edit_of_the_same_size(t):
+    if not hasattr(socket, 'AF_UNIX'):
+        return
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n    byte: 0x42\n')
+    server = start_server(t)
+    try:
+        # Edited straight after each build, with its time kept to the second as some
+        # file systems do, so the file's size and time may not change at all.
+        for value in [0x42, 0x43, 0x44]:
+            t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n    byte: 0x%02X\n' % value)
+            now = int(time.time())
+            os.utime(t.path('main.nel'), (now, now))
+            t.compile_ok('--connect', 'server.sock', 'main.nel')
+            check_bytes(t.rom_bytes('out.nes', 2), [value, FILL], 'the ROM from the server')
+    finally:
+        server.kill()
+        server.wait()
+
+def test_compile_server_drops_a_silent_client(t):
+    if not hasattr(socket, 'AF_UNIX'):
+        return
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n    byte: 0x42\n')
+    server = start_server(t)
+    silent = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        # Connects and sends nothing, which mustn't hold up everybody after it for good.
+        silent.connect(t.path('server.sock'))
+        start = time.time()
+        t.compile_ok('--connect', 'server.sock', 'main.nel')
+        check_bytes(t.rom_bytes('out.nes', 2), [0x42, FILL], 'the ROM from the server')
+        check(time.time() - start < 30, 'expected the silent client to be dropped')
+    finally:
+        silent.close()
+        server.kill()
+        server.wait()
+
+# dependency files
+
+def find_program(name):
+    for directory in os.environ.get('PATH', '').split(os.pathsep):
+        if os.path.isfile(os.path.join(directory, name)):
+            return os.path.join(directory, name)
+    return None
+
+def run_make(t):
+    '''Runs make in the test's directory, and returns what its recipes printed.'''
+    process = subprocess.Popen(['make', '-s'], cwd=t.directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output = process.communicate()[0].decode('utf-8', 'replace')
+    check(process.returncode == 0, 'expected make to succeed:\n%s' % output)
+    return output
+
+def test_depfile_lists_every_file_that_went_in(t):
+    t.write('lib/shared.nel', '    byte: 0x42\n')
+    t.write('data.bin', 'AB')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'lib/shared.nel\'\n'
+        '    require once \'lib/shared.nel\'\n'
+        '    embed \'data.bin\'\n')
+    t.compile_ok('main.nel', '-MD')
+    expected = ('out.nes: \\\n  main.nel \\\n  lib/shared.nel \\\n  data.bin\n'
+        '\nlib/shared.nel:\n'
+        '\ndata.bin:\n')
+    actual = t.read('out.d').decode('utf-8')
+    check(actual == expected, 'expected out.d to be:\n%s\nbut it was:\n%s' % (expected, actual))
+
+def test_depfile_escapes_names_for_make(t):
+    t.write('my lib/a $x.nel', '    byte: 0x42\n')
+    t.write('data#1.bin', 'AB')
+    t.write('main.nel', HEADER + 'rom bank 0, 0xC000:\n'
+        '    require \'my lib/a $x.nel\'\n'
+        '    embed \'data#1.bin\'\n')
+    t.compile_ok('main.nel', '-o', 'my rom.nes', '-MF', 'my rom.d')
+    expected = ('my\\ rom.nes: \\\n  main.nel \\\n  my\\ lib/a\\ $$x.nel \\\n  data\\#1.bin\n'
+        '\nmy\\ lib/a\\ $$x.nel:\n'
+        '\ndata\\#1.bin:\n')
+    actual = t.read('my rom.d').decode('utf-8')
+    check(actual == expected, 'expected my rom.d to be:\n%s\nbut it was:\n%s' % (expected, actual))
+
+    # And make reads the names back as they were.
+    if not find_program('make'):
+        return
+    t.write('Makefile', 'include my\\ rom.d\nmy\\ rom.nes:\n\t@echo remake\n')
+    names = ['main.nel', 'my lib/a $x.nel', 'data#1.bin']
+    for name in names:
+        older = time.time() - 7200
+        for each in names:
+            os.utime(t.path(each), (older, older))
+        os.utime(t.path('my rom.nes'), (older + 3600, older + 3600))
+        check(run_make(t) == '', 'expected the ROM to be up to date')
+        os.utime(t.path(name), None)
+        check(run_make(t) == 'remake\n', 'expected the ROM to be out of date once %s is newer' % name)
+    # Deleting a file that went in doesn't stop make, thanks to its empty rule.
+    os.remove(t.path('data#1.bin'))
+    check(run_make(t) == 'remake\n', 'expected the ROM to be out of date once data#1.bin is gone')
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = optparse.OptionParser(usage='usage: %prog [options] [name ...]')
+    parser.add_option('--nel', default=os.path.join(here, '..', 'nel'), help='compiler to test')
+    parser.add_option('--work', default='test_work', help='directory for the tests to work in')
+    options, args = parser.parse_args()
+    nel = os.path.abspath(options.nel)
+
+    tests = sorted((name, test) for name, test in globals().items() if name.startswith('test_') and callable(test))
+    if args:
+        tests = [(name, test) for name, test in tests if any(arg in name for arg in args)]
+
+    if os.path.exists(options.work):
+        shutil.rmtree(options.work)
+
+    failures = 0
+    for name, test in tests:
+        directory = os.path.abspath(os.path.join(options.work, name[len('test_'):]))
+        os.makedirs(directory)
+        try:
+            test(Test(nel, directory))
+            print('ok:     %s' % name)
+        except TestFailure as failure:
+            failures += 1
+            print('FAILED: %s\n  %s' % (name, str(failure).replace('\n', '\n  ')))
+        sys.stdout.flush()
+
+    print('%d of %d test(s) passed' % (len(tests) - failures, len(tests)))
+    if failures:
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()